@@ -2,7 +2,9 @@
 #define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_LOCAL_PLANNER_INCLUDE_COLLISION_CHECKER_COLLISION_CHECKER_HPP_
 #include "reference_line/reference_line.hpp"
 #include "ros/ros.h"
+#include <atomic>
 #include "polygon/box2d.hpp"
+#include "collision_checker/obstacle_occupancy.hpp"
 #include <planning_msgs/Trajectory.h>
 #include "obstacle_manager/st_graph.hpp"
 #include "thread_pool/thread_pool.hpp"
@@ -27,6 +29,7 @@ class CollisionChecker {
    * @param delta_t: the delta t to check collision along trajectory
    * @param vehicle_params: ego vehicle's params
    * @param thread_pool: the thread pool, to accelerate the calculation
+   * @param parallel_min_points: trajectories with fewer points are checked on the calling thread only
    */
   CollisionChecker(const std::unordered_map<int, std::shared_ptr<Obstacle>> &obstacles,
                    const ReferenceLine &ref_line,
@@ -38,7 +41,27 @@ class CollisionChecker {
                    double lookahead_time,
                    double delta_t,
                    const vehicle_state::VehicleParams &vehicle_params,
-                   common::ThreadPool *thread_pool);
+                   common::ThreadPool *thread_pool,
+                   size_t parallel_min_points = 200);
+
+  /**
+   * @param obstacle_occupancy: the buffered obstacle boxes of this planning cycle, shared read-only
+   * @param ref_line: the reference line
+   * @param ptr_st_graph: the st graph to check
+   * @param ego_vehicle_s: ego vehicle stational state
+   * @param ego_vehicle_d: ego vehicle lateral state
+   * @param vehicle_params: ego vehicle's params
+   * @param thread_pool: the thread pool, to accelerate the calculation
+   * @param parallel_min_points: trajectories with fewer points are checked on the calling thread only
+   */
+  CollisionChecker(std::shared_ptr<const ObstacleOccupancy> obstacle_occupancy,
+                   const ReferenceLine &ref_line,
+                   std::shared_ptr<STGraph> ptr_st_graph,
+                   double ego_vehicle_s,
+                   double ego_vehicle_d,
+                   const vehicle_state::VehicleParams &vehicle_params,
+                   common::ThreadPool *thread_pool,
+                   size_t parallel_min_points = 200);
   /**
    * @brief: check ego vehicle is collision with obstacles
    * @param: trajectory: ego vehicle's trajectory
@@ -55,14 +78,33 @@ class CollisionChecker {
 
  private:
   /**
-   *
-   * @param obstacles
+   * @brief: check the trajectory points in [begin, end)
+   * @param trajectory: ego vehicle's trajectory
+   * @param begin: the first point to check
+   * @param end: one past the last point to check
+   * @param stop: stop early and return false once it's set, e.g. a collision found by another chunk, nullable
+   * @return: true if collision with a certain obstacle, false otherwise
+   */
+  bool IsCollision(const planning_msgs::Trajectory &trajectory,
+                   size_t begin,
+                   size_t end,
+                   const std::atomic<bool> *stop) const;
+
+  /**
+   * @brief: select the obstacles of the occupancy to check on this reference line
    * @param ego_vehicle_s
    * @param ego_vehicle_d
    * @param reference_line
    */
-  void Init(const std::unordered_map<int, std::shared_ptr<planning::Obstacle>> &obstacles, double ego_vehicle_s,
-            double ego_vehicle_d, const ReferenceLine &reference_line);
+  void Init(double ego_vehicle_s, double ego_vehicle_d, const ReferenceLine &reference_line);
+
+  /**
+   * @brief: the obstacles ordered by id, so the occupancy does not depend on the hash order
+   * @param obstacles
+   * @return
+   */
+  static std::vector<std::shared_ptr<Obstacle>> SortedObstacles(
+      const std::unordered_map<int, std::shared_ptr<Obstacle>> &obstacles);
 
   /**
    *
@@ -84,8 +126,12 @@ class CollisionChecker {
  private:
   ReferenceLine ref_line_;
   std::shared_ptr<STGraph> ptr_st_graph_;
-  std::vector<std::vector<common::Box2d>> predicted_obstacle_box_;
+  std::shared_ptr<const ObstacleOccupancy> obstacle_occupancy_;
+  // considered_obstacles_[k] for obstacle_occupancy_->obstacles()[k]
+  std::vector<bool> considered_obstacles_;
   common::ThreadPool *thread_pool_ = nullptr;
+  // a planned trajectory of 81 points takes about 17 us serially, less than the dispatch to the pool costs
+  size_t parallel_min_points_ = 200;
   vehicle_state::VehicleParams vehicle_params_{};
   double lon_buffer_{};
   double lat_buffer_{};
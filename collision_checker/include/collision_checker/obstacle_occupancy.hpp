@@ -0,0 +1,90 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COLLISION_CHECKER_INCLUDE_COLLISION_CHECKER_OBSTACLE_OCCUPANCY_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COLLISION_CHECKER_INCLUDE_COLLISION_CHECKER_OBSTACLE_OCCUPANCY_HPP_
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "polygon/box2d_grid.hpp"
+#include "collision_checker/occupancy_bitmap.hpp"
+#include "obstacle_manager/obstacle.hpp"
+
+namespace planning {
+
+/**
+ * @brief: the predicted boxes of the obstacles at 0, delta_t, 2 * delta_t ..., extended by the lon and lat
+ * safety buffers. built once per planning cycle, then shared read-only by the collision checkers of every
+ * reference line and every candidate trajectory.
+ */
+class ObstacleOccupancy {
+ public:
+  ObstacleOccupancy() = default;
+  ~ObstacleOccupancy() = default;
+
+  /**
+   * @param obstacles: the key obstacles
+   * @param lon_buffer: the safety buffer in lon direction
+   * @param lat_buffer: the safety buffer in lat direction
+   * @param lookahead_time: the max lookahead time, horizon
+   * @param delta_t: the time resolution
+   */
+  ObstacleOccupancy(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
+                    double lon_buffer,
+                    double lat_buffer,
+                    double lookahead_time,
+                    double delta_t);
+
+  size_t NumTimeSteps() const { return time_step_grids_.size(); }
+
+  size_t NumObstacles() const { return obstacles_.size(); }
+
+  const std::vector<std::shared_ptr<Obstacle>> &obstacles() const { return obstacles_; }
+
+  /**
+   * @brief: the buffered boxes at time_index * delta_t, box k of the grid belongs to obstacles()[k]
+   * @param time_index
+   * @return
+   */
+  const common::Box2dGrid &TimeStepGrid(size_t time_index) const { return time_step_grids_[time_index]; }
+
+  /**
+   * @brief: find the index of an obstacle in obstacles()
+   * @param id: obstacle id
+   * @param[out] index
+   * @return false if the obstacle is not in the occupancy
+   */
+  bool FindObstacleIndex(int id, size_t *index) const;
+
+  /**
+   * @brief: rasterize the boxes into an (x, y, t) bitmap, the collision checkers use it to skip the
+   * box checks of the ego boxes far from every obstacle. must be built before the occupancy is shared
+   * @param ego_length: the ego box length
+   * @param ego_width: the ego box width
+   * @param resolution: the cell size
+   */
+  void BuildBitmap(double ego_length, double ego_width, double resolution);
+
+  bool HasBitmap() const { return has_bitmap_; }
+
+  const OccupancyBitmap &bitmap() const { return bitmap_; }
+
+  double lon_buffer() const { return lon_buffer_; }
+
+  double lat_buffer() const { return lat_buffer_; }
+
+  double lookahead_time() const { return lookahead_time_; }
+
+  double delta_t() const { return delta_t_; }
+
+ private:
+  std::vector<std::shared_ptr<Obstacle>> obstacles_;
+  std::unordered_map<int, size_t> obstacle_indices_;
+  std::vector<common::Box2dGrid> time_step_grids_;
+  bool has_bitmap_ = false;
+  OccupancyBitmap bitmap_;
+  double lon_buffer_ = 0.0;
+  double lat_buffer_ = 0.0;
+  double lookahead_time_ = 0.0;
+  double delta_t_ = 0.1;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COLLISION_CHECKER_INCLUDE_COLLISION_CHECKER_OBSTACLE_OCCUPANCY_HPP_
@@ -0,0 +1,75 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COLLISION_CHECKER_INCLUDE_COLLISION_CHECKER_OCCUPANCY_BITMAP_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COLLISION_CHECKER_INCLUDE_COLLISION_CHECKER_OCCUPANCY_BITMAP_HPP_
+#include <cstdint>
+#include <vector>
+#include "polygon/box2d_grid.hpp"
+
+namespace planning {
+
+/**
+ * @brief: (x, y, t) bit grid of the obstacle footprints, one layer per time step. the ego box is covered by
+ * a few disks along its heading, a cell is set if a disk centered in it may touch an obstacle box, i.e. the
+ * footprints are inflated by the disk radius, a bit more than the ego half width. a clear bit under every
+ * disk center proves the ego box is collision free, a set bit needs the exact box check.
+ */
+class OccupancyBitmap {
+ public:
+  OccupancyBitmap() = default;
+  ~OccupancyBitmap() = default;
+
+  /**
+   * @param time_step_grids: the obstacle boxes of every time step
+   * @param ego_length: the largest ego box to check
+   * @param ego_width: the largest ego box to check
+   * @param resolution: the cell size
+   */
+  OccupancyBitmap(const std::vector<common::Box2dGrid> &time_step_grids,
+                  double ego_length,
+                  double ego_width,
+                  double resolution);
+
+  size_t NumTimeSteps() const { return layers_.size(); }
+
+  /**
+   * @brief: broadphase of the ego box against the obstacle boxes of a time step
+   * @param ego_box
+   * @param time_index
+   * @return: false if the ego box overlaps with none of the obstacle boxes, true if it may overlap
+   */
+  bool MayOverlap(const common::Box2d &ego_box, size_t time_index) const;
+
+  /**
+   * @brief: same as above, without building the ego box
+   * @param center: the ego box center
+   * @param heading: the ego box heading
+   * @param length: the ego box length
+   * @param width: the ego box width
+   * @param time_index
+   * @return
+   */
+  bool MayOverlap(const Eigen::Vector2d &center, double heading, double length, double width,
+                  size_t time_index) const;
+
+ private:
+  struct Layer {
+    double min_x = 0.0;
+    double min_y = 0.0;
+    double resolution = 1.0;
+    int num_cells_x = 0;
+    int num_cells_y = 0;
+    size_t word_offset = 0;
+  };
+
+  void BuildLayer(const common::Box2dGrid &grid, Layer *layer);
+
+  bool IsOccupied(const Layer &layer, double x, double y) const;
+
+ private:
+  size_t num_disks_ = 1;
+  double disk_radius_ = 0.0;
+  std::vector<Layer> layers_;
+  std::vector<uint64_t> words_;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COLLISION_CHECKER_INCLUDE_COLLISION_CHECKER_OCCUPANCY_BITMAP_HPP_
@@ -1,4 +1,6 @@
 #include "collision_checker/collision_checker.hpp"
+#include <algorithm>
+#include <atomic>
 #include <utility>
 
 #define DEBUG false
@@ -16,34 +18,55 @@ CollisionChecker::CollisionChecker(const std::unordered_map<int, std::shared_ptr
                                    double lookahead_time,
                                    double delta_t,
                                    const VehicleParams &vehicle_params,
-                                   ThreadPool *thread_pool)
+                                   ThreadPool *thread_pool,
+                                   size_t parallel_min_points)
+    : CollisionChecker(std::make_shared<ObstacleOccupancy>(SortedObstacles(obstacles), lon_buffer, lat_buffer,
+                                                           lookahead_time, delta_t),
+                       ref_line,
+                       std::move(ptr_st_graph),
+                       ego_vehicle_s,
+                       ego_vehicle_d,
+                       vehicle_params,
+                       thread_pool,
+                       parallel_min_points) {}
+
+CollisionChecker::CollisionChecker(std::shared_ptr<const ObstacleOccupancy> obstacle_occupancy,
+                                   const ReferenceLine &ref_line,
+                                   std::shared_ptr<STGraph> ptr_st_graph,
+                                   double ego_vehicle_s,
+                                   double ego_vehicle_d,
+                                   const VehicleParams &vehicle_params,
+                                   ThreadPool *thread_pool,
+                                   size_t parallel_min_points)
     : ref_line_(ref_line),
       ptr_st_graph_(std::move(ptr_st_graph)),
+      obstacle_occupancy_(std::move(obstacle_occupancy)),
       thread_pool_(thread_pool),
-      lon_buffer_(lon_buffer),
-      lat_buffer_(lat_buffer),
-      lookahead_time_(lookahead_time),
-      delta_t_(delta_t) {
-  predicted_obstacle_box_.clear();
-  this->Init(obstacles, ego_vehicle_s, ego_vehicle_d, ref_line_);
-  std::cout << " ---------lon buffer: " << lon_buffer << ", lat_buffer : " << lat_buffer << std::endl;
+      parallel_min_points_(parallel_min_points),
+      vehicle_params_(vehicle_params),
+      lon_buffer_(obstacle_occupancy_->lon_buffer()),
+      lat_buffer_(obstacle_occupancy_->lat_buffer()),
+      lookahead_time_(obstacle_occupancy_->lookahead_time()),
+      delta_t_(obstacle_occupancy_->delta_t()) {
+  this->Init(ego_vehicle_s, ego_vehicle_d, ref_line_);
+  std::cout << " ---------lon buffer: " << lon_buffer_ << ", lat_buffer : " << lat_buffer_ << std::endl;
 }
 
 bool CollisionChecker::IsCollision(const planning_msgs::Trajectory &trajectory) const {
-  double ego_width = vehicle_params_.width;
-  double ego_length = vehicle_params_.length;
-  double shift_distance = vehicle_params_.back_axle_to_center_length;
-
-  assert(trajectory.trajectory_points.size() <= predicted_obstacle_box_.size());
+  assert(trajectory.trajectory_points.size() <= obstacle_occupancy_->NumTimeSteps());
 #if DEBUG
-  std::cout << "bounding boxs for obstacle" << std::endl;
-  for (size_t i = 0; i < predicted_obstacle_box_.size(); ++i) {
-    if (!predicted_obstacle_box_[i].empty()) {
-      std::cout << "i " << i << " len: " << predicted_obstacle_box_[i].front().length() << ", width: "
-                << predicted_obstacle_box_[i].front().width()
-                << " heading: " << predicted_obstacle_box_[i].front().heading()
-                << " center_x : " << predicted_obstacle_box_[i].front().center_x()
-                << " center_y : " << predicted_obstacle_box_[i].front().center_y()
+  std::cout << "buffered bounding boxs for obstacle" << std::endl;
+  for (size_t i = 0; i < obstacle_occupancy_->NumTimeSteps(); ++i) {
+    const auto &boxes = obstacle_occupancy_->TimeStepGrid(i).boxes();
+    for (size_t k = 0; k < boxes.size(); ++k) {
+      if (!considered_obstacles_[k]) {
+        continue;
+      }
+      std::cout << "i " << i << " len: " << boxes[k].length() << ", width: "
+                << boxes[k].width()
+                << " heading: " << boxes[k].heading()
+                << " center_x : " << boxes[k].center_x()
+                << " center_y : " << boxes[k].center_y()
                 << std::endl;
     }
   }
@@ -56,85 +79,97 @@ bool CollisionChecker::IsCollision(const planning_msgs::Trajectory &trajectory)
   }
 
 
-  std::cout << "=====predicted_obstacle_box_ size ===== " << predicted_obstacle_box_.size() << std::endl;
-#endif
-  if (this->thread_pool_ == nullptr) {
-    for (size_t i = 0; i < trajectory.trajectory_points.size(); ++i) {
-      auto traj_point = trajectory.trajectory_points.at(i);
-      double ego_theta = traj_point.path_point.theta;
-      Box2d ego_box = Box2d({traj_point.path_point.x, traj_point.path_point.y}, ego_theta, ego_length, ego_width);
-      ego_box.Shift({shift_distance * std::cos(ego_theta), shift_distance * std::sin(ego_theta)});
-#if DEBUG
-      std::cout << " obstacle box at index  " << i << " size is :" << predicted_obstacle_box_[i].size() << std::endl;
-      std::cout << "relative trajectory point: x: " << traj_point.path_point.x << ", y: " << traj_point.path_point.y
-                << ", theta: " << traj_point.path_point.theta << std::endl;
+  std::cout << "=====obstacle time steps ===== " << obstacle_occupancy_->NumTimeSteps() << std::endl;
 #endif
-      for (auto obstacle_box : predicted_obstacle_box_[i]) {
-        obstacle_box.LateralExtend(2.0 * lat_buffer_);
-        obstacle_box.LongitudinalExtend(2.0 * lon_buffer_);
+  const size_t num_points = trajectory.trajectory_points.size();
+  if (thread_pool_ == nullptr || thread_pool_->Size() < 2 || num_points < parallel_min_points_) {
+    return IsCollision(trajectory, 0, num_points, nullptr);
+  }
 
-#if DEBUG
-        std::cout << " obstacle_box: center: x: " << obstacle_box.center_x() << ", y: " << obstacle_box.center_y()
-                  << ", theta: " << obstacle_box.heading() << ", length: " << obstacle_box.length() << ", width: "
-                  << obstacle_box.width() << std::endl;
-#endif
+  // one chunk of trajectory points per worker plus one for the calling thread, a chunk starting after a
+  // collision is found is skipped
+  const size_t num_chunks = std::min(static_cast<size_t>(thread_pool_->Size()) + 1, num_points);
+  const size_t chunk_size = (num_points + num_chunks - 1) / num_chunks;
+  std::atomic<bool> collision{false};
+  thread_pool_->ParallelFor(num_chunks, [this, &trajectory, &collision, num_points, chunk_size](size_t chunk) {
+    const size_t begin = chunk * chunk_size;
+    const size_t end = std::min(begin + chunk_size, num_points);
+    if (!collision.load() && IsCollision(trajectory, begin, end, &collision)) {
+      collision.store(true);
+    }
+  });
+  return collision.load();
+}
 
-        if (ego_box.HasOverlapWithBox2d(obstacle_box)) {
-          return true;
-        }
-      }
+bool CollisionChecker::IsCollision(const planning_msgs::Trajectory &trajectory,
+                                   size_t begin,
+                                   size_t end,
+                                   const std::atomic<bool> *stop) const {
+  double ego_width = vehicle_params_.width;
+  double ego_length = vehicle_params_.length;
+  double shift_distance = vehicle_params_.back_axle_to_center_length;
+  for (size_t i = begin; i < end; ++i) {
+    if (stop != nullptr && stop->load(std::memory_order_relaxed)) {
+      return false;
     }
-    return false;
-  } else {
-    std::vector<std::future<bool>> futures;
-    for (size_t i = 0; i < trajectory.trajectory_points.size(); ++i) {
-      const auto &traj_point = trajectory.trajectory_points[i];
-      double ego_theta = traj_point.path_point.theta;
-      Box2d ego_box = Box2d({traj_point.path_point.x, traj_point.path_point.y}, ego_theta, ego_length, ego_width);
-      ego_box.Shift({shift_distance * std::cos(ego_theta), shift_distance * std::sin(ego_theta)});
-      for (const auto &obstacle_box : predicted_obstacle_box_[i]) {
-        const auto task = [&ego_box, &obstacle_box]() -> bool {
-          return ego_box.HasOverlapWithBox2d(obstacle_box);
-        };
-        futures.emplace_back(thread_pool_->PushTask(task));
-      }
+    const auto &traj_point = trajectory.trajectory_points[i];
+    double ego_theta = traj_point.path_point.theta;
+    // the trajectory point is on the rear axle
+    const Eigen::Vector2d ego_center(traj_point.path_point.x + shift_distance * std::cos(ego_theta),
+                                     traj_point.path_point.y + shift_distance * std::sin(ego_theta));
+#if DEBUG
+    std::cout << "relative trajectory point: x: " << traj_point.path_point.x << ", y: " << traj_point.path_point.y
+              << ", theta: " << traj_point.path_point.theta << std::endl;
+#endif
+    // a clear bitmap proves there is no collision, otherwise only the buffered boxes of the considered
+    // obstacles near the ego box are tested
+    if (obstacle_occupancy_->HasBitmap() &&
+        !obstacle_occupancy_->bitmap().MayOverlap(ego_center, ego_theta, ego_length, ego_width, i)) {
+      continue;
     }
-    for (auto &future : futures) {
-      if (future.get()) {
-        return true;
-      }
+    Box2d ego_box = Box2d(ego_center, ego_theta, ego_length, ego_width);
+    if (obstacle_occupancy_->TimeStepGrid(i).HasOverlapWithBox2d(ego_box, considered_obstacles_)) {
+      return true;
     }
-    return false;
   }
+  return false;
 }
 
-void CollisionChecker::Init(const std::unordered_map<int, std::shared_ptr<Obstacle>> &obstacles,
-                            double ego_vehicle_s,
+void CollisionChecker::Init(double ego_vehicle_s,
                             double ego_vehicle_d,
                             const ReferenceLine &reference_line) {
 
   bool ego_vehicle_in_lane = IsEgoVehicleInLane(ego_vehicle_s, ego_vehicle_d);
-  std::vector<std::shared_ptr<Obstacle>> obstacle_considered;
-  for (auto &obstacle : obstacles) {
+  const auto &obstacles = obstacle_occupancy_->obstacles();
+  considered_obstacles_.assign(obstacles.size(), false);
+  for (size_t i = 0; i < obstacles.size(); ++i) {
+    const auto &obstacle = obstacles[i];
+    size_t index = 0;
+    if (!obstacle_occupancy_->FindObstacleIndex(obstacle->Id(), &index) || index != i) {
+      // an obstacle id is considered once
+      continue;
+    }
     if (ego_vehicle_in_lane &&
-        (IsObstacleBehindEgoVehicle(obstacle.second, ego_vehicle_s, reference_line)
-            || !ptr_st_graph_->IsObstacleInGraph(obstacle.first))) {
+        (IsObstacleBehindEgoVehicle(obstacle, ego_vehicle_s, reference_line)
+            || !ptr_st_graph_->IsObstacleInGraph(obstacle->Id()))) {
       continue;
     }
-    obstacle_considered.push_back(obstacle.second);
+    considered_obstacles_[i] = true;
   }
+}
 
-  double relative_time = 0.0;
-  while (relative_time < lookahead_time_ + delta_t_) {
-    std::vector<Box2d> predicted_env;
-    for (const auto &obstacle : obstacle_considered) {
-      planning_msgs::TrajectoryPoint point = obstacle->GetPointAtTime(relative_time);
-      Box2d box = obstacle->GetBoundingBoxAtPoint(point);
-      predicted_env.push_back(box);
-    }
-    predicted_obstacle_box_.push_back(std::move(predicted_env));
-    relative_time += delta_t_;
+std::vector<std::shared_ptr<Obstacle>> CollisionChecker::SortedObstacles(
+    const std::unordered_map<int, std::shared_ptr<Obstacle>> &obstacles) {
+  std::vector<std::shared_ptr<Obstacle>> sorted_obstacles;
+  sorted_obstacles.reserve(obstacles.size());
+  for (const auto &obstacle : obstacles) {
+    sorted_obstacles.push_back(obstacle.second);
   }
+  std::sort(sorted_obstacles.begin(), sorted_obstacles.end(),
+            [](const std::shared_ptr<Obstacle> &obstacle0, const std::shared_ptr<Obstacle> &obstacle1) -> bool {
+              return obstacle0->Id() < obstacle1->Id();
+            });
+  return sorted_obstacles;
 }
 
 bool CollisionChecker::IsEgoVehicleInLane(double ego_vehicle_s, double ego_vehicle_d) const {
@@ -149,9 +184,9 @@ bool CollisionChecker::IsObstacleBehindEgoVehicle(const std::shared_ptr<Obstacle
                                                   double ego_s,
                                                   const ReferenceLine &ref_line) {
   constexpr double kDefaultLaneWidth = 3.5;
-  planning_msgs::TrajectoryPoint point = obstacle->GetPointAtTime(0.0);
+  const auto pose = obstacle->GetPoseAtTime(0.0);
   SLPoint sl_point;
-  ref_line.XYToSL(point.path_point.x, point.path_point.y, &sl_point);
+  ref_line.XYToSL(pose.x, pose.y, &sl_point);
   if (ego_s > sl_point.s && std::fabs(sl_point.l) < kDefaultLaneWidth / 2.0) {
     return true;
   }
@@ -177,8 +212,7 @@ bool CollisionChecker::IsCollision(const std::vector<std::shared_ptr<Obstacle>>
     ego_box.Shift(shift_vec);
     std::vector<common::Box2d> obstacle_boxes;
     for (const auto &obstacle : obstacles) {
-      auto obstacle_point = obstacle->GetPointAtTime(relative_time);
-      common::Box2d obstacle_box = obstacle->GetBoundingBoxAtPoint(obstacle_point);
+      common::Box2d obstacle_box = obstacle->GetBoundingBoxAtPose(obstacle->GetPoseAtTime(relative_time));
       if (ego_box.HasOverlapWithBox2d(obstacle_box)) {
         return true;
       }
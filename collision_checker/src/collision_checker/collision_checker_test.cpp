@@ -7,6 +7,7 @@
 #include <tf/transform_datatypes.h>
 #include <math/coordinate_transformer.hpp>
 #include <memory>
+#include <algorithm>
 
 class CollisionCheckTest : public ::testing::Test {
  public:
@@ -295,13 +296,14 @@ TEST_F(CollisionCheckTest, in_lane_test) {
 }
 
 TEST_F(CollisionCheckTest, collision_test) {
-  auto predicted_obstacle_box = collision_checker_->predicted_obstacle_box_;
-  int i = 0;
-  for (const auto &obstacle_box_discrete_time : predicted_obstacle_box) {
-    EXPECT_TRUE(obstacle_box_discrete_time.size() == 1);
-    auto obstacle_box = obstacle_box_discrete_time.front();
+  const auto &obstacle_occupancy = collision_checker_->obstacle_occupancy_;
+  const auto &considered_obstacles = collision_checker_->considered_obstacles_;
+  EXPECT_TRUE(std::count(considered_obstacles.begin(), considered_obstacles.end(), true) == 1);
+  for (size_t i = 0; i < obstacle_occupancy->NumTimeSteps(); ++i) {
+    const auto &obstacle_boxes = obstacle_occupancy->TimeStepGrid(i).boxes();
+    EXPECT_TRUE(obstacle_boxes.size() == 1);
+    auto obstacle_box = obstacle_boxes.front();
     std::cout << "i: " << i << "box center:" << obstacle_box.center_x() << ", " << obstacle_box.center_y() << std::endl;
-    ++i;
   }
 
   planning_msgs::Trajectory trajectory;
@@ -329,6 +331,57 @@ TEST_F(CollisionCheckTest, collision_test) {
 
 }
 
+TEST_F(CollisionCheckTest, parallel_collision_test) {
+  std::unordered_map<int, std::shared_ptr<planning::Obstacle>> obstacle_map;
+  obstacle_map.emplace(obstacle_->Id(), obstacle_);
+  common::ThreadPool thread_pool(4);
+  planning::CollisionChecker parallel_collision_checker(obstacle_map, reference_line_, st_graph_, start_s_,
+                                                        init_d_[0], 2.0, 0.3, lookahead_time_, 0.1,
+                                                        vehicle_params_, &thread_pool, 1);
+  // a checker on an occupancy shared with other reference lines
+  auto obstacle_occupancy = std::make_shared<planning::ObstacleOccupancy>(
+      std::vector<std::shared_ptr<planning::Obstacle>>{obstacle_}, 2.0, 0.3, lookahead_time_, 0.1);
+  planning::CollisionChecker shared_collision_checker(obstacle_occupancy, reference_line_, st_graph_, start_s_,
+                                                      init_d_[0], vehicle_params_, nullptr);
+  // the bitmap only skips the box checks, the results are the same
+  auto bitmap_obstacle_occupancy = std::make_shared<planning::ObstacleOccupancy>(*obstacle_occupancy);
+  bitmap_obstacle_occupancy->BuildBitmap(vehicle_params_.length, vehicle_params_.width, 0.5);
+  planning::CollisionChecker bitmap_collision_checker(bitmap_obstacle_occupancy, reference_line_, st_graph_,
+                                                      start_s_, init_d_[0], vehicle_params_, nullptr);
+  for (double l : {0.0, 1.0, 2.0, 4.0, 8.0}) {
+    for (double v : {0.0, 3.0, 10.0}) {
+      planning_msgs::Trajectory trajectory;
+      double s = start_s_;
+      for (double t = 0.0; t <= 8.0; t += delta_t_) {
+        auto ref_point = reference_line_.GetReferencePoint(s);
+        auto xy = common::CoordinateTransformer::CalcCatesianPoint(ref_point.theta(), ref_point.x(), ref_point.y(), l);
+        planning_msgs::TrajectoryPoint tp;
+        tp.path_point.x = xy.x();
+        tp.path_point.y = xy.y();
+        tp.path_point.theta = ref_point.theta();
+        tp.vel = v;
+        tp.relative_time = t;
+        trajectory.trajectory_points.push_back(tp);
+        s += v * delta_t_;
+      }
+      const bool expected = collision_checker_->IsCollision(trajectory);
+      EXPECT_EQ(parallel_collision_checker.IsCollision(trajectory), expected);
+      EXPECT_EQ(shared_collision_checker.IsCollision(trajectory), expected);
+      EXPECT_EQ(bitmap_collision_checker.IsCollision(trajectory), expected);
+      // the chunks are claimed by the caller too, so checking from the pool workers must not dead lock
+      std::vector<std::future<bool>> futures;
+      for (int i = 0; i < 2 * thread_pool.Size(); ++i) {
+        futures.push_back(thread_pool.PushTask([&parallel_collision_checker, &trajectory]() -> bool {
+          return parallel_collision_checker.IsCollision(trajectory);
+        }));
+      }
+      for (auto &future : futures) {
+        EXPECT_EQ(future.get(), expected);
+      }
+    }
+  }
+}
+
 TEST_F(CollisionCheckTest, st_graph_test) {
   EXPECT_TRUE(st_graph_->IsObstacleInGraph(obstacle_->Id()));
   std::vector<common::STPoint> st_points = st_graph_->GetObstacleSurroundingPoints(obstacle_->Id(), 1e-3, 0.1);
@@ -379,7 +432,7 @@ TEST_F(CollisionCheckTest, dynamic_obstacle_test) {
     s += tp.vel * delta_t;
     t += delta_t;
   }
-  obstacle_->trajectory_ = trajectory;
+  obstacle_->SetTrajectory(trajectory);
 
   s = start_s_;
   planning_msgs::Trajectory ego_trajectory;
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <obstacle_manager/object_spatial_hash.hpp>
+#include <random>
+#include "test_fixtures.hpp"
+
+using namespace planning;
+using planning::test::MakeArcReferenceLine;
+
+TEST(ObjectSpatialHashTest, corridor_query) {
+  const auto ref_line = MakeArcReferenceLine(40);
+  std::mt19937 gen(11);
+  std::uniform_real_distribution<double> position(-60.0, 110.0);
+  ObjectSpatialHash spatial_hash(10.0);
+  for (int id = 0; id < 500; ++id) {
+    spatial_hash.AddEntry(id, id % 10 == 0, Eigen::Vector2d(position(gen), position(gen)));
+  }
+  spatial_hash.Build();
+  ASSERT_EQ(spatial_hash.Size(), 500);
+
+  const double radius = 6.0;
+  for (const double s_end : {30.0, 60.0, 200.0}) {
+    std::vector<size_t> candidates;
+    spatial_hash.QueryCorridor(ref_line, 0.0, s_end, radius, &candidates);
+    ASSERT_TRUE(std::is_sorted(candidates.begin(), candidates.end()));
+    ASSERT_TRUE(std::adjacent_find(candidates.begin(), candidates.end()) == candidates.end());
+    // every entry the brute force projection keeps is a candidate
+    size_t num_kept = 0;
+    for (size_t i = 0; i < spatial_hash.Size(); ++i) {
+      common::SLPoint sl_point;
+      ASSERT_TRUE(ref_line.XYToSL(spatial_hash.GetEntry(i).xy, &sl_point));
+      if (sl_point.s > s_end || std::fabs(sl_point.l) > radius) {
+        continue;
+      }
+      ++num_kept;
+      EXPECT_TRUE(std::binary_search(candidates.begin(), candidates.end(), i))
+              << "entry " << i << " at s " << sl_point.s << ", l " << sl_point.l;
+    }
+    EXPECT_GT(num_kept, 0);
+    // the candidates are around the line, not the whole map
+    EXPECT_LT(candidates.size(), spatial_hash.Size() / 2);
+  }
+}
+
+TEST(ObjectSpatialHashTest, corridor_query_past_the_ends) {
+  // the line starts at (0, 0) heading to +x and ends at (50, 50) heading to +y
+  const auto ref_line = MakeArcReferenceLine(40);
+  const double length = ref_line.Length();
+  ObjectSpatialHash spatial_hash(10.0);
+  // on the line extended before the start and past the end, and far from both
+  spatial_hash.AddEntry(0, false, Eigen::Vector2d(-25.0, 1.0));
+  spatial_hash.AddEntry(1, false, Eigen::Vector2d(49.0, 90.0));
+  spatial_hash.AddEntry(2, false, Eigen::Vector2d(-25.0, 30.0));
+  spatial_hash.AddEntry(3, false, Eigen::Vector2d(90.0, 90.0));
+  spatial_hash.Build();
+
+  std::vector<size_t> candidates;
+  spatial_hash.QueryCorridor(ref_line, 0.0, length, 6.0, &candidates);
+  EXPECT_TRUE(candidates.empty());
+  spatial_hash.QueryCorridor(ref_line, -30.0, length + 50.0, 6.0, &candidates);
+  EXPECT_EQ(candidates, std::vector<size_t>({0, 1}));
+  // the extension is only as long as asked for
+  spatial_hash.QueryCorridor(ref_line, -10.0, length + 20.0, 6.0, &candidates);
+  EXPECT_TRUE(candidates.empty());
+}
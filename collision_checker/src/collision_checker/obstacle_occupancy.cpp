@@ -0,0 +1,49 @@
+#include "collision_checker/obstacle_occupancy.hpp"
+#include <utility>
+
+namespace planning {
+using namespace common;
+
+ObstacleOccupancy::ObstacleOccupancy(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
+                                     double lon_buffer,
+                                     double lat_buffer,
+                                     double lookahead_time,
+                                     double delta_t)
+    : obstacles_(obstacles),
+      lon_buffer_(lon_buffer),
+      lat_buffer_(lat_buffer),
+      lookahead_time_(lookahead_time),
+      delta_t_(delta_t) {
+  for (size_t i = 0; i < obstacles_.size(); ++i) {
+    obstacle_indices_.emplace(obstacles_[i]->Id(), i);
+  }
+  double relative_time = 0.0;
+  while (relative_time < lookahead_time_ + delta_t_) {
+    std::vector<Box2d> buffered_boxes;
+    buffered_boxes.reserve(obstacles_.size());
+    for (const auto &obstacle : obstacles_) {
+      Box2d box = obstacle->GetBoundingBoxAtPose(obstacle->GetPoseAtTime(relative_time));
+      box.LateralExtend(2.0 * lat_buffer_);
+      box.LongitudinalExtend(2.0 * lon_buffer_);
+      buffered_boxes.push_back(std::move(box));
+    }
+    time_step_grids_.emplace_back(std::move(buffered_boxes));
+    relative_time += delta_t_;
+  }
+}
+
+bool ObstacleOccupancy::FindObstacleIndex(int id, size_t *index) const {
+  auto iter = obstacle_indices_.find(id);
+  if (iter == obstacle_indices_.end()) {
+    return false;
+  }
+  *index = iter->second;
+  return true;
+}
+
+void ObstacleOccupancy::BuildBitmap(double ego_length, double ego_width, double resolution) {
+  bitmap_ = OccupancyBitmap(time_step_grids_, ego_length, ego_width, resolution);
+  has_bitmap_ = true;
+}
+
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <obstacle_manager/obstacle_predictor.hpp>
+#include <math/math_utils.hpp>
+#include <thread_pool/thread_pool.hpp>
+#include <algorithm>
+#include <random>
+#include "test_fixtures.hpp"
+
+using namespace planning;
+using planning::test::MakeObstacle;
+using planning::test::MakeStraightReferenceLine;
+
+namespace {
+double predict_horizon{8.0};
+double predict_step{0.1};
+
+ObstaclePredictor MakePredictor(ObstaclePredictor::Mode mode, common::ThreadPool *thread_pool, bool enable_cache) {
+  return ObstaclePredictor(mode, predict_horizon, predict_step, thread_pool, enable_cache, 0.2, 0.05, 0.3);
+}
+}
+
+TEST(ObstaclePredictorTest, constant_velocity) {
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> position(-50.0, 50.0);
+  std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+  std::uniform_real_distribution<double> speed(0.0, 15.0);
+  std::vector<std::shared_ptr<Obstacle>> obstacles;
+  for (int id = 0; id < 30; ++id) {
+    obstacles.push_back(MakeObstacle(id, position(gen), position(gen), heading(gen), speed(gen), 0.0));
+  }
+  // the same actor selected twice, e.g. for two targets
+  obstacles.push_back(std::make_shared<Obstacle>(*obstacles.front()));
+  common::ThreadPool thread_pool(4);
+  auto predictor = MakePredictor(ObstaclePredictor::Mode::kConstantVelocity, &thread_pool, false);
+  predictor.Predict(obstacles, {}, 0.0);
+  for (const auto &obstacle : obstacles) {
+    Obstacle expected_obstacle = *obstacle;
+    expected_obstacle.PredictTrajectory(predict_horizon, predict_step);
+    const auto expected_points = expected_obstacle.GetPredictedTrajectory().trajectory_points;
+    const auto points = obstacle->GetPredictedTrajectory().trajectory_points;
+    ASSERT_EQ(points.size(), expected_points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+      EXPECT_EQ(points[i].path_point.x, expected_points[i].path_point.x);
+      EXPECT_EQ(points[i].path_point.y, expected_points[i].path_point.y);
+      EXPECT_EQ(points[i].path_point.s, expected_points[i].path_point.s);
+      EXPECT_EQ(points[i].path_point.theta, expected_points[i].path_point.theta);
+      EXPECT_EQ(points[i].relative_time, expected_points[i].relative_time);
+    }
+  }
+}
+
+TEST(ObstaclePredictorTest, constant_turn_rate) {
+  const double speed = 5.0;
+  const double yaw_rate = 0.2;
+  std::vector<std::shared_ptr<Obstacle>> obstacles{MakeObstacle(1, 10.0, 5.0, 0.5, speed, yaw_rate)};
+  auto predictor = MakePredictor(ObstaclePredictor::Mode::kConstantTurnRate, nullptr, false);
+  predictor.Predict(obstacles, {}, 0.0);
+  const auto points = obstacles.front()->GetPredictedTrajectory().trajectory_points;
+  ASSERT_EQ(points.size(), 80);
+  // on the circle of radius speed / yaw_rate, with the heading turning at yaw_rate
+  const double radius = speed / yaw_rate;
+  const double center_x = 10.0 - radius * std::sin(0.5);
+  const double center_y = 5.0 + radius * std::cos(0.5);
+  for (const auto &point : points) {
+    EXPECT_NEAR(std::hypot(point.path_point.x - center_x, point.path_point.y - center_y), radius, 1e-6);
+    EXPECT_NEAR(common::MathUtils::NormalizeAngle(point.path_point.theta - 0.5 - yaw_rate * point.relative_time),
+                0.0, 1e-9);
+    EXPECT_NEAR(point.path_point.s, speed * point.relative_time, 1e-9);
+  }
+}
+
+TEST(ObstaclePredictorTest, lane_following) {
+  std::vector<ReferenceLine> ref_lines{MakeStraightReferenceLine(100, 2.0)};
+  // 1 m off the lane center, heading away from it
+  std::vector<std::shared_ptr<Obstacle>> obstacles{MakeObstacle(1, 20.0, 1.0, 0.2, 8.0, 0.0),
+                                                    MakeObstacle(2, 30.0, 30.0, 0.0, 8.0, 0.0)};
+  auto predictor = MakePredictor(ObstaclePredictor::Mode::kLaneFollowing, nullptr, false);
+  predictor.Predict(obstacles, ref_lines, 0.0);
+  const auto points = obstacles[0]->GetPredictedTrajectory().trajectory_points;
+  ASSERT_EQ(points.size(), 80);
+  for (size_t i = 1; i < points.size(); ++i) {
+    EXPECT_NEAR(points[i].path_point.x, 20.0 + 8.0 * points[i].relative_time, 1e-2);
+    EXPECT_LT(std::fabs(points[i].path_point.y), std::fabs(points[i - 1].path_point.y) + 1e-6);
+  }
+  EXPECT_LT(std::fabs(points.back().path_point.y), 0.01);
+  EXPECT_LT(std::fabs(points.back().path_point.theta), 0.01);
+  // no lane, as constant velocity
+  const auto off_lane_points = obstacles[1]->GetPredictedTrajectory().trajectory_points;
+  ASSERT_EQ(off_lane_points.size(), 80);
+  EXPECT_NEAR(off_lane_points.back().path_point.x, 30.0 + 8.0 * off_lane_points.back().relative_time, 1e-6);
+  EXPECT_NEAR(off_lane_points.back().path_point.y, 30.0, 1e-6);
+}
+
+TEST(ObstaclePredictorTest, prediction_cache) {
+  std::vector<ReferenceLine> ref_lines{MakeStraightReferenceLine(100, 2.0)};
+  auto predictor = MakePredictor(ObstaclePredictor::Mode::kLaneFollowing, nullptr, true);
+  std::vector<std::shared_ptr<Obstacle>> obstacles{MakeObstacle(1, 20.0, 1.0, 0.0, 8.0, 0.0),
+                                                    MakeObstacle(2, 40.0, -1.0, 0.0, 5.0, 0.0)};
+  predictor.Predict(obstacles, ref_lines, 0.0);
+  EXPECT_EQ(predictor.NumReusedPredictions(), 0);
+  const auto first_point = obstacles[0]->GetPointAtTime(0.3);
+  const auto second_point = obstacles[1]->GetPointAtTime(0.3);
+
+  // the first actor moved along its prediction, the second one braked
+  std::vector<std::shared_ptr<Obstacle>> moved_obstacles{
+      MakeObstacle(1, first_point.path_point.x, first_point.path_point.y, first_point.path_point.theta, 8.0, 0.0),
+      MakeObstacle(2, second_point.path_point.x, second_point.path_point.y, second_point.path_point.theta, 3.0, 0.0)};
+  predictor.Predict(moved_obstacles, ref_lines, 0.3);
+  EXPECT_EQ(predictor.NumReusedPredictions(), 1);
+
+  auto fresh_predictor = MakePredictor(ObstaclePredictor::Mode::kLaneFollowing, nullptr, false);
+  std::vector<std::shared_ptr<Obstacle>> fresh_obstacles{std::make_shared<Obstacle>(*moved_obstacles[0])};
+  fresh_predictor.Predict(fresh_obstacles, ref_lines, 0.3);
+  const auto points = moved_obstacles[0]->GetPredictedTrajectory().trajectory_points;
+  const auto fresh_points = fresh_obstacles[0]->GetPredictedTrajectory().trajectory_points;
+  ASSERT_EQ(points.size(), fresh_points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    EXPECT_EQ(points[i].relative_time, fresh_points[i].relative_time);
+    EXPECT_NEAR(points[i].path_point.x, fresh_points[i].path_point.x, 0.1);
+    EXPECT_NEAR(points[i].path_point.y, fresh_points[i].path_point.y, 0.1);
+  }
+  EXPECT_NEAR(points.front().path_point.s, 0.0, 1e-9);
+
+  // too late to reuse
+  predictor.Predict(moved_obstacles, ref_lines, 2.0);
+  EXPECT_EQ(predictor.NumReusedPredictions(), 0);
+}
+
+TEST(ObstaclePredictorTest, pose_track) {
+  // turning across the heading of -pi / pi
+  planning_msgs::Trajectory trajectory;
+  for (size_t i = 0; i < 50; ++i) {
+    planning_msgs::TrajectoryPoint point;
+    point.relative_time = predict_step * static_cast<double>(i);
+    point.path_point.x = std::cos(0.1 * i);
+    point.path_point.y = std::sin(0.1 * i);
+    point.path_point.theta = common::MathUtils::NormalizeAngle(2.5 + 0.1 * i);
+    point.path_point.s = 0.1 * i;
+    point.vel = 1.0 + 0.05 * i;
+    trajectory.trajectory_points.push_back(point);
+  }
+  const auto track = PoseTrack::FromTrajectory(trajectory);
+  ASSERT_EQ(track.Size(), trajectory.trajectory_points.size());
+  EXPECT_NEAR(track.EndTime(), trajectory.trajectory_points.back().relative_time, 1e-9);
+  const auto &points = trajectory.trajectory_points;
+  for (double t = -0.5; t < 5.5; t += 0.013) {
+    // as the lower bound interpolation of the trajectory
+    auto iter = std::lower_bound(points.begin(), points.end(), t,
+                                 [](const planning_msgs::TrajectoryPoint &p, double t) { return p.relative_time < t; });
+    planning_msgs::TrajectoryPoint expected = iter == points.begin() ? points.front()
+        : iter == points.end() ? points.back() : common::MathUtils::InterpolateTrajectoryPoint(*(iter - 1), *iter, t);
+    const auto pose = track.GetPoseAtTime(t);
+    EXPECT_NEAR(pose.x, expected.path_point.x, 1e-9);
+    EXPECT_NEAR(pose.y, expected.path_point.y, 1e-9);
+    EXPECT_NEAR(common::MathUtils::NormalizeAngle(pose.theta - expected.path_point.theta), 0.0, 1e-9);
+    EXPECT_NEAR(pose.v, expected.vel, 1e-9);
+    EXPECT_NEAR(pose.s, expected.path_point.s, 1e-9);
+  }
+  // not uniform in time, resampled at the first step
+  trajectory.trajectory_points.erase(trajectory.trajectory_points.begin() + 10);
+  const auto resampled_track = PoseTrack::FromTrajectory(trajectory);
+  EXPECT_EQ(resampled_track.Size(), 50);
+  EXPECT_NEAR(resampled_track.GetPose(10).x, 0.5 * (std::cos(0.9) + std::cos(1.1)), 1e-9);
+  const auto message = resampled_track.ToTrajectory();
+  ASSERT_EQ(message.trajectory_points.size(), 50);
+  EXPECT_NEAR(message.trajectory_points[20].relative_time, 2.0, 1e-9);
+  EXPECT_EQ(message.trajectory_points[20].path_point.x, resampled_track.GetPose(20).x);
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <obstacle_manager/obstacle_store.hpp>
+#include <obstacle_manager/obstacle_predictor.hpp>
+#include "test_fixtures.hpp"
+
+using namespace planning;
+using planning::test::MakeObject;
+
+TEST(ObstacleStoreTest, update) {
+  ObstacleStore store(3);
+  std::vector<derived_object_msgs::Object> objects{MakeObject(1, 0.0, 0.0, 0.0, 5.0),
+                                                   MakeObject(2, 10.0, 3.0, 0.5, 0.0)};
+  store.Update(objects, 0.0);
+  ASSERT_EQ(store.Size(), 2);
+  EXPECT_EQ(store.NumDirty(), 2);
+  const auto first_obstacle = store.Find(1)->obstacle;
+  EXPECT_EQ(store.Find(1)->version, 1);
+  EXPECT_EQ(first_obstacle->Version(), 1);
+  store.ClearDirtyFlags();
+  EXPECT_EQ(store.NumDirty(), 0);
+
+  // the same message again changes nothing but the history
+  store.Update(objects, 0.05);
+  EXPECT_EQ(store.NumDirty(), 0);
+  EXPECT_EQ(store.Find(1)->version, 1);
+  EXPECT_EQ(store.Find(1)->obstacle, first_obstacle);
+  EXPECT_EQ(store.Find(1)->history.size(), 2);
+
+  // actor 1 moves, actor 2 is gone, actor 3 appears
+  objects = {MakeObject(1, 0.25, 0.0, 0.0, 5.0), MakeObject(3, -5.0, 0.0, 0.0, 2.0)};
+  store.Update(objects, 0.1);
+  ASSERT_EQ(store.Size(), 2);
+  EXPECT_FALSE(store.Contains(2));
+  EXPECT_EQ(store.Find(2), nullptr);
+  EXPECT_EQ(store.NumDirty(), 2);
+  EXPECT_EQ(store.Find(1)->version, 2);
+  EXPECT_NE(store.Find(1)->obstacle, first_obstacle);
+  EXPECT_EQ(store.Find(1)->obstacle->Version(), 2);
+  EXPECT_DOUBLE_EQ(store.Find(1)->obstacle->x(), 0.25);
+  EXPECT_EQ(store.Find(3)->version, 1);
+
+  // the history is bounded, the latest state at the back
+  store.Update(objects, 0.15);
+  const auto &history = store.Find(1)->history;
+  ASSERT_EQ(history.size(), 3);
+  EXPECT_DOUBLE_EQ(history.front().timestamp, 0.05);
+  EXPECT_DOUBLE_EQ(history.back().timestamp, 0.15);
+  EXPECT_DOUBLE_EQ(history.back().x, 0.25);
+  EXPECT_NEAR(history.back().speed, 5.0, 1e-9);
+}
+
+TEST(ObstacleStoreTest, unchanged_obstacles_keep_prediction) {
+  ObstacleStore store;
+  std::vector<derived_object_msgs::Object> objects{MakeObject(1, 0.0, 0.0, 0.0, 5.0),
+                                                   MakeObject(2, 10.0, 3.0, 0.5, 3.0)};
+  ObstaclePredictor predictor(ObstaclePredictor::Mode::kConstantVelocity, 8.0, 0.1, nullptr, false, 0.2, 0.05, 0.3);
+  const auto get_obstacles = [&store]() {
+    std::vector<std::shared_ptr<Obstacle>> obstacles;
+    for (const int id : {1, 2}) {
+      obstacles.push_back(store.Find(id)->obstacle);
+    }
+    return obstacles;
+  };
+  store.Update(objects, 0.0);
+  predictor.Predict(get_obstacles(), {}, 0.0);
+  EXPECT_EQ(predictor.NumUnchangedObstacles(), 0);
+  const auto prediction = store.Find(2)->obstacle->GetPredictedTrajectory();
+
+  // actor 2 did not change, actor 1 moved
+  objects[0] = MakeObject(1, 0.5, 0.0, 0.0, 5.0);
+  store.Update(objects, 0.1);
+  predictor.Predict(get_obstacles(), {}, 0.1);
+  EXPECT_EQ(predictor.NumUnchangedObstacles(), 1);
+  const auto kept_prediction = store.Find(2)->obstacle->GetPredictedTrajectory();
+  ASSERT_EQ(kept_prediction.trajectory_points.size(), prediction.trajectory_points.size());
+  for (size_t i = 0; i < prediction.trajectory_points.size(); ++i) {
+    EXPECT_DOUBLE_EQ(kept_prediction.trajectory_points[i].path_point.x, prediction.trajectory_points[i].path_point.x);
+    EXPECT_DOUBLE_EQ(kept_prediction.trajectory_points[i].path_point.y, prediction.trajectory_points[i].path_point.y);
+  }
+  // the moved actor is predicted from its new state, as a fresh obstacle would be
+  Obstacle fresh(objects[0]);
+  fresh.PredictTrajectory(8.0, 0.1);
+  const auto moved_prediction = store.Find(1)->obstacle->GetPredictedTrajectory();
+  const auto fresh_prediction = fresh.GetPredictedTrajectory();
+  ASSERT_EQ(moved_prediction.trajectory_points.size(), fresh_prediction.trajectory_points.size());
+  EXPECT_DOUBLE_EQ(moved_prediction.trajectory_points.back().path_point.x,
+                   fresh_prediction.trajectory_points.back().path_point.x);
+
+  // an obstacle not predicted in the last cycle is predicted again
+  predictor.Predict({store.Find(1)->obstacle}, {}, 0.2);
+  predictor.Predict(get_obstacles(), {}, 0.3);
+  EXPECT_EQ(predictor.NumUnchangedObstacles(), 1);
+}
@@ -0,0 +1,133 @@
+#include "collision_checker/occupancy_bitmap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace planning {
+using namespace common;
+
+OccupancyBitmap::OccupancyBitmap(const std::vector<Box2dGrid> &time_step_grids,
+                                 double ego_length,
+                                 double ego_width,
+                                 double resolution) {
+  // the disks cover equal slices of the ego box, each slice is about as long as the box is wide
+  num_disks_ = static_cast<size_t>(std::max(1.0, std::ceil(ego_length / std::max(ego_width, 1e-3))));
+  disk_radius_ = std::hypot(0.5 * ego_width, 0.5 * ego_length / num_disks_);
+  layers_.resize(time_step_grids.size());
+  for (size_t i = 0; i < time_step_grids.size(); ++i) {
+    layers_[i].resolution = resolution;
+    BuildLayer(time_step_grids[i], &layers_[i]);
+  }
+}
+
+bool OccupancyBitmap::MayOverlap(const Box2d &ego_box, size_t time_index) const {
+  return MayOverlap(ego_box.Center(), ego_box.heading(), ego_box.length(), ego_box.width(), time_index);
+}
+
+bool OccupancyBitmap::MayOverlap(const Eigen::Vector2d &center, double heading, double length, double width,
+                                 size_t time_index) const {
+  if (time_index >= layers_.size()) {
+    return true;
+  }
+  const auto &layer = layers_[time_index];
+  if (layer.num_cells_x == 0) {
+    return false;
+  }
+  const double slice_length = length / num_disks_;
+  if (std::hypot(0.5 * width, 0.5 * slice_length) > disk_radius_) {
+    // larger than the rasterized ego box, the disks don't cover it
+    return true;
+  }
+  const double cos_heading = std::cos(heading);
+  const double sin_heading = std::sin(heading);
+  for (size_t k = 0; k < num_disks_; ++k) {
+    const double offset = -0.5 * length + (k + 0.5) * slice_length;
+    if (IsOccupied(layer, center.x() + offset * cos_heading, center.y() + offset * sin_heading)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void OccupancyBitmap::BuildLayer(const Box2dGrid &grid, Layer *layer) {
+  constexpr double kMaxNumCells = 1 << 20;
+  layer->word_offset = words_.size();
+  layer->num_cells_x = 0;
+  layer->num_cells_y = 0;
+  const auto &boxes = grid.boxes();
+  if (boxes.empty()) {
+    return;
+  }
+  double min_x = std::numeric_limits<double>::max();
+  double min_y = std::numeric_limits<double>::max();
+  double max_x = std::numeric_limits<double>::lowest();
+  double max_y = std::numeric_limits<double>::lowest();
+  for (const auto &box : boxes) {
+    for (size_t i = 0; i < 4; ++i) {
+      const auto &corner = box.GetCorner(i);
+      min_x = std::min(min_x, corner.x());
+      min_y = std::min(min_y, corner.y());
+      max_x = std::max(max_x, corner.x());
+      max_y = std::max(max_y, corner.y());
+    }
+  }
+  layer->min_x = min_x - disk_radius_;
+  layer->min_y = min_y - disk_radius_;
+  const double width = max_x - min_x + 2.0 * disk_radius_;
+  const double height = max_y - min_y + 2.0 * disk_radius_;
+  layer->resolution = std::max(layer->resolution, std::sqrt(width * height / kMaxNumCells));
+  layer->num_cells_x = static_cast<int>(width / layer->resolution) + 1;
+  layer->num_cells_y = static_cast<int>(height / layer->resolution) + 1;
+  const size_t num_cells = static_cast<size_t>(layer->num_cells_x) * layer->num_cells_y;
+  words_.resize(layer->word_offset + (num_cells + 63) / 64, 0);
+
+  // a cell is set if any point of it is within the disk radius of a box
+  const double half_diagonal = std::sqrt(0.5) * layer->resolution;
+  const double threshold = disk_radius_ + half_diagonal + 1e-6;
+  for (const auto &box : boxes) {
+    double box_min_x = std::numeric_limits<double>::max();
+    double box_min_y = std::numeric_limits<double>::max();
+    double box_max_x = std::numeric_limits<double>::lowest();
+    double box_max_y = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < 4; ++i) {
+      const auto &corner = box.GetCorner(i);
+      box_min_x = std::min(box_min_x, corner.x());
+      box_min_y = std::min(box_min_y, corner.y());
+      box_max_x = std::max(box_max_x, corner.x());
+      box_max_y = std::max(box_max_y, corner.y());
+    }
+    const int ix_begin = std::max(0, static_cast<int>((box_min_x - disk_radius_ - layer->min_x) / layer->resolution));
+    const int iy_begin = std::max(0, static_cast<int>((box_min_y - disk_radius_ - layer->min_y) / layer->resolution));
+    const int ix_end = std::min(layer->num_cells_x - 1,
+                                static_cast<int>((box_max_x + disk_radius_ - layer->min_x) / layer->resolution));
+    const int iy_end = std::min(layer->num_cells_y - 1,
+                                static_cast<int>((box_max_y + disk_radius_ - layer->min_y) / layer->resolution));
+    for (int iy = iy_begin; iy <= iy_end; ++iy) {
+      for (int ix = ix_begin; ix <= ix_end; ++ix) {
+        const size_t cell = static_cast<size_t>(iy) * layer->num_cells_x + ix;
+        uint64_t &word = words_[layer->word_offset + cell / 64];
+        const uint64_t bit = uint64_t{1} << (cell % 64);
+        if (word & bit) {
+          continue;
+        }
+        Eigen::Vector2d cell_center(layer->min_x + (ix + 0.5) * layer->resolution,
+                                    layer->min_y + (iy + 0.5) * layer->resolution);
+        if (box.DistanceToPoint(cell_center) <= threshold) {
+          word |= bit;
+        }
+      }
+    }
+  }
+}
+
+bool OccupancyBitmap::IsOccupied(const Layer &layer, double x, double y) const {
+  const double fx = (x - layer.min_x) / layer.resolution;
+  const double fy = (y - layer.min_y) / layer.resolution;
+  if (fx < 0.0 || fy < 0.0 || fx >= layer.num_cells_x || fy >= layer.num_cells_y) {
+    return false;
+  }
+  const size_t cell = static_cast<size_t>(fy) * layer.num_cells_x + static_cast<size_t>(fx);
+  return (words_[layer.word_offset + cell / 64] >> (cell % 64)) & 1u;
+}
+
+}
@@ -3,8 +3,13 @@
 #include <obstacle_manager/st_graph.hpp>
 #include <tf/transform_datatypes.h>
 #include <math/coordinate_transformer.hpp>
+#include <thread_pool/thread_pool.hpp>
+#include <random>
+#include "test_fixtures.hpp"
 
 using namespace planning;
+using planning::test::MakeObstacle;
+using planning::test::MakeStraightReferenceLine;
 
 namespace {
 double start_s{2.0};
@@ -15,6 +20,36 @@ std::array<double, 3> init_d{1, 0, 0};
 double lookahead_time{8.0};
 double delta_t{0.1};
 vehicle_state::VehicleParams vehicle_params{};
+
+std::shared_ptr<Obstacle> MakePredictedObstacle(int id, double x, double y, double heading, double speed) {
+  auto obstacle = MakeObstacle(id, x, y, heading, speed);
+  obstacle->PredictTrajectory(lookahead_time, delta_t);
+  return obstacle;
+}
+
+/**
+ * @brief: predicted obstacles heading about +x, in x of [0, 120] and y of [-6, 6]
+ */
+std::vector<std::shared_ptr<Obstacle>> MakeRandomObstacles(unsigned int seed, int num_of_obstacles) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> x(0.0, 120.0);
+  std::uniform_real_distribution<double> y(-6.0, 6.0);
+  std::uniform_real_distribution<double> heading(-0.5, 0.5);
+  std::uniform_real_distribution<double> speed(0.0, 10.0);
+  std::vector<std::shared_ptr<Obstacle>> obstacles;
+  for (int id = 0; id < num_of_obstacles; ++id) {
+    obstacles.push_back(MakePredictedObstacle(id, x(gen), y(gen), heading(gen), speed(gen)));
+  }
+  return obstacles;
+}
+
+std::vector<std::vector<std::pair<double, double>>> GetSortedBlockingIntervals(const STGraph &st_graph) {
+  auto intervals = st_graph.GetPathBlockingIntervals(t_start, t_end, delta_t);
+  for (auto &intervals_at_t : intervals) {
+    std::sort(intervals_at_t.begin(), intervals_at_t.end());
+  }
+  return intervals;
+}
 }
 
 TEST(STGraphTEST, st_graph_build) {
@@ -121,4 +156,99 @@ TEST(STGraphTEST, st_graph_build) {
     std::cout << "ego_trajectory: t: " << tp.relative_time <<  " x: " << tp.path_point.x << ", y: " << tp.path_point.y << std::endl;
   }
 
-}
\ No newline at end of file
+}
+TEST(STGraphTEST, st_graph_reuse) {
+  auto ref_line = MakeStraightReferenceLine(100, 2.0);
+  STGraphCache st_graph_cache(0.1, 0.02);
+  const double cycle_time = 0.1;
+
+  st_graph_cache.BeginCycle(0.0);
+  auto cruising = MakePredictedObstacle(1, 20.0, 0.5, 0.0, 5.0);
+  auto cutting_in = MakePredictedObstacle(2, 40.0, -2.5, 0.3, 3.0);
+  STGraph first_st_graph({cruising, cutting_in}, ref_line, start_s, end_s, t_start, t_end, init_d,
+                         lookahead_time, delta_t, &st_graph_cache);
+  EXPECT_EQ(first_st_graph.NumReusedObstacles(), 0);
+
+  // the cruising obstacle follows its prediction, the other one turned harder than predicted
+  st_graph_cache.BeginCycle(cycle_time);
+  const auto point = cruising->GetPointAtTime(cycle_time);
+  std::vector<std::shared_ptr<Obstacle>> obstacles{
+      MakePredictedObstacle(1, point.path_point.x, point.path_point.y, point.path_point.theta, 5.0),
+      MakePredictedObstacle(2, 40.3, -2.4, 0.5, 3.0)};
+  STGraph reused_st_graph(obstacles, ref_line, start_s + 0.5, end_s + 0.5, t_start, t_end, init_d,
+                          lookahead_time, delta_t, &st_graph_cache);
+  STGraph st_graph(obstacles, ref_line, start_s + 0.5, end_s + 0.5, t_start, t_end, init_d,
+                   lookahead_time, delta_t);
+  EXPECT_EQ(reused_st_graph.NumReusedObstacles(), 1);
+  EXPECT_EQ(st_graph.NumReusedObstacles(), 0);
+
+  const auto reused_intervals = GetSortedBlockingIntervals(reused_st_graph);
+  const auto intervals = GetSortedBlockingIntervals(st_graph);
+  ASSERT_EQ(reused_intervals.size(), intervals.size());
+  for (size_t i = 0; i < intervals.size(); ++i) {
+    ASSERT_EQ(reused_intervals[i].size(), intervals[i].size());
+    for (size_t j = 0; j < intervals[i].size(); ++j) {
+      EXPECT_NEAR(reused_intervals[i][j].first, intervals[i][j].first, 1e-3);
+      EXPECT_NEAR(reused_intervals[i][j].second, intervals[i][j].second, 1e-3);
+    }
+  }
+
+  // nothing is reused after a long pause
+  st_graph_cache.BeginCycle(10.0);
+  STGraph paused_st_graph(obstacles, ref_line, start_s + 0.5, end_s + 0.5, t_start, t_end, init_d,
+                          lookahead_time, delta_t, &st_graph_cache);
+  EXPECT_EQ(paused_st_graph.NumReusedObstacles(), 0);
+}
+
+TEST(STGraphTEST, st_graph_parallel_build) {
+  auto ref_line = MakeStraightReferenceLine(100, 2.0);
+  const auto obstacles = MakeRandomObstacles(3, 40);
+  common::ThreadPool thread_pool(4);
+  STGraph st_graph(obstacles, ref_line, start_s, end_s, t_start, t_end, init_d, lookahead_time, delta_t);
+  for (size_t i = 0; i < 5; ++i) {
+    STGraph parallel_st_graph(obstacles, ref_line, start_s, end_s, t_start, t_end, init_d,
+                              lookahead_time, delta_t, nullptr, &thread_pool);
+    const auto &st_boundaries = st_graph.GetObstaclesSTBoundary();
+    const auto &parallel_st_boundaries = parallel_st_graph.GetObstaclesSTBoundary();
+    ASSERT_FALSE(st_boundaries.empty());
+    ASSERT_EQ(parallel_st_boundaries.size(), st_boundaries.size());
+    for (size_t j = 0; j < st_boundaries.size(); ++j) {
+      EXPECT_EQ(parallel_st_boundaries[j].id(), st_boundaries[j].id());
+      ASSERT_EQ(parallel_st_boundaries[j].lower_points().size(), st_boundaries[j].lower_points().size());
+      for (size_t k = 0; k < st_boundaries[j].lower_points().size(); ++k) {
+        EXPECT_EQ(parallel_st_boundaries[j].lower_points()[k].s(), st_boundaries[j].lower_points()[k].s());
+        EXPECT_EQ(parallel_st_boundaries[j].lower_points()[k].t(), st_boundaries[j].lower_points()[k].t());
+        EXPECT_EQ(parallel_st_boundaries[j].upper_points()[k].s(), st_boundaries[j].upper_points()[k].s());
+      }
+    }
+    for (const auto &obstacle : obstacles) {
+      EXPECT_EQ(parallel_st_graph.IsObstacleInGraph(obstacle->Id()), st_graph.IsObstacleInGraph(obstacle->Id()));
+    }
+  }
+}
+
+TEST(STGraphTEST, st_graph_blocking_interval_table) {
+  auto ref_line = MakeStraightReferenceLine(100, 2.0);
+  const auto obstacles = MakeRandomObstacles(5, 40);
+  STGraph st_graph(obstacles, ref_line, start_s, end_s, t_start, t_end, init_d, lookahead_time, delta_t);
+  const auto &table = st_graph.blocking_intervals();
+  ASSERT_TRUE(table.IsOnGrid(t_start, t_end, delta_t));
+  ASSERT_GT(table.NumIntervals(), 0);
+  // the same intervals in the same order as the ones queried tick by tick
+  size_t num_intervals = 0;
+  for (size_t tick = 0; tick < table.NumTicks(); ++tick) {
+    const auto intervals = st_graph.GetPathBlockingIntervals(table.TickTime(tick));
+    ASSERT_EQ(table.TickBegin(tick + 1) - table.TickBegin(tick), intervals.size());
+    for (size_t k = 0; k < intervals.size(); ++k) {
+      EXPECT_EQ(table.Intervals()[table.TickBegin(tick) + k], intervals[k]);
+      EXPECT_EQ(table.IntervalTicks()[table.TickBegin(tick) + k], tick);
+    }
+    num_intervals += intervals.size();
+  }
+  EXPECT_EQ(num_intervals, table.NumIntervals());
+  // off the grid of the st graph
+  BlockingIntervalTable coarse_table(st_graph.GetObstaclesSTBoundary(), t_start, 4.0, 0.5);
+  EXPECT_FALSE(coarse_table.IsOnGrid(t_start, t_end, delta_t));
+  const auto coarse_intervals = st_graph.GetPathBlockingIntervals(t_start, 4.0, 0.5);
+  EXPECT_EQ(coarse_table.GetPathBlockingIntervals(), coarse_intervals);
+}
@@ -0,0 +1,118 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COLLISION_CHECKER_SRC_COLLISION_CHECKER_TEST_FIXTURES_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COLLISION_CHECKER_SRC_COLLISION_CHECKER_TEST_FIXTURES_HPP_
+#include <derived_object_msgs/Object.h>
+#include <planning_msgs/WayPoint.h>
+#include <tf/transform_datatypes.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "obstacle_manager/obstacle.hpp"
+#include "reference_line/reference_line.hpp"
+
+namespace planning {
+namespace test {
+
+/**
+ * @brief: a straight reference line along +x from (0, 0)
+ * @param number_of_waypoints
+ * @param ds: the distance between the way points
+ * @return
+ */
+inline ReferenceLine MakeStraightReferenceLine(size_t number_of_waypoints, double ds) {
+  std::vector<planning_msgs::WayPoint> way_points;
+  planning_msgs::WayPoint way_point;
+  for (size_t i = 0; i < number_of_waypoints; ++i) {
+    way_point.s = ds * i;
+    way_point.pose.position.x = ds * i;
+    way_point.pose.position.y = 0.0;
+    way_point.pose.position.z = 0.0;
+    way_point.pose.orientation = tf::createQuaternionMsgFromYaw(0.0);
+    way_point.lane_width = 3.5;
+    way_point.lane_id = 1;
+    way_point.section_id = 1;
+    way_point.road_id = 1;
+    way_point.id = i;
+    way_point.has_left_lane = false;
+    way_point.has_right_lane = false;
+    way_point.has_value = true;
+    way_point.is_junction = false;
+    way_points.push_back(way_point);
+  }
+  return ReferenceLine(way_points);
+}
+
+/**
+ * @brief: a quarter circle of radius 50 m from (0, 0), heading to +x at first
+ * @param number_of_waypoints
+ * @return
+ */
+inline ReferenceLine MakeArcReferenceLine(size_t number_of_waypoints) {
+  constexpr double kRadius = 50.0;
+  std::vector<planning_msgs::WayPoint> way_points;
+  planning_msgs::WayPoint way_point;
+  for (size_t i = 0; i < number_of_waypoints; ++i) {
+    const double angle = 0.5 * M_PI * i / (number_of_waypoints - 1);
+    way_point.s = kRadius * angle;
+    way_point.pose.position.x = kRadius * std::sin(angle);
+    way_point.pose.position.y = kRadius * (1.0 - std::cos(angle));
+    way_point.pose.position.z = 0.0;
+    way_point.pose.orientation = tf::createQuaternionMsgFromYaw(angle);
+    way_point.lane_width = 3.5;
+    way_point.lane_id = 1;
+    way_point.section_id = 1;
+    way_point.road_id = 1;
+    way_point.id = i;
+    way_point.has_left_lane = false;
+    way_point.has_right_lane = false;
+    way_point.has_value = true;
+    way_point.is_junction = false;
+    way_points.push_back(way_point);
+  }
+  return ReferenceLine(way_points);
+}
+
+/**
+ * @brief: a 4 m x 2 m car moving along its heading
+ * @param id
+ * @param x, y: the center
+ * @param heading
+ * @param speed
+ * @param yaw_rate
+ * @return
+ */
+inline derived_object_msgs::Object MakeObject(int id, double x, double y, double heading, double speed,
+                                              double yaw_rate = 0.0) {
+  derived_object_msgs::Object object;
+  object.object_classified = derived_object_msgs::Object::OBJECT_DETECTED;
+  object.classification = derived_object_msgs::Object::CLASSIFICATION_CAR;
+  object.shape.type = shape_msgs::SolidPrimitive::BOX;
+  object.shape.dimensions.resize(3);
+  object.shape.dimensions[0] = 4.0;
+  object.shape.dimensions[1] = 2.0;
+  object.shape.dimensions[2] = 1.5;
+  object.pose.position.x = x;
+  object.pose.position.y = y;
+  object.pose.position.z = 0.0;
+  object.id = id;
+  object.twist.linear.x = speed * std::cos(heading);
+  object.twist.linear.y = speed * std::sin(heading);
+  object.twist.linear.z = 0.0;
+  object.twist.angular.x = object.twist.angular.y = 0.0;
+  object.twist.angular.z = yaw_rate;
+  object.pose.orientation = tf::createQuaternionMsgFromYaw(heading);
+  object.accel.linear.x = object.accel.linear.y = object.accel.linear.z = object.accel.angular.x =
+  object.accel.angular.y = object.accel.angular.z = 0.0;
+  return object;
+}
+
+/**
+ * @brief: the obstacle of MakeObject, not predicted
+ */
+inline std::shared_ptr<Obstacle> MakeObstacle(int id, double x, double y, double heading, double speed,
+                                              double yaw_rate = 0.0) {
+  return std::make_shared<Obstacle>(MakeObject(id, x, y, heading, speed, yaw_rate));
+}
+
+}
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COLLISION_CHECKER_SRC_COLLISION_CHECKER_TEST_FIXTURES_HPP_
@@ -1,7 +1,8 @@
 #ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_COMMON_POLYNOMIAL_HPP_
 #define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_COMMON_POLYNOMIAL_HPP_
-#include <vector>
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 namespace common{
 class Polynomial {
  public:
@@ -12,6 +13,16 @@ class Polynomial {
   virtual size_t Order() const = 0;
   virtual double Coef(size_t order) const = 0;
 
+  /**
+   * @brief: the exact min and max of the order-th derivative over [begin, end], found at the ends and at
+   * the real roots of the (order + 1)-th derivative, so extrema between samples are not missed.
+   * @param order: the derivative order
+   * @param begin, end: the interval, within [0, ParamLength()]
+   * @param[out] min_value
+   * @param[out] max_value
+   */
+  void DerivativeBounds(size_t order, double begin, double end, double *min_value, double *max_value) const;
+
  protected:
   double param_ = 0.0;
   size_t order_ = 0;
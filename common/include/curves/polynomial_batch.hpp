@@ -0,0 +1,89 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_COMMON_POLYNOMIAL_BATCH_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_COMMON_POLYNOMIAL_BATCH_HPP_
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "curves/polynomial.hpp"
+namespace common {
+
+/**
+ * @brief: a batch of polynomials (order <= 5) stored in SoA layout, evaluated together over a param grid.
+ * Past its param length, a polynomial can be extrapolated with constant acceleration, the same way as
+ * LatticeTrajectory1d does.
+ */
+class PolynomialBatch {
+ public:
+  static constexpr size_t kMaxOrder = 5;
+  // position, velocity, acceleration and jerk
+  static constexpr size_t kNumDerivatives = 4;
+
+  PolynomialBatch() = default;
+  ~PolynomialBatch() = default;
+
+  void Reserve(size_t num_polynomials);
+
+  void Clear();
+
+  /**
+   * @brief: add a polynomial to the batch
+   * @param polynomial: polynomial of order <= 5
+   * @param extrapolate: extrapolate with constant acceleration past the param length
+   * @return: the index of the polynomial in the batch
+   */
+  size_t AddPolynomial(const Polynomial &polynomial, bool extrapolate);
+
+  size_t Size() const { return param_lengths_.size(); }
+
+  /**
+   * @brief: evaluate p, v, a and jerk of every polynomial at every param,
+   * uses the avx2 kernel when the cpu supports it
+   * @param params: the param grid
+   */
+  void Evaluate(const std::vector<double> &params);
+
+  /**
+   * @brief: same as Evaluate, but always uses the scalar kernel
+   * @param params
+   */
+  void EvaluateScalar(const std::vector<double> &params);
+
+  size_t NumParams() const { return num_params_; }
+
+  /**
+   * @brief: the evaluated values of a polynomial, NumParams() values
+   * @param order: 0 to 3
+   * @param index: the index of the polynomial
+   * @return
+   */
+  const double *Samples(size_t order, size_t index) const {
+    return samples_[order].data() + index * num_params_;
+  }
+
+  double Sample(size_t order, size_t index, size_t param_index) const {
+    return samples_[order][index * num_params_ + param_index];
+  }
+
+  double ParamLength(size_t index) const { return param_lengths_[index]; }
+
+  static bool HasAvx2();
+
+ private:
+  void Resize(size_t num_params);
+  void EvaluateScalar(size_t index, const double *params, size_t begin, size_t end);
+  void EvaluateAvx2(size_t index, const double *params, size_t num_params);
+
+ private:
+  // coefs_[i][n] is the coef of x^i of the n-th polynomial
+  std::array<std::vector<double>, kMaxOrder + 1> coefs_;
+  std::vector<double> param_lengths_;
+  std::vector<char> extrapolate_;
+  // p, v, a at the param length
+  std::array<std::vector<double>, 3> end_states_;
+
+  size_t num_params_ = 0;
+  // samples_[order][n * num_params_ + k]
+  std::array<std::vector<double>, kNumDerivatives> samples_;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_COMMON_POLYNOMIAL_BATCH_HPP_
@@ -65,6 +65,23 @@ class Spline2d {
                                double *const nearest_y,
                                double *const nearest_s) const;
 
+  /**
+   * @brief: get the nearest point on spline curve, starting from the knot around s_hint, for repeated
+   * projections of nearby points, e.g. the s of the previous projection. the result is the same as without the hint,
+   * the hint only bounds the grid search
+   * @param x
+   * @param y
+   * @param s_hint: the guess of the nearest s
+   * @param nearest_x
+   * @param nearest_y
+   * @param nearest_s
+   * @return
+   */
+  bool GetNearestPointOnSpline(double x, double y, double s_hint,
+                               double *const nearest_x,
+                               double *const nearest_y,
+                               double *const nearest_s) const;
+
  private:
   /**
    * @brief: calc arc length
@@ -147,13 +164,51 @@ class Spline2d {
   static double Clamp(double t, double lb, double ub);
 
   /**
-   * @brief: calc the nearest index
+   * @brief: calc the nearest index, searches the grid rings around (x, y)
    * @param x
    * @param y
    * @return
    */
   int CalcNearestIndex(double x, double y) const;
 
+  /**
+   * @brief: calc the nearest index given a knot at dist, searches only the cells within dist of (x, y)
+   * @param x
+   * @param y
+   * @param index: a knot at dist from (x, y)
+   * @param dist
+   * @return
+   */
+  int CalcNearestIndexWithin(double x, double y, int index, double dist) const;
+
+  /**
+   * @brief: calc the nearest index by scanning every knot
+   * @param x
+   * @param y
+   * @return
+   */
+  int CalcNearestIndexLinear(double x, double y) const;
+
+  /**
+   * @brief: bucket the knots into a uniform grid
+   */
+  void BuildSpatialIndex();
+
+  /**
+   * @brief: refine the nearest point from the nearest knot
+   * @param x
+   * @param y
+   * @param min_index: the nearest knot
+   * @param nearest_x
+   * @param nearest_y
+   * @param nearest_s
+   * @return
+   */
+  bool RefineNearestPoint(double x, double y, int min_index,
+                          double *const nearest_x,
+                          double *const nearest_y,
+                          double *const nearest_s) const;
+
  private:
   std::vector<double> xs_;
   std::vector<double> ys_;
@@ -162,6 +217,15 @@ class Spline2d {
   spline y_spline_;
   double arc_length_ = 0.0;
   std::vector<double> chord_lengths_;
+  // uniform grid over the knots, the knots of cell k = iy * num_cells_x_ + ix are
+  // cell_knot_indices_[cell_starts_[k], cell_starts_[k + 1]), sorted by index
+  double grid_min_x_ = 0.0;
+  double grid_min_y_ = 0.0;
+  double cell_size_ = 1.0;
+  int num_cells_x_ = 0;
+  int num_cells_y_ = 0;
+  std::vector<size_t> cell_starts_;
+  std::vector<int> cell_knot_indices_;
 };
 }
 #endif //CATKIN_WS_SRC_LOCAL_PLANNER_COMMON_INCLUDE_SPLINE2D_HPP_
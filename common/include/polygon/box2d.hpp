@@ -2,6 +2,8 @@
 #define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_COMMON_BOX2D_HPP_
 //from apollo
 #include <Eigen/Core>
+#include <array>
+#include <limits>
 #include <vector>
 
 namespace common {
@@ -24,6 +26,12 @@ class Box2d {
   // the diagonal length
   double diagonal() const;
   std::vector<Eigen::Vector2d> GetAllCorners() const;
+  /**
+   * @brief: the index-th corner without copying the corners, counter-clockwise from the front right one
+   * @param index: 0 to 3
+   * @return
+   */
+  const Eigen::Vector2d &GetCorner(size_t index) const;
   bool IsPointIn(const Eigen::Vector2d &point) const;
   bool IsPointOnBoundary(const Eigen::Vector2d &point) const;
   double DistanceToPoint(const Eigen::Vector2d &poiny) const;
@@ -39,7 +47,7 @@ class Box2d {
   double min_y() const;
 
  private:
-  Eigen::Vector2d center_;
+  Eigen::Vector2d center_ = Eigen::Vector2d::Zero();
   double heading_ = 0.0;
   double length_ = 0.0;
   double width_ = 0.0;
@@ -48,7 +56,9 @@ class Box2d {
 
   double cos_heading_ = 1.0;
   double sin_heading_ = 0.0;
-  std::vector<Eigen::Vector2d> corners_;
+  // inline, so building a box doesn't allocate
+  std::array<Eigen::Vector2d, 4> corners_{{Eigen::Vector2d::Zero(), Eigen::Vector2d::Zero(),
+                                           Eigen::Vector2d::Zero(), Eigen::Vector2d::Zero()}};
   double max_x_ = std::numeric_limits<double>::lowest();
   double min_x_ = std::numeric_limits<double>::max();
   double max_y_ = std::numeric_limits<double>::lowest();
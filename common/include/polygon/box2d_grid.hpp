@@ -0,0 +1,73 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_POLYGON_BOX2D_GRID_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_POLYGON_BOX2D_GRID_HPP_
+#include <vector>
+#include "polygon/box2d.hpp"
+#include "polygon/box_set.hpp"
+
+namespace common {
+
+/**
+ * @brief: broadphase over a static set of boxes, e.g. the predicted obstacle boxes at one time step.
+ * the axis aligned bounding boxes are bucketed into a uniform grid, an overlap query only runs the
+ * separating axis test against the boxes sharing a cell with the query box, a cell at a time with BoxSet.
+ * a box is bucketed into every cell its bounding box touches, so a box sharing several cells with the query box
+ * is tested once per shared cell: the batch test of a cell costs the same with or without it.
+ */
+class Box2dGrid {
+ public:
+  Box2dGrid() = default;
+  ~Box2dGrid() = default;
+
+  /**
+   * @param boxes: the boxes to index
+   * @param cell_size: the grid resolution, non-positive to derive it from the box sizes
+   */
+  explicit Box2dGrid(std::vector<Box2d> boxes, double cell_size = 0.0);
+
+  const std::vector<Box2d> &boxes() const { return boxes_; }
+
+  size_t NumBoxes() const { return boxes_.size(); }
+
+  bool Empty() const { return boxes_.empty(); }
+
+  /**
+   * @brief: same as checking box.HasOverlapWithBox2d against every indexed box
+   * @param box
+   * @return: true if the box overlaps with any indexed box
+   */
+  bool HasOverlapWithBox2d(const Box2d &box) const;
+
+  /**
+   * @brief: only the indexed boxes enabled in box_mask are checked
+   * @param box
+   * @param box_mask: box_mask[k] for boxes()[k]
+   * @return: true if the box overlaps with any enabled box
+   */
+  bool HasOverlapWithBox2d(const Box2d &box, const std::vector<bool> &box_mask) const;
+
+ private:
+  bool HasOverlapWithBox2d(const Box2d &box, const std::vector<bool> *box_mask) const;
+
+  int CellX(double x) const;
+
+  int CellY(double y) const;
+
+  void BuildGrid(double cell_size);
+
+ private:
+  std::vector<Box2d> boxes_;
+  // the boxes of cell k = iy * num_cells_x_ + ix are
+  // cell_box_indices_[cell_starts_[k], cell_starts_[k + 1]), sorted by index,
+  // cell_boxes_ holds the same boxes in the same order
+  double grid_min_x_ = 0.0;
+  double grid_min_y_ = 0.0;
+  double cell_size_ = 1.0;
+  int num_cells_x_ = 0;
+  int num_cells_y_ = 0;
+  std::vector<size_t> cell_starts_;
+  std::vector<size_t> cell_box_indices_;
+  BoxSet cell_boxes_;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_POLYGON_BOX2D_GRID_HPP_
@@ -0,0 +1,82 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_POLYGON_BOX_SET_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_POLYGON_BOX_SET_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "polygon/box2d.hpp"
+
+namespace common {
+
+/**
+ * @brief: boxes stored in SoA layout, one box is checked against many boxes per call. the avx2 kernel
+ * checks four boxes at a time, with the same operations as Box2d::HasOverlapWithBox2d, so the results
+ * are the same as checking the boxes one by one.
+ */
+class BoxSet {
+ public:
+  // the max number of boxes of one OverlapBits call
+  static constexpr size_t kMaxBitsBoxes = 64;
+
+  BoxSet() = default;
+  ~BoxSet() = default;
+
+  explicit BoxSet(const std::vector<Box2d> &boxes);
+
+  void Reserve(size_t num_boxes);
+
+  void Clear();
+
+  /**
+   * @brief: add a box to the set
+   * @param box
+   * @return: the index of the box in the set
+   */
+  size_t AddBox(const Box2d &box);
+
+  size_t Size() const { return center_x_.size(); }
+
+  /**
+   * @brief: same as box.HasOverlapWithBox2d(other) for the boxes [begin, end) of the set
+   * @param box
+   * @param begin
+   * @param end: end - begin <= kMaxBitsBoxes
+   * @return: bit k is set if box overlaps with the (begin + k)-th box
+   */
+  uint64_t OverlapBits(const Box2d &box, size_t begin, size_t end) const;
+
+  /**
+   * @brief: same as above, but always uses the scalar kernel
+   */
+  uint64_t OverlapBitsScalar(const Box2d &box, size_t begin, size_t end) const;
+
+  /**
+   * @param box
+   * @return: true if the box overlaps with any box of the set
+   */
+  bool HasOverlapWithBox2d(const Box2d &box) const;
+
+  static bool HasAvx2();
+
+ private:
+  uint64_t OverlapBitsAvx2(const Box2d &box, size_t begin, size_t end) const;
+
+ private:
+  std::vector<double> center_x_;
+  std::vector<double> center_y_;
+  std::vector<double> cos_heading_;
+  std::vector<double> sin_heading_;
+  std::vector<double> half_length_;
+  std::vector<double> half_width_;
+  // the half length and half width vectors, rotated by the heading
+  std::vector<double> length_dx_;
+  std::vector<double> length_dy_;
+  std::vector<double> width_dx_;
+  std::vector<double> width_dy_;
+  std::vector<double> min_x_;
+  std::vector<double> max_x_;
+  std::vector<double> min_y_;
+  std::vector<double> max_y_;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_POLYGON_BOX_SET_HPP_
@@ -1,6 +1,8 @@
 #ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_COMMON_THREAD_POOL_HPP_
 #define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_COMMON_INCLUDE_COMMON_THREAD_POOL_HPP_
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <future>
@@ -26,6 +28,12 @@ class ThreadPool {
   std::future<typename std::result_of<Func(Args...)>::type> PushTask(
       Func &&f, Args &&... args);
 
+  // Call func(i) for every i in [0, n) on the pool and the calling thread, return once every call is done.
+  // The indices are claimed one at a time by the pool tasks and the calling thread alike, the calling thread
+  // only waits for the calls running, never for a task still in the queue. So it's safe to call from a pool
+  // worker, a task starting after every index is claimed returns at once.
+  void ParallelFor(size_t n, const std::function<void(size_t)> &func);
+
  private:
   int pool_size_;
   bool shutdown_;
@@ -82,6 +90,41 @@ std::future<typename std::result_of<Func(Args...)>::type> ThreadPool::PushTask(
   return task_ptr->get_future();
 }
 
+inline void ThreadPool::ParallelFor(size_t n, const std::function<void(size_t)> &func) {
+  if (n == 0) return;
+  // shared with the pool tasks, which may start after this returns
+  struct ParallelForState {
+    std::function<void(size_t)> func;
+    size_t n = 0;
+    std::atomic<size_t> next_index{0};
+    std::atomic<size_t> finished_indices{0};
+    std::mutex mutex;
+    std::condition_variable all_finished;
+  };
+  auto state = std::make_shared<ParallelForState>();
+  state->func = func;
+  state->n = n;
+  const auto run = [state] {
+    while (true) {
+      const size_t index = state->next_index.fetch_add(1);
+      if (index >= state->n) return;
+      state->func(index);
+      if (state->finished_indices.fetch_add(1) + 1 == state->n) {
+        // taking the lock orders the notification after the waiter's check of the counter
+        { std::lock_guard<std::mutex> lck(state->mutex); }
+        state->all_finished.notify_all();
+      }
+    }
+  };
+  const size_t num_tasks = std::min(static_cast<size_t>(pool_size_), n - 1);
+  for (size_t i = 0; i < num_tasks; ++i) {
+    PushTask(run);
+  }
+  run();
+  std::unique_lock<std::mutex> lck(state->mutex);
+  state->all_finished.wait(lck, [&state] { return state->finished_indices.load() == state->n; });
+}
+
 }
 
 #endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_MOTION_PLANNING_COMMON_INCLUDE_THREAD_POOL_HPP_
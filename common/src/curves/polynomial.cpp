@@ -1,5 +1,148 @@
 #include "curves/polynomial.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
 
-namespace common{
+namespace common {
 
-}
\ No newline at end of file
+namespace {
+constexpr size_t kMaxDegree = 7;
+typedef std::array<double, kMaxDegree + 1> Coefs;
+typedef std::array<double, kMaxDegree> Roots;
+
+// sum(c[i] * x^i), i from 0 to degree
+double Horner(const Coefs &c, size_t degree, double x) {
+  double value = c[degree];
+  for (size_t i = degree; i > 0; --i) {
+    value = value * x + c[i - 1];
+  }
+  return value;
+}
+
+void AddRoot(double root, double begin, double end, Roots *roots, size_t *num_roots) {
+  if (root > begin && root < end) {
+    (*roots)[(*num_roots)++] = root;
+  }
+}
+
+/**
+ * @brief: the sorted real roots in (begin, end), the interval is split into monotone pieces at the roots of
+ * the derivative and each piece with a sign change is bisected.
+ */
+void RealRoots(const Coefs &c, size_t degree, double begin, double end, Roots *roots, size_t *num_roots) {
+  *num_roots = 0;
+  while (degree > 0 && c[degree] == 0.0) {
+    --degree;
+  }
+  if (degree == 0) {
+    return;
+  }
+  if (degree == 1) {
+    AddRoot(-c[0] / c[1], begin, end, roots, num_roots);
+    return;
+  }
+  if (degree == 2) {
+    const double discriminant = c[1] * c[1] - 4.0 * c[2] * c[0];
+    if (discriminant < 0.0) {
+      return;
+    }
+    // avoid the cancellation of -b + sqrt(b^2 - 4ac)
+    const double q = -0.5 * (c[1] + std::copysign(std::sqrt(discriminant), c[1]));
+    double x0 = q / c[2];
+    double x1 = q != 0.0 ? c[0] / q : x0;
+    if (x0 > x1) {
+      std::swap(x0, x1);
+    }
+    AddRoot(x0, begin, end, roots, num_roots);
+    if (x1 != x0) {
+      AddRoot(x1, begin, end, roots, num_roots);
+    }
+    return;
+  }
+
+  Coefs derivative{};
+  for (size_t i = 0; i < degree; ++i) {
+    derivative[i] = static_cast<double>(i + 1) * c[i + 1];
+  }
+  Roots critical_points{};
+  size_t num_critical_points = 0;
+  RealRoots(derivative, degree - 1, begin, end, &critical_points, &num_critical_points);
+
+  double left = begin;
+  double left_value = Horner(c, degree, left);
+  for (size_t i = 0; i <= num_critical_points; ++i) {
+    const double right = i < num_critical_points ? critical_points[i] : end;
+    const double right_value = Horner(c, degree, right);
+    if (right_value == 0.0) {
+      if (i < num_critical_points) {
+        AddRoot(right, begin, end, roots, num_roots);
+      }
+    } else if (left_value * right_value < 0.0) {
+      double lo = left;
+      double hi = right;
+      double lo_value = left_value;
+      while (hi - lo > 1e-10) {
+        const double mid = 0.5 * (lo + hi);
+        const double mid_value = Horner(c, degree, mid);
+        if (mid_value == 0.0) {
+          lo = mid;
+          hi = mid;
+          break;
+        }
+        if (lo_value * mid_value < 0.0) {
+          hi = mid;
+        } else {
+          lo = mid;
+          lo_value = mid_value;
+        }
+      }
+      AddRoot(0.5 * (lo + hi), begin, end, roots, num_roots);
+    }
+    left = right;
+    left_value = right_value;
+  }
+}
+}
+
+void Polynomial::DerivativeBounds(size_t order, double begin, double end,
+                                  double *min_value, double *max_value) const {
+  const size_t poly_order = Order();
+  assert(poly_order <= kMaxDegree);
+  if (order > poly_order) {
+    *min_value = 0.0;
+    *max_value = 0.0;
+    return;
+  }
+  // coefs of the order-th derivative
+  const size_t degree = poly_order - order;
+  Coefs derivative{};
+  for (size_t i = 0; i <= degree; ++i) {
+    double factor = 1.0;
+    for (size_t k = i + 1; k <= i + order; ++k) {
+      factor *= static_cast<double>(k);
+    }
+    derivative[i] = factor * Coef(i + order);
+  }
+  *min_value = std::min(Horner(derivative, degree, begin), Horner(derivative, degree, end));
+  *max_value = std::max(Horner(derivative, degree, begin), Horner(derivative, degree, end));
+  if (degree < 2) {
+    return;
+  }
+
+  // the extrema inside are at the roots of the (order + 1)-th derivative
+  Coefs next_derivative{};
+  for (size_t i = 0; i < degree; ++i) {
+    next_derivative[i] = static_cast<double>(i + 1) * derivative[i + 1];
+  }
+  Roots roots{};
+  size_t num_roots = 0;
+  RealRoots(next_derivative, degree - 1, begin, end, &roots, &num_roots);
+  for (size_t i = 0; i < num_roots; ++i) {
+    const double value = Horner(derivative, degree, roots[i]);
+    *min_value = std::min(*min_value, value);
+    *max_value = std::max(*max_value, value);
+  }
+}
+
+}
@@ -0,0 +1,216 @@
+#include <cassert>
+#include "curves/polynomial_batch.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define POLYNOMIAL_BATCH_HAS_AVX2_KERNEL 1
+#else
+#define POLYNOMIAL_BATCH_HAS_AVX2_KERNEL 0
+#endif
+
+namespace common {
+
+constexpr size_t PolynomialBatch::kMaxOrder;
+constexpr size_t PolynomialBatch::kNumDerivatives;
+
+namespace {
+// same operation order as QuinticPolynomial::Evaluate, which gives the same result
+// as QuarticPolynomial::Evaluate when c5 = 0
+inline double EvaluatePosition(const double *c, double p) {
+  return ((((c[5] * p + c[4]) * p + c[3]) * p + c[2]) * p + c[1]) * p + c[0];
+}
+inline double EvaluateVelocity(const double *c, double p) {
+  return (((5.0 * c[5] * p + 4.0 * c[4]) * p + 3.0 * c[3]) * p + 2.0 * c[2]) * p + c[1];
+}
+inline double EvaluateAcceleration(const double *c, double p) {
+  return (((20.0 * c[5] * p + 12.0 * c[4]) * p) + 6.0 * c[3]) * p + 2.0 * c[2];
+}
+inline double EvaluateJerk(const double *c, double p) {
+  return (60.0 * c[5] * p + 24.0 * c[4]) * p + 6.0 * c[3];
+}
+}
+
+void PolynomialBatch::Reserve(size_t num_polynomials) {
+  for (auto &coef : coefs_) {
+    coef.reserve(num_polynomials);
+  }
+  for (auto &end_state : end_states_) {
+    end_state.reserve(num_polynomials);
+  }
+  param_lengths_.reserve(num_polynomials);
+  extrapolate_.reserve(num_polynomials);
+}
+
+void PolynomialBatch::Clear() {
+  for (auto &coef : coefs_) {
+    coef.clear();
+  }
+  for (auto &end_state : end_states_) {
+    end_state.clear();
+  }
+  param_lengths_.clear();
+  extrapolate_.clear();
+  num_params_ = 0;
+}
+
+size_t PolynomialBatch::AddPolynomial(const Polynomial &polynomial, bool extrapolate) {
+  assert(polynomial.Order() <= kMaxOrder);
+  std::array<double, kMaxOrder + 1> c{};
+  for (size_t i = 0; i <= polynomial.Order(); ++i) {
+    c[i] = polynomial.Coef(i);
+  }
+  for (size_t i = 0; i <= kMaxOrder; ++i) {
+    coefs_[i].push_back(c[i]);
+  }
+  const double param_length = polynomial.ParamLength();
+  param_lengths_.push_back(param_length);
+  extrapolate_.push_back(extrapolate);
+  end_states_[0].push_back(EvaluatePosition(c.data(), param_length));
+  end_states_[1].push_back(EvaluateVelocity(c.data(), param_length));
+  end_states_[2].push_back(EvaluateAcceleration(c.data(), param_length));
+  return param_lengths_.size() - 1;
+}
+
+void PolynomialBatch::Resize(size_t num_params) {
+  num_params_ = num_params;
+  for (auto &samples : samples_) {
+    samples.resize(num_params_ * Size());
+  }
+}
+
+void PolynomialBatch::Evaluate(const std::vector<double> &params) {
+  if (!HasAvx2()) {
+    EvaluateScalar(params);
+    return;
+  }
+  Resize(params.size());
+  for (size_t n = 0; n < Size(); ++n) {
+    EvaluateAvx2(n, params.data(), params.size());
+  }
+}
+
+void PolynomialBatch::EvaluateScalar(const std::vector<double> &params) {
+  Resize(params.size());
+  for (size_t n = 0; n < Size(); ++n) {
+    EvaluateScalar(n, params.data(), 0, params.size());
+  }
+}
+
+void PolynomialBatch::EvaluateScalar(size_t index, const double *params, size_t begin, size_t end) {
+  const double c[kMaxOrder + 1] = {coefs_[0][index], coefs_[1][index], coefs_[2][index],
+                                   coefs_[3][index], coefs_[4][index], coefs_[5][index]};
+  const double param_length = param_lengths_[index];
+  const bool extrapolate = extrapolate_[index];
+  const double end_p = end_states_[0][index];
+  const double end_v = end_states_[1][index];
+  const double end_a = end_states_[2][index];
+  double *p_samples = samples_[0].data() + index * num_params_;
+  double *v_samples = samples_[1].data() + index * num_params_;
+  double *a_samples = samples_[2].data() + index * num_params_;
+  double *j_samples = samples_[3].data() + index * num_params_;
+  for (size_t k = begin; k < end; ++k) {
+    const double p = params[k];
+    if (!extrapolate || p < param_length) {
+      p_samples[k] = EvaluatePosition(c, p);
+      v_samples[k] = EvaluateVelocity(c, p);
+      a_samples[k] = EvaluateAcceleration(c, p);
+      j_samples[k] = EvaluateJerk(c, p);
+    } else {
+      const double t = p - param_length;
+      p_samples[k] = end_p + end_v * t + 0.5 * end_a * t * t;
+      v_samples[k] = end_v + end_a * t;
+      a_samples[k] = end_a;
+      j_samples[k] = 0.0;
+    }
+  }
+}
+
+#if POLYNOMIAL_BATCH_HAS_AVX2_KERNEL
+
+bool PolynomialBatch::HasAvx2() {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+}
+
+// mul and add are kept separate (no fma), so the results are bit-identical to the scalar kernel
+__attribute__((target("avx2")))
+void PolynomialBatch::EvaluateAvx2(size_t index, const double *params, size_t num_params) {
+  const __m256d c0 = _mm256_set1_pd(coefs_[0][index]);
+  const __m256d c1 = _mm256_set1_pd(coefs_[1][index]);
+  const __m256d c2 = _mm256_set1_pd(coefs_[2][index]);
+  const __m256d c3 = _mm256_set1_pd(coefs_[3][index]);
+  const __m256d c4 = _mm256_set1_pd(coefs_[4][index]);
+  const __m256d c5 = _mm256_set1_pd(coefs_[5][index]);
+  const __m256d dc2 = _mm256_set1_pd(2.0 * coefs_[2][index]);
+  const __m256d dc3 = _mm256_set1_pd(3.0 * coefs_[3][index]);
+  const __m256d dc4 = _mm256_set1_pd(4.0 * coefs_[4][index]);
+  const __m256d dc5 = _mm256_set1_pd(5.0 * coefs_[5][index]);
+  const __m256d ddc3 = _mm256_set1_pd(6.0 * coefs_[3][index]);
+  const __m256d ddc4 = _mm256_set1_pd(12.0 * coefs_[4][index]);
+  const __m256d ddc5 = _mm256_set1_pd(20.0 * coefs_[5][index]);
+  const __m256d dddc4 = _mm256_set1_pd(24.0 * coefs_[4][index]);
+  const __m256d dddc5 = _mm256_set1_pd(60.0 * coefs_[5][index]);
+  const __m256d param_length = _mm256_set1_pd(param_lengths_[index]);
+  const __m256d end_p = _mm256_set1_pd(end_states_[0][index]);
+  const __m256d end_v = _mm256_set1_pd(end_states_[1][index]);
+  const __m256d half_end_a = _mm256_set1_pd(0.5 * end_states_[2][index]);
+  const __m256d end_a = _mm256_set1_pd(end_states_[2][index]);
+  const __m256d zero = _mm256_setzero_pd();
+  const bool extrapolate = extrapolate_[index];
+  double *p_samples = samples_[0].data() + index * num_params_;
+  double *v_samples = samples_[1].data() + index * num_params_;
+  double *a_samples = samples_[2].data() + index * num_params_;
+  double *j_samples = samples_[3].data() + index * num_params_;
+
+  size_t k = 0;
+  for (; k + 4 <= num_params; k += 4) {
+    const __m256d p = _mm256_loadu_pd(params + k);
+    __m256d pos = _mm256_add_pd(_mm256_mul_pd(c5, p), c4);
+    pos = _mm256_add_pd(_mm256_mul_pd(pos, p), c3);
+    pos = _mm256_add_pd(_mm256_mul_pd(pos, p), c2);
+    pos = _mm256_add_pd(_mm256_mul_pd(pos, p), c1);
+    pos = _mm256_add_pd(_mm256_mul_pd(pos, p), c0);
+
+    __m256d vel = _mm256_add_pd(_mm256_mul_pd(dc5, p), dc4);
+    vel = _mm256_add_pd(_mm256_mul_pd(vel, p), dc3);
+    vel = _mm256_add_pd(_mm256_mul_pd(vel, p), dc2);
+    vel = _mm256_add_pd(_mm256_mul_pd(vel, p), c1);
+
+    __m256d acc = _mm256_add_pd(_mm256_mul_pd(ddc5, p), ddc4);
+    acc = _mm256_add_pd(_mm256_mul_pd(acc, p), ddc3);
+    acc = _mm256_add_pd(_mm256_mul_pd(acc, p), dc2);
+
+    __m256d jerk = _mm256_add_pd(_mm256_mul_pd(dddc5, p), dddc4);
+    jerk = _mm256_add_pd(_mm256_mul_pd(jerk, p), ddc3);
+
+    if (extrapolate) {
+      const __m256d t = _mm256_sub_pd(p, param_length);
+      const __m256d ext_pos = _mm256_add_pd(_mm256_add_pd(end_p, _mm256_mul_pd(end_v, t)),
+                                            _mm256_mul_pd(_mm256_mul_pd(half_end_a, t), t));
+      const __m256d ext_vel = _mm256_add_pd(end_v, _mm256_mul_pd(end_a, t));
+      // lanes with p < param_length keep the polynomial values
+      const __m256d in_range = _mm256_cmp_pd(p, param_length, _CMP_LT_OQ);
+      pos = _mm256_blendv_pd(ext_pos, pos, in_range);
+      vel = _mm256_blendv_pd(ext_vel, vel, in_range);
+      acc = _mm256_blendv_pd(end_a, acc, in_range);
+      jerk = _mm256_blendv_pd(zero, jerk, in_range);
+    }
+    _mm256_storeu_pd(p_samples + k, pos);
+    _mm256_storeu_pd(v_samples + k, vel);
+    _mm256_storeu_pd(a_samples + k, acc);
+    _mm256_storeu_pd(j_samples + k, jerk);
+  }
+  EvaluateScalar(index, params, k, num_params);
+}
+
+#else
+
+bool PolynomialBatch::HasAvx2() { return false; }
+
+void PolynomialBatch::EvaluateAvx2(size_t index, const double *params, size_t num_params) {
+  EvaluateScalar(index, params, 0, num_params);
+}
+
+#endif
+
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include "curves/polynomial_batch.hpp"
+#include "curves/quartic_polynomial.hpp"
+#include "curves/quintic_polynomial.hpp"
+
+namespace common {
+
+namespace {
+// random quartic and quintic polynomials, alternately
+std::vector<std::shared_ptr<Polynomial>> MakeRandomPolynomials(unsigned seed, size_t num) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> state_dist(-20.0, 20.0);
+  std::uniform_real_distribution<double> length_dist(0.5, 8.0);
+  std::vector<std::shared_ptr<Polynomial>> polynomials;
+  for (size_t i = 0; i < num; ++i) {
+    const std::array<double, 3> start{state_dist(generator), state_dist(generator), state_dist(generator)};
+    const std::array<double, 3> end{state_dist(generator), state_dist(generator), state_dist(generator)};
+    const double param_length = length_dist(generator);
+    if (i % 2 == 0) {
+      polynomials.push_back(std::make_shared<QuarticPolynomial>(start[0], start[1], start[2], end[1], end[2],
+                                                                param_length));
+    } else {
+      polynomials.push_back(std::make_shared<QuinticPolynomial>(start, end, param_length));
+    }
+  }
+  return polynomials;
+}
+
+// the expected value at p, extrapolated with constant acceleration past the param length
+double ExpectedSample(const Polynomial &polynomial, bool extrapolate, size_t order, double p) {
+  const double param_length = polynomial.ParamLength();
+  if (!extrapolate || p < param_length) {
+    return polynomial.Evaluate(order, p);
+  }
+  const double t = p - param_length;
+  const double end_p = polynomial.Evaluate(0, param_length);
+  const double end_v = polynomial.Evaluate(1, param_length);
+  const double end_a = polynomial.Evaluate(2, param_length);
+  switch (order) {
+    case 0:return end_p + end_v * t + 0.5 * end_a * t * t;
+    case 1:return end_v + end_a * t;
+    case 2:return end_a;
+    default:return 0.0;
+  }
+}
+}
+
+TEST(PolynomialBatchTest, kernels_match_polynomials) {
+  const auto polynomials = MakeRandomPolynomials(3, 40);
+  PolynomialBatch batch;
+  for (size_t n = 0; n < polynomials.size(); ++n) {
+    EXPECT_EQ(batch.AddPolynomial(*polynomials[n], n % 4 < 2), n);
+  }
+  PolynomialBatch scalar_batch = batch;
+  std::mt19937 generator(5);
+  std::uniform_real_distribution<double> param_dist(0.0, 10.0);
+  // every tail length of the 4 wide kernel, and a grid past the param lengths
+  for (size_t num_params = 0; num_params <= 13; ++num_params) {
+    std::vector<double> params(num_params);
+    for (auto &param : params) {
+      param = param_dist(generator);
+    }
+    batch.Evaluate(params);
+    scalar_batch.EvaluateScalar(params);
+    ASSERT_EQ(batch.NumParams(), num_params);
+    ASSERT_EQ(scalar_batch.NumParams(), num_params);
+    for (size_t n = 0; n < polynomials.size(); ++n) {
+      const bool extrapolate = n % 4 < 2;
+      for (size_t k = 0; k < num_params; ++k) {
+        for (size_t order = 0; order < PolynomialBatch::kNumDerivatives; ++order) {
+          const double sample = batch.Sample(order, n, k);
+          // the avx2 kernel does not fuse mul and add, it equals the scalar kernel bit for bit
+          EXPECT_EQ(sample, scalar_batch.Sample(order, n, k))
+                << "n: " << n << ", k: " << k << ", order: " << order;
+          const double expected = ExpectedSample(*polynomials[n], extrapolate, order, params[k]);
+          EXPECT_NEAR(sample, expected, 1e-9 * (1.0 + std::fabs(expected)))
+                << "n: " << n << ", p: " << params[k] << ", order: " << order;
+        }
+      }
+    }
+  }
+}
+
+TEST(PolynomialBatchTest, samples_layout) {
+  const auto polynomials = MakeRandomPolynomials(7, 3);
+  PolynomialBatch batch;
+  for (const auto &polynomial : polynomials) {
+    batch.AddPolynomial(*polynomial, false);
+  }
+  std::vector<double> params;
+  for (double p = 0.0; p < 3.0; p += 0.1) {
+    params.push_back(p);
+  }
+  batch.Evaluate(params);
+  for (size_t n = 0; n < polynomials.size(); ++n) {
+    EXPECT_DOUBLE_EQ(batch.ParamLength(n), polynomials[n]->ParamLength());
+    for (size_t order = 0; order < PolynomialBatch::kNumDerivatives; ++order) {
+      const double *samples = batch.Samples(order, n);
+      for (size_t k = 0; k < params.size(); ++k) {
+        EXPECT_EQ(samples[k], batch.Sample(order, n, k));
+      }
+    }
+  }
+  batch.Clear();
+  EXPECT_EQ(batch.Size(), 0);
+  EXPECT_EQ(batch.NumParams(), 0);
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
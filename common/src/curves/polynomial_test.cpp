@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "curves/quartic_polynomial.hpp"
+#include "curves/quintic_polynomial.hpp"
+
+namespace common {
+
+// dense sampling only approaches the exact bounds from inside
+void ExpectBoundsMatchSamples(const Polynomial &polynomial, double begin, double end) {
+  for (size_t order = 0; order <= polynomial.Order() + 1; ++order) {
+    double min_value = 0.0;
+    double max_value = 0.0;
+    polynomial.DerivativeBounds(order, begin, end, &min_value, &max_value);
+    double sampled_min = std::numeric_limits<double>::max();
+    double sampled_max = std::numeric_limits<double>::lowest();
+    const size_t num_samples = 20000;
+    for (size_t i = 0; i <= num_samples; ++i) {
+      double p = begin + (end - begin) * static_cast<double>(i) / num_samples;
+      double value = polynomial.Evaluate(order, p);
+      sampled_min = std::min(sampled_min, value);
+      sampled_max = std::max(sampled_max, value);
+    }
+    const double tolerance = 1e-6 * (1.0 + std::fabs(sampled_max) + std::fabs(sampled_min));
+    EXPECT_LE(min_value, sampled_min + tolerance) << "order: " << order;
+    EXPECT_GE(max_value, sampled_max - tolerance) << "order: " << order;
+    EXPECT_NEAR(min_value, sampled_min, 1e-3 * (1.0 + std::fabs(sampled_min))) << "order: " << order;
+    EXPECT_NEAR(max_value, sampled_max, 1e-3 * (1.0 + std::fabs(sampled_max))) << "order: " << order;
+  }
+}
+
+TEST(PolynomialTest, quartic_derivative_bounds) {
+  QuarticPolynomial quartic(30.0, 15.0, 0.0, 10.0, 0.0, 6.0);
+  ExpectBoundsMatchSamples(quartic, 0.0, quartic.ParamLength());
+  ExpectBoundsMatchSamples(quartic, 1.3, 4.2);
+  QuarticPolynomial accelerating(0.0, 2.0, -1.0, 12.0, 0.5, 8.0);
+  ExpectBoundsMatchSamples(accelerating, 0.0, accelerating.ParamLength());
+}
+
+TEST(PolynomialTest, quintic_derivative_bounds) {
+  QuinticPolynomial quintic({-1.43473, 0.4, 0.0}, {0.5, 0.0, 0.0}, 20.0);
+  ExpectBoundsMatchSamples(quintic, 0.0, quintic.ParamLength());
+  QuinticPolynomial lon({30.0458, 15.0, 0.0}, {35.5136, 0.0, 0.0}, 4.0);
+  ExpectBoundsMatchSamples(lon, 0.0, lon.ParamLength());
+  ExpectBoundsMatchSamples(lon, 0.5, 2.5);
+}
+
+TEST(PolynomialTest, derivative_bounds_interior_extrema) {
+  // a lateral shift of 1 m in 5 s from rest to rest: the velocity and the acceleration are zero at both ends, their
+  // extrema are inside, the velocity peaks 15 / 8 / 5 at t = 2.5 and the acceleration peaks 10 / sqrt(3) / 25 at
+  // t = 2.5 -+ 2.5 / sqrt(3)
+  QuinticPolynomial shift({0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, 5.0);
+  double min_value = 0.0;
+  double max_value = 0.0;
+  shift.DerivativeBounds(1, 0.0, shift.ParamLength(), &min_value, &max_value);
+  EXPECT_NEAR(max_value, 15.0 / 8.0 / 5.0, 1e-9);
+  EXPECT_NEAR(min_value, 0.0, 1e-9);
+  shift.DerivativeBounds(2, 0.0, shift.ParamLength(), &min_value, &max_value);
+  EXPECT_NEAR(max_value, 10.0 / std::sqrt(3.0) / 25.0, 1e-9);
+  EXPECT_NEAR(min_value, -10.0 / std::sqrt(3.0) / 25.0, 1e-9);
+  ExpectBoundsMatchSamples(shift, 0.0, shift.ParamLength());
+
+  // a sub interval which holds only the falling half of the acceleration
+  shift.DerivativeBounds(2, 2.0, 4.5, &min_value, &max_value);
+  EXPECT_NEAR(min_value, -10.0 / std::sqrt(3.0) / 25.0, 1e-9);
+  EXPECT_NEAR(max_value, shift.Evaluate(2, 2.0), 1e-9);
+
+  // braking from 1 m/s at -2 m/s^2 then speeding up again: the velocity dips to its min inside and all the
+  // extrema up to the jerk are not at the ends
+  QuinticPolynomial dip({0.0, 1.0, -2.0}, {0.5, 1.0, 0.0}, 4.0);
+  for (size_t order = 1; order <= 3; ++order) {
+    dip.DerivativeBounds(order, 0.0, dip.ParamLength(), &min_value, &max_value);
+    const double end_min = std::min(dip.Evaluate(order, 0.0), dip.Evaluate(order, dip.ParamLength()));
+    const double end_max = std::max(dip.Evaluate(order, 0.0), dip.Evaluate(order, dip.ParamLength()));
+    EXPECT_TRUE(min_value < end_min - 1e-3 || max_value > end_max + 1e-3) << "order: " << order;
+  }
+  ExpectBoundsMatchSamples(dip, 0.0, dip.ParamLength());
+  ExpectBoundsMatchSamples(dip, 0.3, 3.1);
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,4 +1,8 @@
 #include "curves/spline2d.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
 #include <ros/ros.h>
 namespace common {
 
@@ -13,6 +17,7 @@ Spline2d::Spline2d(const std::vector<double> &xs,
   x_spline_.set_points(chord_lengths_, xs_);
   y_spline_.set_points(chord_lengths_, ys_);
   CalcArcLength();
+  BuildSpatialIndex();
 }
 
 Spline2d::Spline2d(const std::vector<double> &xs,
@@ -27,6 +32,7 @@ Spline2d::Spline2d(const std::vector<double> &xs,
   x_spline_.set_points(chord_lengths_, xs_);
   y_spline_.set_points(chord_lengths_, ys_);
   CalcArcLength();
+  BuildSpatialIndex();
 }
 
 bool Spline2d::Evaluate(double s, double *x, double *y) const {
@@ -223,13 +229,46 @@ bool Spline2d::GetNearestPointOnSpline(double x, double y,
                                        double *const nearest_x,
                                        double *const nearest_y,
                                        double *const nearest_s) const {
+  int min_index = this->CalcNearestIndex(x, y);
+  return RefineNearestPoint(x, y, min_index, nearest_x, nearest_y, nearest_s);
+}
+
+bool Spline2d::GetNearestPointOnSpline(double x, double y, double s_hint,
+                                       double *const nearest_x,
+                                       double *const nearest_y,
+                                       double *const nearest_s) const {
+  const int num_knots = static_cast<int>(xs_.size());
+  int min_index = static_cast<int>(std::distance(
+      chord_lengths_.begin(), std::lower_bound(chord_lengths_.begin(), chord_lengths_.end(), s_hint)));
+  min_index = std::min(min_index, num_knots - 1);
+  double min_dist = std::hypot(x - xs_[min_index], y - ys_[min_index]);
+  // walk along the knots while the distance decreases
+  for (int step : {-1, 1}) {
+    while (min_index + step >= 0 && min_index + step < num_knots) {
+      const double dist = std::hypot(x - xs_[min_index + step], y - ys_[min_index + step]);
+      if (dist >= min_dist) {
+        break;
+      }
+      min_dist = dist;
+      min_index += step;
+    }
+  }
+  // the walk stops at a local minimum, on a loop or a u-turn another branch can be closer: only the knots within
+  // min_dist can be, they are in the cells around the point
+  min_index = this->CalcNearestIndexWithin(x, y, min_index, min_dist);
+  return RefineNearestPoint(x, y, min_index, nearest_x, nearest_y, nearest_s);
+}
+
+bool Spline2d::RefineNearestPoint(double x, double y, int min_index,
+                                  double *const nearest_x,
+                                  double *const nearest_y,
+                                  double *const nearest_s) const {
   // 1. prepared, set the init s1, s2, s3
   // note: here we use the chord length rather than arc length for eliminating the calculate time;
 
   // t1, t2, t3, tk_star  refer to: Robust and Efficient Computation of the
   // Closest Point on a Spline Curve
   double s_opt;
-  int min_index = this->CalcNearestIndex(x, y);
 //  double t1 = chord_lengths_[min_index] / chord_lengths_.back();
   double s1 = chord_lengths_[min_index];
   Clamp(s1, chord_lengths_[0], chord_lengths_.back());
@@ -389,6 +428,83 @@ double Spline2d::Clamp(double t, double lb, double ub) {
 }
 
 int Spline2d::CalcNearestIndex(double x, double y) const {
+  if (cell_starts_.empty()) {
+    return CalcNearestIndexLinear(x, y);
+  }
+  const auto cell_x = static_cast<int>(std::floor((x - grid_min_x_) / cell_size_));
+  const auto cell_y = static_cast<int>(std::floor((y - grid_min_y_) / cell_size_));
+  // far from the knots most of the rings are empty
+  if (cell_x < -1 || cell_x > num_cells_x_ || cell_y < -1 || cell_y > num_cells_y_) {
+    return CalcNearestIndexLinear(x, y);
+  }
+  const int max_ring = std::max(std::max(cell_x, num_cells_x_ - 1 - cell_x),
+                                std::max(cell_y, num_cells_y_ - 1 - cell_y));
+  double min_dist = std::numeric_limits<double>::max();
+  int min_index = 0;
+  auto search_cell = [&](int ix, int iy) {
+    if (ix < 0 || ix >= num_cells_x_ || iy < 0 || iy >= num_cells_y_) {
+      return;
+    }
+    const size_t cell = static_cast<size_t>(iy) * num_cells_x_ + ix;
+    for (size_t k = cell_starts_[cell]; k < cell_starts_[cell + 1]; ++k) {
+      const int i = cell_knot_indices_[k];
+      const double dist = std::hypot(x - xs_[i], y - ys_[i]);
+      // ties go to the smaller index, the same as the linear scan
+      if (dist < min_dist || (dist == min_dist && i < min_index)) {
+        min_dist = dist;
+        min_index = i;
+      }
+    }
+  };
+  for (int ring = 0; ring <= max_ring; ++ring) {
+    for (int iy = cell_y - ring; iy <= cell_y + ring; ++iy) {
+      if (iy == cell_y - ring || iy == cell_y + ring) {
+        for (int ix = cell_x - ring; ix <= cell_x + ring; ++ix) {
+          search_cell(ix, iy);
+        }
+      } else {
+        search_cell(cell_x - ring, iy);
+        search_cell(cell_x + ring, iy);
+      }
+    }
+    // the knots out of this ring are farther than ring * cell_size_
+    if (min_dist <= ring * cell_size_) {
+      break;
+    }
+  }
+  return min_index;
+}
+
+int Spline2d::CalcNearestIndexWithin(double x, double y, int index, double dist) const {
+  if (cell_starts_.empty()) {
+    return CalcNearestIndexLinear(x, y);
+  }
+  const int min_cell_x = std::max(static_cast<int>(std::floor((x - dist - grid_min_x_) / cell_size_)), 0);
+  const int max_cell_x =
+      std::min(static_cast<int>(std::floor((x + dist - grid_min_x_) / cell_size_)), num_cells_x_ - 1);
+  const int min_cell_y = std::max(static_cast<int>(std::floor((y - dist - grid_min_y_) / cell_size_)), 0);
+  const int max_cell_y =
+      std::min(static_cast<int>(std::floor((y + dist - grid_min_y_) / cell_size_)), num_cells_y_ - 1);
+  double min_dist = dist;
+  int min_index = index;
+  for (int iy = min_cell_y; iy <= max_cell_y; ++iy) {
+    for (int ix = min_cell_x; ix <= max_cell_x; ++ix) {
+      const size_t cell = static_cast<size_t>(iy) * num_cells_x_ + ix;
+      for (size_t k = cell_starts_[cell]; k < cell_starts_[cell + 1]; ++k) {
+        const int i = cell_knot_indices_[k];
+        const double knot_dist = std::hypot(x - xs_[i], y - ys_[i]);
+        // ties go to the smaller index, the same as the linear scan
+        if (knot_dist < min_dist || (knot_dist == min_dist && i < min_index)) {
+          min_dist = knot_dist;
+          min_index = i;
+        }
+      }
+    }
+  }
+  return min_index;
+}
+
+int Spline2d::CalcNearestIndexLinear(double x, double y) const {
   double min_dist = std::numeric_limits<double>::max();
   int min_index = 0;
   for (size_t i = 0; i < xs_.size(); ++i) {
@@ -400,4 +516,40 @@ int Spline2d::CalcNearestIndex(double x, double y) const {
   }
   return min_index;
 }
-}
\ No newline at end of file
+
+void Spline2d::BuildSpatialIndex() {
+  cell_starts_.clear();
+  cell_knot_indices_.clear();
+  if (xs_.empty()) {
+    return;
+  }
+  const auto x_range = std::minmax_element(xs_.begin(), xs_.end());
+  const auto y_range = std::minmax_element(ys_.begin(), ys_.end());
+  grid_min_x_ = *x_range.first;
+  grid_min_y_ = *y_range.first;
+  const double width = *x_range.second - grid_min_x_;
+  const double height = *y_range.second - grid_min_y_;
+  // about one knot per cell for a dense area, a few knots per cell along the line
+  const double mean_segment_length = arc_length_ / std::max<size_t>(xs_.size() - 1, 1);
+  cell_size_ = std::max(std::max(std::sqrt(width * height / xs_.size()), 2.0 * mean_segment_length), 1e-3);
+  num_cells_x_ = static_cast<int>(width / cell_size_) + 1;
+  num_cells_y_ = static_cast<int>(height / cell_size_) + 1;
+
+  std::vector<size_t> knot_cells(xs_.size());
+  cell_starts_.assign(static_cast<size_t>(num_cells_x_) * num_cells_y_ + 1, 0);
+  for (size_t i = 0; i < xs_.size(); ++i) {
+    const int ix = std::min(static_cast<int>((xs_[i] - grid_min_x_) / cell_size_), num_cells_x_ - 1);
+    const int iy = std::min(static_cast<int>((ys_[i] - grid_min_y_) / cell_size_), num_cells_y_ - 1);
+    knot_cells[i] = static_cast<size_t>(iy) * num_cells_x_ + ix;
+    ++cell_starts_[knot_cells[i] + 1];
+  }
+  for (size_t k = 1; k < cell_starts_.size(); ++k) {
+    cell_starts_[k] += cell_starts_[k - 1];
+  }
+  cell_knot_indices_.resize(xs_.size());
+  std::vector<size_t> cell_fill(cell_starts_.begin(), cell_starts_.end() - 1);
+  for (size_t i = 0; i < xs_.size(); ++i) {
+    cell_knot_indices_[cell_fill[knot_cells[i]]++] = static_cast<int>(i);
+  }
+}
+}
@@ -1,5 +1,8 @@
+#define private public
 #include "curves/spline2d.hpp"
+#undef private
 #include <gtest/gtest.h>
+#include <random>
 #include <ros/ros.h>
 #include "math/math_utils.hpp"
 
@@ -172,6 +175,83 @@ TEST_F(Spline2dTest, closed_point) {
 
 }
 
+TEST_F(Spline2dTest, nearest_index_grid) {
+  // the grid search finds the same knot as the linear scan, also for points off the line
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<double> x_dist(-20.0, 60.0);
+  std::uniform_real_distribution<double> y_dist(-40.0, 40.0);
+  for (size_t i = 0; i < 2000; ++i) {
+    double x = x_dist(generator);
+    double y = y_dist(generator);
+    EXPECT_EQ(spline2d_->CalcNearestIndex(x, y), spline2d_->CalcNearestIndexLinear(x, y));
+  }
+  for (size_t i = 0; i < spline2d_->xs_.size(); ++i) {
+    EXPECT_EQ(spline2d_->CalcNearestIndex(spline2d_->xs_[i], spline2d_->ys_[i]), i);
+  }
+}
+
+TEST_F(Spline2dTest, closed_point_with_hint) {
+  double last_s = 0.0;
+  for (double s = 0.5; s < spline2d_->ArcLength(); s += 0.7) {
+    double x, y, dx, dy;
+    spline2d_->Evaluate(s, &x, &y);
+    spline2d_->EvaluateFirstDerivative(s, &dx, &dy);
+    // a point 1 m left of the line
+    x -= dy;
+    y += dx;
+    double nearest_x, nearest_y, nearest_s;
+    double hinted_x, hinted_y, hinted_s;
+    EXPECT_TRUE(spline2d_->GetNearestPointOnSpline(x, y, &nearest_x, &nearest_y, &nearest_s));
+    EXPECT_TRUE(spline2d_->GetNearestPointOnSpline(x, y, last_s, &hinted_x, &hinted_y, &hinted_s));
+    EXPECT_NEAR(hinted_s, nearest_s, 1e-6);
+    EXPECT_NEAR(hinted_x, nearest_x, 1e-6);
+    EXPECT_NEAR(hinted_y, nearest_y, 1e-6);
+    last_s = hinted_s;
+  }
+}
+
+TEST(Spline2dHintTest, closed_point_with_hint_on_hairpin) {
+  // a u-turn of radius 3 m, the legs are 6 m apart and the knots 5 m apart, much closer than a grid cell
+  std::vector<double> xs;
+  std::vector<double> ys;
+  for (double x = 0.0; x < 100.0; x += 5.0) {
+    xs.push_back(x);
+    ys.push_back(0.0);
+  }
+  for (double theta = -M_PI_2; theta < M_PI_2; theta += M_PI / 4.0) {
+    xs.push_back(100.0 + 3.0 * std::cos(theta));
+    ys.push_back(3.0 + 3.0 * std::sin(theta));
+  }
+  for (double x = 100.0; x >= 0.0; x -= 5.0) {
+    xs.push_back(x);
+    ys.push_back(6.0);
+  }
+  Spline2d spline2d(xs, ys);
+  ASSERT_GT(spline2d.cell_size_, 6.0);
+  std::mt19937 generator(11);
+  std::uniform_real_distribution<double> x_dist(5.0, 95.0);
+  std::uniform_real_distribution<double> y_dist(-2.0, 8.0);
+  std::uniform_real_distribution<double> s_dist(0.0, spline2d.ArcLength());
+  for (size_t i = 0; i < 500; ++i) {
+    double x = x_dist(generator);
+    double y = y_dist(generator);
+    // the hint may be on the other leg
+    double s_hint = s_dist(generator);
+    double nearest_x, nearest_y, nearest_s;
+    double hinted_x, hinted_y, hinted_s;
+    EXPECT_TRUE(spline2d.GetNearestPointOnSpline(x, y, &nearest_x, &nearest_y, &nearest_s));
+    EXPECT_TRUE(spline2d.GetNearestPointOnSpline(x, y, s_hint, &hinted_x, &hinted_y, &hinted_s));
+    EXPECT_NEAR(hinted_s, nearest_s, 1e-6);
+    EXPECT_NEAR(hinted_x, nearest_x, 1e-6);
+    EXPECT_NEAR(hinted_y, nearest_y, 1e-6);
+  }
+  // the previous projection on the lower leg, the point near the upper leg
+  double hinted_x, hinted_y, hinted_s;
+  EXPECT_TRUE(spline2d.GetNearestPointOnSpline(50.0, 5.0, 50.0, &hinted_x, &hinted_y, &hinted_s));
+  EXPECT_NEAR(hinted_y, 6.0, 0.1);
+  EXPECT_GT(hinted_s, 100.0);
+}
+
 TEST_F(Spline2dTest, derivatives) {
   double dx, dy, ddx, ddy, dddx, dddy;
   double s = spline2d_->ArcLength() - 40;
@@ -27,12 +27,16 @@ void Box2d::InitCorners() {
   const double dy1 = sin_heading_ * half_length_;
   const double dx2 = sin_heading_ * half_width_;
   const double dy2 = -cos_heading_ * half_width_;
-  corners_.clear();
-  corners_.emplace_back(center_.x() + dx1 + dx2, center_.y() + dy1 + dy2);
-  corners_.emplace_back(center_.x() + dx1 - dx2, center_.y() + dy1 - dy2);
-  corners_.emplace_back(center_.x() - dx1 - dx2, center_.y() - dy1 - dy2);
-  corners_.emplace_back(center_.x() - dx1 + dx2, center_.y() - dy1 + dy2);
-
+  corners_[0] << center_.x() + dx1 + dx2, center_.y() + dy1 + dy2;
+  corners_[1] << center_.x() + dx1 - dx2, center_.y() + dy1 - dy2;
+  corners_[2] << center_.x() - dx1 - dx2, center_.y() - dy1 - dy2;
+  corners_[3] << center_.x() - dx1 + dx2, center_.y() - dy1 + dy2;
+
+  // reset, the box may have been shifted, rotated or extended
+  max_x_ = std::numeric_limits<double>::lowest();
+  min_x_ = std::numeric_limits<double>::max();
+  max_y_ = std::numeric_limits<double>::lowest();
+  min_y_ = std::numeric_limits<double>::max();
   for (auto &corner : corners_) {
     max_x_ = std::fmax(corner.x(), max_x_);
     min_x_ = std::fmin(corner.x(), min_x_);
@@ -42,7 +46,11 @@ void Box2d::InitCorners() {
 }
 
 std::vector<Eigen::Vector2d> Box2d::GetAllCorners() const {
-  return corners_;
+  return std::vector<Eigen::Vector2d>(corners_.begin(), corners_.end());
+}
+
+const Eigen::Vector2d &Box2d::GetCorner(size_t index) const {
+  return corners_[index];
 }
 
 bool Box2d::IsPointIn(const Eigen::Vector2d &point) const {
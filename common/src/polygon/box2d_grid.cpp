@@ -0,0 +1,129 @@
+#include "polygon/box2d_grid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace common {
+
+Box2dGrid::Box2dGrid(std::vector<Box2d> boxes, double cell_size)
+    : boxes_(std::move(boxes)) {
+  BuildGrid(cell_size);
+}
+
+bool Box2dGrid::HasOverlapWithBox2d(const Box2d &box) const {
+  return HasOverlapWithBox2d(box, nullptr);
+}
+
+bool Box2dGrid::HasOverlapWithBox2d(const Box2d &box, const std::vector<bool> &box_mask) const {
+  return HasOverlapWithBox2d(box, &box_mask);
+}
+
+bool Box2dGrid::HasOverlapWithBox2d(const Box2d &box, const std::vector<bool> *box_mask) const {
+  if (boxes_.empty()) {
+    return false;
+  }
+  const double grid_max_x = grid_min_x_ + num_cells_x_ * cell_size_;
+  const double grid_max_y = grid_min_y_ + num_cells_y_ * cell_size_;
+  if (box.max_x() < grid_min_x_ || box.min_x() > grid_max_x ||
+      box.max_y() < grid_min_y_ || box.min_y() > grid_max_y) {
+    return false;
+  }
+  const int ix_begin = CellX(box.min_x());
+  const int ix_end = CellX(box.max_x());
+  const int iy_begin = CellY(box.min_y());
+  const int iy_end = CellY(box.max_y());
+  // a box spanning several cells may be tested more than once, cheaper than deduplicating in the kernel
+  for (int iy = iy_begin; iy <= iy_end; ++iy) {
+    for (int ix = ix_begin; ix <= ix_end; ++ix) {
+      const size_t cell = static_cast<size_t>(iy) * num_cells_x_ + ix;
+      for (size_t begin = cell_starts_[cell]; begin < cell_starts_[cell + 1]; begin += BoxSet::kMaxBitsBoxes) {
+        const size_t end = std::min(begin + BoxSet::kMaxBitsBoxes, cell_starts_[cell + 1]);
+        uint64_t bits = cell_boxes_.OverlapBits(box, begin, end);
+        if (box_mask == nullptr) {
+          if (bits != 0) {
+            return true;
+          }
+          continue;
+        }
+        for (size_t k = begin; bits != 0; ++k, bits >>= 1) {
+          if ((bits & 1u) && (*box_mask)[cell_box_indices_[k]]) {
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
+int Box2dGrid::CellX(double x) const {
+  const int ix = static_cast<int>(std::floor((x - grid_min_x_) / cell_size_));
+  return std::max(0, std::min(ix, num_cells_x_ - 1));
+}
+
+int Box2dGrid::CellY(double y) const {
+  const int iy = static_cast<int>(std::floor((y - grid_min_y_) / cell_size_));
+  return std::max(0, std::min(iy, num_cells_y_ - 1));
+}
+
+void Box2dGrid::BuildGrid(double cell_size) {
+  cell_starts_.clear();
+  cell_box_indices_.clear();
+  cell_boxes_.Clear();
+  num_cells_x_ = 0;
+  num_cells_y_ = 0;
+  if (boxes_.empty()) {
+    return;
+  }
+  constexpr double kMinCellSize = 1.0;
+  constexpr double kMaxNumCells = 4096.0;
+  double max_x = std::numeric_limits<double>::lowest();
+  double max_y = std::numeric_limits<double>::lowest();
+  grid_min_x_ = std::numeric_limits<double>::max();
+  grid_min_y_ = std::numeric_limits<double>::max();
+  double mean_box_size = 0.0;
+  for (const auto &box : boxes_) {
+    grid_min_x_ = std::min(grid_min_x_, box.min_x());
+    grid_min_y_ = std::min(grid_min_y_, box.min_y());
+    max_x = std::max(max_x, box.max_x());
+    max_y = std::max(max_y, box.max_y());
+    mean_box_size += std::max(box.max_x() - box.min_x(), box.max_y() - box.min_y());
+  }
+  mean_box_size /= boxes_.size();
+  const double width = max_x - grid_min_x_;
+  const double height = max_y - grid_min_y_;
+  // about one box per cell, coarser if the boxes are spread over a large area
+  cell_size_ = cell_size > 0.0 ? cell_size : std::max(mean_box_size, kMinCellSize);
+  cell_size_ = std::max(cell_size_, std::sqrt(width * height / kMaxNumCells));
+  num_cells_x_ = static_cast<int>(width / cell_size_) + 1;
+  num_cells_y_ = static_cast<int>(height / cell_size_) + 1;
+
+  cell_starts_.assign(static_cast<size_t>(num_cells_x_) * num_cells_y_ + 1, 0);
+  for (const auto &box : boxes_) {
+    for (int iy = CellY(box.min_y()); iy <= CellY(box.max_y()); ++iy) {
+      for (int ix = CellX(box.min_x()); ix <= CellX(box.max_x()); ++ix) {
+        ++cell_starts_[static_cast<size_t>(iy) * num_cells_x_ + ix + 1];
+      }
+    }
+  }
+  for (size_t k = 1; k < cell_starts_.size(); ++k) {
+    cell_starts_[k] += cell_starts_[k - 1];
+  }
+  cell_box_indices_.resize(cell_starts_.back());
+  std::vector<size_t> cell_fill(cell_starts_.begin(), cell_starts_.end() - 1);
+  for (size_t i = 0; i < boxes_.size(); ++i) {
+    const auto &box = boxes_[i];
+    for (int iy = CellY(box.min_y()); iy <= CellY(box.max_y()); ++iy) {
+      for (int ix = CellX(box.min_x()); ix <= CellX(box.max_x()); ++ix) {
+        cell_box_indices_[cell_fill[static_cast<size_t>(iy) * num_cells_x_ + ix]++] = i;
+      }
+    }
+  }
+  cell_boxes_.Reserve(cell_box_indices_.size());
+  for (const size_t index : cell_box_indices_) {
+    cell_boxes_.AddBox(boxes_[index]);
+  }
+}
+
+}
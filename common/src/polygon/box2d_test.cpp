@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include <polygon/box2d.hpp>
+#include <polygon/box2d_grid.hpp>
+#include <polygon/box_set.hpp>
+#include <random>
 using namespace common;
 TEST(BoxTest, corner_test) {
   Eigen::Vector2d center{0, 0};
@@ -142,6 +145,84 @@ TEST(Box2dTest, RotateFromCenterAndShift) {
   EXPECT_NEAR(corners[2].y(), 38.0, 1e-5);
   EXPECT_NEAR(corners[3].x(), 31.0, 1e-5);
   EXPECT_NEAR(corners[3].y(), 38.0, 1e-5);
+  EXPECT_NEAR(box.min_x(), 29.0, 1e-5);
+  EXPECT_NEAR(box.max_x(), 31.0, 1e-5);
+  EXPECT_NEAR(box.min_y(), 38.0, 1e-5);
+  EXPECT_NEAR(box.max_y(), 42.0, 1e-5);
+
+  box.LongitudinalExtend(2.0);
+  EXPECT_NEAR(box.min_y(), 37.0, 1e-5);
+  EXPECT_NEAR(box.max_y(), 43.0, 1e-5);
+}
+
+TEST(Box2dGridTest, HasOverlap) {
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> position(-60.0, 60.0);
+  std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+  std::uniform_real_distribution<double> size(0.5, 8.0);
+  std::vector<Box2d> boxes;
+  for (size_t i = 0; i < 50; ++i) {
+    boxes.emplace_back(Eigen::Vector2d(position(gen), position(gen)), heading(gen), size(gen), size(gen));
+  }
+  // a box sharing an edge with the first one
+  boxes.emplace_back(Eigen::Vector2d(100.0, 0.0), 0.0, 4.0, 2.0);
+  Box2d touching({104.0, 0.0}, 0.0, 4.0, 2.0);
+  for (double cell_size : {0.0, 0.3, 5.0, 200.0}) {
+    Box2dGrid grid(boxes, cell_size);
+    EXPECT_EQ(grid.NumBoxes(), boxes.size());
+    EXPECT_EQ(grid.HasOverlapWithBox2d(touching), touching.HasOverlapWithBox2d(boxes.back()));
+    for (size_t i = 0; i < 2000; ++i) {
+      Box2d query({1.3 * position(gen), 1.3 * position(gen)}, heading(gen), size(gen), size(gen));
+      bool expected = false;
+      for (const auto &box : boxes) {
+        expected = expected || query.HasOverlapWithBox2d(box);
+      }
+      EXPECT_EQ(grid.HasOverlapWithBox2d(query), expected);
+    }
+  }
+  Box2dGrid empty_grid;
+  EXPECT_FALSE(empty_grid.HasOverlapWithBox2d(touching));
+}
+
+TEST(BoxSetTest, OverlapBits) {
+  std::mt19937 gen(11);
+  std::uniform_real_distribution<double> position(-20.0, 20.0);
+  std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+  std::uniform_real_distribution<double> size(0.5, 8.0);
+  std::vector<Box2d> boxes;
+  for (size_t i = 0; i < 150; ++i) {
+    boxes.emplace_back(Eigen::Vector2d(position(gen), position(gen)), heading(gen), size(gen), size(gen));
+  }
+  // boxes sharing an edge or a corner with the query box
+  boxes.emplace_back(Eigen::Vector2d(104.0, 0.0), 0.0, 4.0, 2.0);
+  boxes.emplace_back(Eigen::Vector2d(104.0, 2.0), 0.0, 4.0, 2.0);
+  boxes.emplace_back(Eigen::Vector2d(100.0, 2.0 + 1e-9), 0.0, 4.0, 2.0);
+  BoxSet box_set(boxes);
+  EXPECT_EQ(box_set.Size(), boxes.size());
+
+  std::vector<Box2d> queries{Box2d({100.0, 0.0}, 0.0, 4.0, 2.0)};
+  for (size_t i = 0; i < 500; ++i) {
+    queries.emplace_back(Eigen::Vector2d(position(gen), position(gen)), heading(gen), size(gen), size(gen));
+  }
+  for (const auto &query : queries) {
+    bool expected_any = false;
+    for (size_t begin = 0; begin < boxes.size(); begin += BoxSet::kMaxBitsBoxes) {
+      const size_t end = std::min(begin + BoxSet::kMaxBitsBoxes, boxes.size());
+      uint64_t expected = 0;
+      for (size_t k = begin; k < end; ++k) {
+        if (query.HasOverlapWithBox2d(boxes[k])) {
+          expected |= uint64_t{1} << (k - begin);
+        }
+      }
+      expected_any = expected_any || expected != 0;
+      EXPECT_EQ(box_set.OverlapBits(query, begin, end), expected);
+      EXPECT_EQ(box_set.OverlapBitsScalar(query, begin, end), expected);
+      // unaligned ranges exercise the scalar tail of the vectorized kernel
+      EXPECT_EQ(box_set.OverlapBits(query, begin + 1, end), expected >> 1);
+    }
+    EXPECT_EQ(box_set.HasOverlapWithBox2d(query), expected_any);
+  }
+  EXPECT_FALSE(BoxSet().HasOverlapWithBox2d(queries.front()));
 }
 
 int main(int argc, char **argv) {
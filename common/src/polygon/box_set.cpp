@@ -0,0 +1,223 @@
+#include <cassert>
+#include <cmath>
+#include "polygon/box_set.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BOX_SET_HAS_AVX2_KERNEL 1
+#else
+#define BOX_SET_HAS_AVX2_KERNEL 0
+#endif
+
+namespace common {
+
+constexpr size_t BoxSet::kMaxBitsBoxes;
+
+BoxSet::BoxSet(const std::vector<Box2d> &boxes) {
+  Reserve(boxes.size());
+  for (const auto &box : boxes) {
+    AddBox(box);
+  }
+}
+
+void BoxSet::Reserve(size_t num_boxes) {
+  for (auto *values : {&center_x_, &center_y_, &cos_heading_, &sin_heading_, &half_length_, &half_width_,
+                       &length_dx_, &length_dy_, &width_dx_, &width_dy_, &min_x_, &max_x_, &min_y_, &max_y_}) {
+    values->reserve(num_boxes);
+  }
+}
+
+void BoxSet::Clear() {
+  for (auto *values : {&center_x_, &center_y_, &cos_heading_, &sin_heading_, &half_length_, &half_width_,
+                       &length_dx_, &length_dy_, &width_dx_, &width_dy_, &min_x_, &max_x_, &min_y_, &max_y_}) {
+    values->clear();
+  }
+}
+
+size_t BoxSet::AddBox(const Box2d &box) {
+  center_x_.push_back(box.center_x());
+  center_y_.push_back(box.center_y());
+  cos_heading_.push_back(box.cos_heading());
+  sin_heading_.push_back(box.sin_heading());
+  half_length_.push_back(box.half_length());
+  half_width_.push_back(box.half_width());
+  length_dx_.push_back(box.cos_heading() * box.half_length());
+  length_dy_.push_back(box.sin_heading() * box.half_length());
+  width_dx_.push_back(box.sin_heading() * box.half_width());
+  width_dy_.push_back(-box.cos_heading() * box.half_width());
+  min_x_.push_back(box.min_x());
+  max_x_.push_back(box.max_x());
+  min_y_.push_back(box.min_y());
+  max_y_.push_back(box.max_y());
+  return center_x_.size() - 1;
+}
+
+uint64_t BoxSet::OverlapBits(const Box2d &box, size_t begin, size_t end) const {
+  assert(end <= Size() && end - begin <= kMaxBitsBoxes);
+  if (HasAvx2()) {
+    return OverlapBitsAvx2(box, begin, end);
+  }
+  return OverlapBitsScalar(box, begin, end);
+}
+
+// the same operations in the same order as Box2d::HasOverlapWithBox2d, box is `this` there
+uint64_t BoxSet::OverlapBitsScalar(const Box2d &box, size_t begin, size_t end) const {
+  assert(end <= Size() && end - begin <= kMaxBitsBoxes);
+  const double cos_heading = box.cos_heading();
+  const double sin_heading = box.sin_heading();
+  const double dx1 = cos_heading * box.half_length();
+  const double dy1 = sin_heading * box.half_length();
+  const double dx2 = sin_heading * box.half_width();
+  const double dy2 = -cos_heading * box.half_width();
+  uint64_t bits = 0;
+  for (size_t k = begin; k < end; ++k) {
+    if (max_x_[k] < box.min_x() || min_x_[k] > box.max_x() || max_y_[k] < box.min_y() ||
+        min_y_[k] > box.max_y()) {
+      continue;
+    }
+    const double shift_x = center_x_[k] - box.center_x();
+    const double shift_y = center_y_[k] - box.center_y();
+    const double dx3 = length_dx_[k];
+    const double dy3 = length_dy_[k];
+    const double dx4 = width_dx_[k];
+    const double dy4 = width_dy_[k];
+    const bool overlap =
+        std::abs(shift_x * cos_heading + shift_y * sin_heading) <=
+            std::abs(dx3 * cos_heading + dy3 * sin_heading) +
+                std::abs(dx4 * cos_heading + dy4 * sin_heading) +
+                box.half_length() &&
+            std::abs(shift_x * sin_heading - shift_y * cos_heading) <=
+                std::abs(dx3 * sin_heading - dy3 * cos_heading) +
+                    std::abs(dx4 * sin_heading - dy4 * cos_heading) +
+                    box.half_width() &&
+            std::abs(shift_x * cos_heading_[k] + shift_y * sin_heading_[k]) <=
+                std::abs(dx1 * cos_heading_[k] + dy1 * sin_heading_[k]) +
+                    std::abs(dx2 * cos_heading_[k] + dy2 * sin_heading_[k]) +
+                    half_length_[k] &&
+            std::abs(shift_x * sin_heading_[k] - shift_y * cos_heading_[k]) <=
+                std::abs(dx1 * sin_heading_[k] - dy1 * cos_heading_[k]) +
+                    std::abs(dx2 * sin_heading_[k] - dy2 * cos_heading_[k]) +
+                    half_width_[k];
+    if (overlap) {
+      bits |= uint64_t{1} << (k - begin);
+    }
+  }
+  return bits;
+}
+
+bool BoxSet::HasOverlapWithBox2d(const Box2d &box) const {
+  for (size_t begin = 0; begin < Size(); begin += kMaxBitsBoxes) {
+    const size_t end = std::min(begin + kMaxBitsBoxes, Size());
+    if (OverlapBits(box, begin, end) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#if BOX_SET_HAS_AVX2_KERNEL
+
+bool BoxSet::HasAvx2() {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+}
+
+namespace {
+
+__attribute__((target("avx2")))
+inline __m256d Abs(__m256d x) {
+  return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+}
+
+}
+
+// mul and add are kept separate (no fma), so the results are bit-identical to the scalar kernel
+__attribute__((target("avx2")))
+uint64_t BoxSet::OverlapBitsAvx2(const Box2d &box, size_t begin, size_t end) const {
+  const double cos_heading = box.cos_heading();
+  const double sin_heading = box.sin_heading();
+  const __m256d cos0 = _mm256_set1_pd(cos_heading);
+  const __m256d sin0 = _mm256_set1_pd(sin_heading);
+  const __m256d dx1 = _mm256_set1_pd(cos_heading * box.half_length());
+  const __m256d dy1 = _mm256_set1_pd(sin_heading * box.half_length());
+  const __m256d dx2 = _mm256_set1_pd(sin_heading * box.half_width());
+  const __m256d dy2 = _mm256_set1_pd(-cos_heading * box.half_width());
+  const __m256d half_length0 = _mm256_set1_pd(box.half_length());
+  const __m256d half_width0 = _mm256_set1_pd(box.half_width());
+  const __m256d center_x0 = _mm256_set1_pd(box.center_x());
+  const __m256d center_y0 = _mm256_set1_pd(box.center_y());
+  const __m256d min_x0 = _mm256_set1_pd(box.min_x());
+  const __m256d max_x0 = _mm256_set1_pd(box.max_x());
+  const __m256d min_y0 = _mm256_set1_pd(box.min_y());
+  const __m256d max_y0 = _mm256_set1_pd(box.max_y());
+
+  uint64_t bits = 0;
+  size_t k = begin;
+  for (; k + 4 <= end; k += 4) {
+    const __m256d min_x = _mm256_loadu_pd(min_x_.data() + k);
+    const __m256d max_x = _mm256_loadu_pd(max_x_.data() + k);
+    const __m256d min_y = _mm256_loadu_pd(min_y_.data() + k);
+    const __m256d max_y = _mm256_loadu_pd(max_y_.data() + k);
+    const __m256d separated = _mm256_or_pd(
+        _mm256_or_pd(_mm256_cmp_pd(max_x, min_x0, _CMP_LT_OQ), _mm256_cmp_pd(min_x, max_x0, _CMP_GT_OQ)),
+        _mm256_or_pd(_mm256_cmp_pd(max_y, min_y0, _CMP_LT_OQ), _mm256_cmp_pd(min_y, max_y0, _CMP_GT_OQ)));
+    if (_mm256_movemask_pd(separated) == 0xf) {
+      continue;
+    }
+    const __m256d cos1 = _mm256_loadu_pd(cos_heading_.data() + k);
+    const __m256d sin1 = _mm256_loadu_pd(sin_heading_.data() + k);
+    const __m256d dx3 = _mm256_loadu_pd(length_dx_.data() + k);
+    const __m256d dy3 = _mm256_loadu_pd(length_dy_.data() + k);
+    const __m256d dx4 = _mm256_loadu_pd(width_dx_.data() + k);
+    const __m256d dy4 = _mm256_loadu_pd(width_dy_.data() + k);
+    const __m256d shift_x = _mm256_sub_pd(_mm256_loadu_pd(center_x_.data() + k), center_x0);
+    const __m256d shift_y = _mm256_sub_pd(_mm256_loadu_pd(center_y_.data() + k), center_y0);
+
+    // the axes of box
+    const __m256d proj1 = Abs(_mm256_add_pd(_mm256_mul_pd(shift_x, cos0), _mm256_mul_pd(shift_y, sin0)));
+    const __m256d bound1 = _mm256_add_pd(
+        _mm256_add_pd(Abs(_mm256_add_pd(_mm256_mul_pd(dx3, cos0), _mm256_mul_pd(dy3, sin0))),
+                      Abs(_mm256_add_pd(_mm256_mul_pd(dx4, cos0), _mm256_mul_pd(dy4, sin0)))),
+        half_length0);
+    const __m256d proj2 = Abs(_mm256_sub_pd(_mm256_mul_pd(shift_x, sin0), _mm256_mul_pd(shift_y, cos0)));
+    const __m256d bound2 = _mm256_add_pd(
+        _mm256_add_pd(Abs(_mm256_sub_pd(_mm256_mul_pd(dx3, sin0), _mm256_mul_pd(dy3, cos0))),
+                      Abs(_mm256_sub_pd(_mm256_mul_pd(dx4, sin0), _mm256_mul_pd(dy4, cos0)))),
+        half_width0);
+    // the axes of the boxes of the set
+    const __m256d proj3 = Abs(_mm256_add_pd(_mm256_mul_pd(shift_x, cos1), _mm256_mul_pd(shift_y, sin1)));
+    const __m256d bound3 = _mm256_add_pd(
+        _mm256_add_pd(Abs(_mm256_add_pd(_mm256_mul_pd(dx1, cos1), _mm256_mul_pd(dy1, sin1))),
+                      Abs(_mm256_add_pd(_mm256_mul_pd(dx2, cos1), _mm256_mul_pd(dy2, sin1)))),
+        _mm256_loadu_pd(half_length_.data() + k));
+    const __m256d proj4 = Abs(_mm256_sub_pd(_mm256_mul_pd(shift_x, sin1), _mm256_mul_pd(shift_y, cos1)));
+    const __m256d bound4 = _mm256_add_pd(
+        _mm256_add_pd(Abs(_mm256_sub_pd(_mm256_mul_pd(dx1, sin1), _mm256_mul_pd(dy1, cos1))),
+                      Abs(_mm256_sub_pd(_mm256_mul_pd(dx2, sin1), _mm256_mul_pd(dy2, cos1)))),
+        _mm256_loadu_pd(half_width_.data() + k));
+
+    const __m256d overlap = _mm256_andnot_pd(
+        separated,
+        _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(proj1, bound1, _CMP_LE_OQ), _mm256_cmp_pd(proj2, bound2, _CMP_LE_OQ)),
+                      _mm256_and_pd(_mm256_cmp_pd(proj3, bound3, _CMP_LE_OQ), _mm256_cmp_pd(proj4, bound4, _CMP_LE_OQ))));
+    bits |= static_cast<uint64_t>(_mm256_movemask_pd(overlap)) << (k - begin);
+  }
+  if (k < end) {
+    bits |= OverlapBitsScalar(box, k, end) << (k - begin);
+  }
+  return bits;
+}
+
+#else
+
+bool BoxSet::HasAvx2() {
+  return false;
+}
+
+uint64_t BoxSet::OverlapBitsAvx2(const Box2d &box, size_t begin, size_t end) const {
+  return OverlapBitsScalar(box, begin, end);
+}
+
+#endif
+
+}
@@ -237,22 +237,16 @@ double EndConditionSampler::GetObstacleSpeedAlongReferenceLine(int obstacle_id,
     return 0.0;
   }
   auto matched_obstacle = obstacles_.at(obstacle_id);
-  const auto &trajectory = matched_obstacle->trajectory();
-  size_t num_traj_point = trajectory.trajectory_points.size();
-  if (num_traj_point < 2) {
+  const auto &pose_track = matched_obstacle->pose_track();
+  if (pose_track.Size() < 2) {
     return 0.0;
   }
-  if (t < trajectory.trajectory_points[0].relative_time ||
-      t > trajectory.trajectory_points.back().relative_time) {
+  if (t < pose_track.StartTime() || t > pose_track.EndTime()) {
     return 0.0;
   }
-  auto matched_iter =
-      std::lower_bound(trajectory.trajectory_points.begin(), trajectory.trajectory_points.end(),
-                       t, [](const planning_msgs::TrajectoryPoint &p, const double t) {
-            return p.relative_time < t;
-          });
-  double v = matched_iter->vel;
-  double theta = matched_iter->path_point.theta;
+  const auto pose = pose_track.GetPoseAtTime(t);
+  double v = pose.v;
+  double theta = pose.theta;
   double v_x = v * std::cos(theta);
   double v_y = v * std::sin(theta);
   ReferencePoint matched_ref_point = ref_line.GetReferencePoint(s);
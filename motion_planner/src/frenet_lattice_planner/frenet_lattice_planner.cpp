@@ -17,45 +17,90 @@ bool FrenetLatticePlanner::Process(const std::vector<std::shared_ptr<Obstacle>>
                                    const std::vector<PlanningTarget> &planning_targets,
                                    planning_msgs::Trajectory &pub_trajectory,
                                    std::vector<planning_msgs::Trajectory> *valid_trajectories) {
-  obstacles_.assign(obstacles.begin(), obstacles.end());
-
   if (planning_targets.empty()) {
     ROS_FATAL("[FrenetLatticePlanner::Process]: ******No planning_targets provided*********");
     return false;
   }
   ROS_INFO("[FrenetLatticePlanner::Process], the targets size: %zu", planning_targets.size());
   constexpr double kDefaultNonBestBehaviourCost = 100.0;
-  size_t index = 0;
+  const size_t num_targets = planning_targets.size();
   size_t failed_ref_plan_num = 0;;
-  std::vector<std::pair<planning_msgs::Trajectory, double>> optimal_trajectories;
-  for (const auto &planning_target : planning_targets) {
-    std::pair<planning_msgs::Trajectory, double> optimal_trajectory;
-    auto result = PlanningOnRef(init_trajectory_point, planning_target, optimal_trajectory, valid_trajectories);
-    if (!result) {
+  std::vector<std::pair<planning_msgs::Trajectory, double>> optimal_trajectories(num_targets);
+  std::vector<std::vector<planning_msgs::Trajectory>> valid_trajectories_on_ref(num_targets);
+  std::vector<char> plan_results(num_targets, false);
+  // the predicted obstacle boxes are built once and shared by the collision checkers of every reference line
+  auto obstacle_occupancy = std::make_shared<ObstacleOccupancy>(obstacles,
+                                                                PlanningConfig::Instance().lon_safety_buffer(),
+                                                                PlanningConfig::Instance().lat_safety_buffer(),
+                                                                PlanningConfig::Instance().max_lookahead_time(),
+                                                                PlanningConfig::Instance().delta_t());
+  if (PlanningConfig::Instance().enable_occupancy_bitmap()) {
+    obstacle_occupancy->BuildBitmap(PlanningConfig::Instance().vehicle_params().length,
+                                    PlanningConfig::Instance().vehicle_params().width,
+                                    PlanningConfig::Instance().occupancy_bitmap_resolution());
+  }
+  std::shared_ptr<const ObstacleOccupancy> shared_obstacle_occupancy = std::move(obstacle_occupancy);
+  if (PlanningConfig::Instance().enable_st_graph_reuse()) {
+    if (st_graph_cache_ == nullptr) {
+      st_graph_cache_ = std::make_shared<STGraphCache>(PlanningConfig::Instance().st_graph_reuse_position_tolerance(),
+                                                       PlanningConfig::Instance().st_graph_reuse_heading_tolerance());
+    }
+    st_graph_cache_->BeginCycle(ros::Time::now().toSec());
+  } else {
+    st_graph_cache_.reset();
+  }
+  auto plan_on_target = [&](size_t index) {
+    plan_results[index] = PlanningOnRef(obstacles, shared_obstacle_occupancy, init_trajectory_point,
+                                        planning_targets[index], optimal_trajectories[index],
+                                        &valid_trajectories_on_ref[index]);
+  };
+  if (thread_pool_ != nullptr && num_targets > 1) {
+    // the reference lines are planned on their own threads rather than on thread_pool_: PlanningOnRef
+    // waits on the tasks it pushes to thread_pool_, so running it on a pool worker could starve the pool.
+    std::vector<std::future<void>> futures;
+    for (size_t index = 1; index < num_targets; ++index) {
+      futures.push_back(std::async(std::launch::async, plan_on_target, index));
+    }
+    plan_on_target(0);
+    for (auto &future : futures) {
+      future.get();
+    }
+  } else {
+    for (size_t index = 0; index < num_targets; ++index) {
+      plan_on_target(index);
+    }
+  }
+  // merge in target order, so the result does not depend on which line finished first
+  for (size_t index = 0; index < num_targets; ++index) {
+    if (!plan_results[index]) {
       ROS_FATAL("[FrenetLatticePlanner::Process], failed plan on reference line: %zu", index);
       failed_ref_plan_num++;
     }
-    ++index;
-    if (!planning_target.is_best_behaviour) {
-      optimal_trajectory.second += kDefaultNonBestBehaviourCost;
+    if (!planning_targets[index].is_best_behaviour) {
+      optimal_trajectories[index].second += kDefaultNonBestBehaviourCost;
+    }
+    if (valid_trajectories != nullptr) {
+      valid_trajectories->insert(valid_trajectories->end(),
+                                 valid_trajectories_on_ref[index].begin(), valid_trajectories_on_ref[index].end());
     }
-    optimal_trajectories.push_back(optimal_trajectory);
   }
   if (failed_ref_plan_num >= planning_targets.size()) {
     ROS_FATAL("[FrenetLatticePlanner::Process], the process is failed on every reference line");
     return false;
   }
-  std::sort(optimal_trajectories.begin(), optimal_trajectories.end(),
-            [](const std::pair<planning_msgs::Trajectory, double> &p0,
-               const std::pair<planning_msgs::Trajectory, double> &p1) -> bool {
-              return p0.second < p1.second;
-            });
+  std::stable_sort(optimal_trajectories.begin(), optimal_trajectories.end(),
+                   [](const std::pair<planning_msgs::Trajectory, double> &p0,
+                      const std::pair<planning_msgs::Trajectory, double> &p1) -> bool {
+                     return p0.second < p1.second;
+                   });
 
   pub_trajectory = std::move(optimal_trajectories.front().first);
   return true;
 }
 
-bool FrenetLatticePlanner::PlanningOnRef(const planning_msgs::TrajectoryPoint &init_trajectory_point,
+bool FrenetLatticePlanner::PlanningOnRef(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
+                                         const std::shared_ptr<const ObstacleOccupancy> &obstacle_occupancy,
+                                         const planning_msgs::TrajectoryPoint &init_trajectory_point,
                                          const PlanningTarget &planning_target,
                                          std::pair<planning_msgs::Trajectory, double> &optimal_trajectory,
                                          std::vector<planning_msgs::Trajectory> *valid_trajectories) const {
@@ -65,16 +110,18 @@ bool FrenetLatticePlanner::PlanningOnRef(const planning_msgs::TrajectoryPoint &i
   std::array<double, 3> init_d{};
   FrenetLatticePlanner::GetInitCondition(ref_line, init_trajectory_point, &init_s, &init_d);
 //  auto obstacle_vec = planning_target.obstacles;
-  auto st_graph = std::make_shared<STGraph>(obstacles_, ref_line,
+  auto st_graph = std::make_shared<STGraph>(obstacles, ref_line,
                                             init_s[0],
                                             init_s[0] + PlanningConfig::Instance().max_lookahead_distance(),
                                             0.0, PlanningConfig::Instance().max_lookahead_time(),
                                             init_d,
                                             PlanningConfig::Instance().max_lookahead_time(),
-                                            PlanningConfig::Instance().delta_t());
+                                            PlanningConfig::Instance().delta_t(),
+                                            st_graph_cache_.get(),
+                                            thread_pool_);
 #if DEBUG
-  std::cout << " obstacles_.size()" << obstacles_.size() << std::endl;
-  for (const auto &obstacle : obstacles_) {
+  std::cout << " obstacles.size()" << obstacles.size() << std::endl;
+  for (const auto &obstacle : obstacles) {
     std::cout << "obstacle id: " << obstacle->Id() << " obstacle is static : "
               << (obstacle->IsStatic() ? "true" : "false")
               << ", length: " << obstacle->GetBoundingBox().length() << ", width: "
@@ -87,35 +134,26 @@ bool FrenetLatticePlanner::PlanningOnRef(const planning_msgs::TrajectoryPoint &i
   std::vector<std::shared_ptr<Polynomial>> lat_traj_vec;
 
   auto end_condition_sampler =
-      std::make_shared<EndConditionSampler>(init_s, init_d, ref_line, obstacles_, st_graph);
+      std::make_shared<EndConditionSampler>(init_s, init_d, ref_line, obstacles, st_graph);
   FrenetLatticePlanner::GenerateLonTrajectories(planning_target, init_s, end_condition_sampler, &lon_traj_vec);
   FrenetLatticePlanner::GenerateLatTrajectories(init_d, end_condition_sampler, &lat_traj_vec);
   ROS_INFO("[PlanningOnRef] : the lon end conditions size is %zu, the lat end_conditions size is %zu",
            lon_traj_vec.size(),
            lat_traj_vec.size());
 
-  PolynomialTrajectoryEvaluator trajectory_evaluator = PolynomialTrajectoryEvaluator(init_s,
-                                                                                     planning_target,
-                                                                                     lon_traj_vec,
-                                                                                     lat_traj_vec,
-                                                                                     ref_line, st_graph,
-                                                                                     thread_pool_);
-  std::unordered_map<int, std::shared_ptr<Obstacle>> obstacle_map;
-  for (const auto &obstacle : obstacles_) {
-    obstacle_map.emplace(obstacle->Id(), obstacle);
-  }
-#if DEBUG
-  std::cout << " ======== obstacle size : " << obstacle_map.size() << std::endl;
-#endif
-  CollisionChecker collision_checker = CollisionChecker(obstacle_map,
+  PolynomialTrajectoryEvaluator trajectory_evaluator(init_s,
+                                                    planning_target,
+                                                    lon_traj_vec,
+                                                    lat_traj_vec,
+                                                    ref_line, st_graph,
+                                                    thread_pool_);
+  // no pool: a planned trajectory has at most max_lookahead_time / delta_t + 1 points, too few for the chunked
+  // parallel collision check to pay off, see CollisionChecker
+  CollisionChecker collision_checker = CollisionChecker(obstacle_occupancy,
                                                         ref_line,
                                                         st_graph,
                                                         init_s[0],
                                                         init_d[0],
-                                                        PlanningConfig::Instance().lon_safety_buffer(),
-                                                        PlanningConfig::Instance().lat_safety_buffer(),
-                                                        PlanningConfig::Instance().max_lookahead_time(),
-                                                        PlanningConfig::Instance().delta_t(),
                                                         PlanningConfig::Instance().vehicle_params(),
                                                         nullptr);
   size_t collision_failure_count = 0;
@@ -131,12 +169,30 @@ bool FrenetLatticePlanner::PlanningOnRef(const planning_msgs::TrajectoryPoint &i
   if (!trajectory_evaluator.has_more_trajectory_pairs()) {
     ROS_FATAL("[PlanningOnRef]: Failed Reason: no Valid trajectory pairs");
   }
-  while (trajectory_evaluator.has_more_trajectory_pairs()) {
-    double trajectory_pair_cost = trajectory_evaluator.top_trajectory_pair_cost();
-    auto trajectory_pair = trajectory_evaluator.next_top_trajectory_pair();
-    auto combined_trajectory = CombineTrajectories(ref_line, *trajectory_pair.first, *trajectory_pair.second,
-                                                   init_trajectory_point.relative_time);
-    auto result = ConstraintChecker::ValidTrajectory(combined_trajectory);
+  // combine and check one pair, the collision is only checked for the trajectory satisfying the constraints
+  const auto &sample_cache = trajectory_evaluator.sample_cache();
+  auto check_trajectory_pair = [&ref_line, &init_trajectory_point, &collision_checker, &sample_cache](
+      const PolynomialTrajectoryEvaluator::TrajectoryPair &trajectory_pair) -> TrajectoryCheckResult {
+    TrajectoryCheckResult check_result;
+    size_t lon_index = 0;
+    size_t lat_index = 0;
+    if (sample_cache.FindLonIndex(trajectory_pair.first.get(), &lon_index) &&
+        sample_cache.FindLatIndex(trajectory_pair.second.get(), &lat_index)) {
+      check_result.trajectory = CombineTrajectories(ref_line, sample_cache, lon_index, lat_index,
+                                                    init_trajectory_point.relative_time);
+    } else {
+      check_result.trajectory = CombineTrajectories(ref_line, *trajectory_pair.first, *trajectory_pair.second,
+                                                    init_trajectory_point.relative_time);
+    }
+    check_result.constraint_result = ConstraintChecker::ValidTrajectory(check_result.trajectory);
+    if (check_result.constraint_result == ConstraintChecker::Result::VALID) {
+      check_result.is_collision = collision_checker.IsCollision(check_result.trajectory);
+    }
+    return check_result;
+  };
+  // returns true if the checked trajectory is valid
+  auto record_check_result = [&](const TrajectoryCheckResult &check_result) -> bool {
+    const auto result = check_result.constraint_result;
     if (result != ConstraintChecker::Result::VALID) {
       ++combined_constraint_failure_count;
       switch (result) {
@@ -167,25 +223,60 @@ bool FrenetLatticePlanner::PlanningOnRef(const planning_msgs::TrajectoryPoint &i
         case ConstraintChecker::Result::VALID:
         default: { break; }
       }
-      continue;
+      return false;
     }
-//    if (CollisionChecker::IsCollision(obstacles_, ref_line, combined_trajectory,
-//                                       PlanningConfig::Instance().vehicle_params().length
-//                                           + 2.0 * PlanningConfig::Instance().lon_safety_buffer(),
-//                                       PlanningConfig::Instance().vehicle_params().width
-//                                           +2.0* PlanningConfig::Instance().lat_safety_buffer(),
-//                                       PlanningConfig::Instance().vehicle_params().back_axle_to_center_length)) {
-//      ++collision_failure_count;
-//      continue;
-//    }
-    if (collision_checker.IsCollision(combined_trajectory)) {
+    if (check_result.is_collision) {
       ++collision_failure_count;
-      continue;
+      return false;
+    }
+    return true;
+  };
+
+  const size_t batch_size = static_cast<size_t>(std::max(1, PlanningConfig::Instance().validation_batch_size()));
+  if (thread_pool_ != nullptr && PlanningConfig::Instance().enable_parallel_validation() && batch_size > 1) {
+    // speculatively check the next batch_size pairs in cost order, the first valid one in that order wins,
+    // so the result is the same as the serial loop below.
+    std::vector<std::pair<PolynomialTrajectoryEvaluator::TrajectoryPair, double>> batch;
+    std::vector<std::future<TrajectoryCheckResult>> futures;
+    while (num_lattice_traj == 0 && trajectory_evaluator.has_more_trajectory_pairs()) {
+      batch.clear();
+      futures.clear();
+      while (batch.size() < batch_size && trajectory_evaluator.has_more_trajectory_pairs()) {
+        double trajectory_pair_cost = trajectory_evaluator.top_trajectory_pair_cost();
+        batch.emplace_back(trajectory_evaluator.next_top_trajectory_pair(), trajectory_pair_cost);
+      }
+      for (const auto &candidate : batch) {
+        futures.push_back(thread_pool_->PushTask(check_trajectory_pair, candidate.first));
+      }
+      // every future is waited on, the tasks capture this frame by reference
+      std::vector<TrajectoryCheckResult> check_results;
+      check_results.reserve(futures.size());
+      for (auto &future : futures) {
+        check_results.push_back(future.get());
+      }
+      for (size_t i = 0; i < check_results.size(); ++i) {
+        if (!record_check_result(check_results[i])) {
+          continue;
+        }
+        num_lattice_traj += 1;
+        optimal_trajectory.second = batch[i].second;
+        optimal_trajectory.first = std::move(check_results[i].trajectory);
+        break;
+      }
+    }
+  } else {
+    while (trajectory_evaluator.has_more_trajectory_pairs()) {
+      double trajectory_pair_cost = trajectory_evaluator.top_trajectory_pair_cost();
+      auto trajectory_pair = trajectory_evaluator.next_top_trajectory_pair();
+      auto check_result = check_trajectory_pair(trajectory_pair);
+      if (!record_check_result(check_result)) {
+        continue;
+      }
+      num_lattice_traj += 1;
+      optimal_trajectory.second = trajectory_pair_cost;
+      optimal_trajectory.first = std::move(check_result.trajectory);
+      break;
     }
-    num_lattice_traj += 1;
-    optimal_trajectory.second = trajectory_pair_cost;
-    optimal_trajectory.first = combined_trajectory;
-    break;
   }
   ROS_WARN(
       "[PlanningOnRef]: the lon_vel_failure_count:%zu,  lon_acc_failure_count: %zu,  lon_jerk_failure_count: %zu,  curvature_failure_count: %zu,"
@@ -217,10 +308,8 @@ planning_msgs::Trajectory FrenetLatticePlanner::CombineTrajectories(const Refere
                                                                     double start_time) {
   double s0 = lon_traj.Evaluate(0, 0.0);
   double s_ref_max = ref_line.Length();
-  double accumulated_s = 0.0;
   double last_s = -1.0 * std::numeric_limits<double>::epsilon();
   double t_param = 0.0;
-  planning_msgs::PathPoint prev_path_point;
   planning_msgs::Trajectory combined_trajectory;
   while (t_param < PlanningConfig::Instance().max_lookahead_time()) {
     double s = lon_traj.Evaluate(0, t_param);
@@ -234,50 +323,95 @@ planning_msgs::Trajectory FrenetLatticePlanner::CombineTrajectories(const Refere
       break;
     }
     double relative_s = s - s0;
-    double d = lat_traj.Evaluate(0, relative_s);
-    double d_prime = lat_traj.Evaluate(1, relative_s);
-    double d_prime_prime = lat_traj.Evaluate(2, relative_s);
-    auto matched_re_point = ref_line.GetReferencePoint(s);
-    double x = 0;
-    double y = 0.0;
-    double theta = 0.0;
-    double kappa = 0.0;
-    double v = 0.0;
-    double a = 0.0;
-    const double rs = s;
-    const double rx = matched_re_point.x();
-    const double ry = matched_re_point.y();
-    const double rtheta = matched_re_point.theta();
-    const double rkappa = matched_re_point.kappa();
-    const double rdkappa = matched_re_point.dkappa();
-    std::array<double, 3> s_conditions = {rs, s_dot, s_dot_dot};
-    std::array<double, 3> d_conditions = {d, d_prime, d_prime_prime};
-    CoordinateTransformer::FrenetToCartesian(rs, rx, ry,
-                                             rtheta, rkappa, rdkappa,
-                                             s_conditions, d_conditions,
-                                             &x, &y, &theta,
-                                             &kappa, &v, &a);
-    if (t_param >= PlanningConfig::Instance().delta_t()) {
-      double delta_x = x - prev_path_point.x;
-      double delta_y = y - prev_path_point.y;
-      accumulated_s += std::hypot(delta_x, delta_y);
-    }
-    planning_msgs::TrajectoryPoint tp;
-    tp.path_point.x = x;
-    tp.path_point.y = y;
-    tp.path_point.theta = theta;
-    tp.path_point.kappa = kappa;
-    tp.path_point.s = accumulated_s;
-    tp.vel = v;
-    tp.acc = a;
-    tp.relative_time = start_time + t_param;
-    combined_trajectory.trajectory_points.push_back(tp);
+    std::array<double, 3> s_conditions = {s, s_dot, s_dot_dot};
+    std::array<double, 3> d_conditions = {lat_traj.Evaluate(0, relative_s),
+                                          lat_traj.Evaluate(1, relative_s),
+                                          lat_traj.Evaluate(2, relative_s)};
+    AppendCombinedTrajectoryPoint(ref_line, s_conditions, d_conditions, start_time + t_param, &combined_trajectory);
     t_param += PlanningConfig::Instance().delta_t();
-    prev_path_point = tp.path_point;
   }
   return combined_trajectory;
 }
 
+planning_msgs::Trajectory FrenetLatticePlanner::CombineTrajectories(const ReferenceLine &ref_line,
+                                                                    const TrajectorySampleCache &sample_cache,
+                                                                    size_t lon_index,
+                                                                    size_t lat_index,
+                                                                    double start_time) {
+  // the time grid of the cache is accumulated by delta_t from 0, the same as the loop above
+  const auto &t_samples = sample_cache.t_samples();
+  const double *s_samples = sample_cache.LonSamples(0, lon_index);
+  const double *s_dot_samples = sample_cache.LonSamples(1, lon_index);
+  const double *s_ddot_samples = sample_cache.LonSamples(2, lon_index);
+  // the lat trajectory is evaluated exactly at the s of the samples, its interpolated samples would make d, d', d''
+  // and so the curvature of the trajectory approximate
+  const auto &lat_traj = *sample_cache.LatTrajectory(lat_index);
+  double s0 = s_samples[0];
+  double s_ref_max = ref_line.Length();
+  double last_s = -1.0 * std::numeric_limits<double>::epsilon();
+  planning_msgs::Trajectory combined_trajectory;
+  for (size_t i = 0; i < t_samples.size() && t_samples[i] < PlanningConfig::Instance().max_lookahead_time(); ++i) {
+    double s = s_samples[i];
+    if (last_s > 0.0) {
+      s = std::max(last_s, s);
+    }
+    last_s = s;
+    double s_dot = std::max(std::numeric_limits<double>::epsilon(), s_dot_samples[i]);
+    double s_dot_dot = s_ddot_samples[i];
+    if (s > s_ref_max) {
+      break;
+    }
+    double relative_s = s - s0;
+    std::array<double, 3> s_conditions = {s, s_dot, s_dot_dot};
+    std::array<double, 3> d_conditions = {lat_traj.Evaluate(0, relative_s),
+                                          lat_traj.Evaluate(1, relative_s),
+                                          lat_traj.Evaluate(2, relative_s)};
+    AppendCombinedTrajectoryPoint(ref_line, s_conditions, d_conditions, start_time + t_samples[i],
+                                  &combined_trajectory);
+  }
+  return combined_trajectory;
+}
+
+void FrenetLatticePlanner::AppendCombinedTrajectoryPoint(const ReferenceLine &ref_line,
+                                                         const std::array<double, 3> &s_conditions,
+                                                         const std::array<double, 3> &d_conditions,
+                                                         double relative_time,
+                                                         planning_msgs::Trajectory *combined_trajectory) {
+  auto matched_re_point = ref_line.GetReferencePoint(s_conditions[0]);
+  double x = 0;
+  double y = 0.0;
+  double theta = 0.0;
+  double kappa = 0.0;
+  double v = 0.0;
+  double a = 0.0;
+  const double rs = s_conditions[0];
+  const double rx = matched_re_point.x();
+  const double ry = matched_re_point.y();
+  const double rtheta = matched_re_point.theta();
+  const double rkappa = matched_re_point.kappa();
+  const double rdkappa = matched_re_point.dkappa();
+  CoordinateTransformer::FrenetToCartesian(rs, rx, ry,
+                                           rtheta, rkappa, rdkappa,
+                                           s_conditions, d_conditions,
+                                           &x, &y, &theta,
+                                           &kappa, &v, &a);
+  double accumulated_s = 0.0;
+  if (!combined_trajectory->trajectory_points.empty()) {
+    const auto &prev_path_point = combined_trajectory->trajectory_points.back().path_point;
+    accumulated_s = prev_path_point.s + std::hypot(x - prev_path_point.x, y - prev_path_point.y);
+  }
+  planning_msgs::TrajectoryPoint tp;
+  tp.path_point.x = x;
+  tp.path_point.y = y;
+  tp.path_point.theta = theta;
+  tp.path_point.kappa = kappa;
+  tp.path_point.s = accumulated_s;
+  tp.vel = v;
+  tp.acc = a;
+  tp.relative_time = relative_time;
+  combined_trajectory->trajectory_points.push_back(tp);
+}
+
 void FrenetLatticePlanner::GenerateLatTrajectories(const std::array<double, 3> &init_d,
                                                    const std::shared_ptr<EndConditionSampler> &end_condition_sampler,
                                                    std::vector<std::shared_ptr<Polynomial>> *ptr_lat_traj_vec) {
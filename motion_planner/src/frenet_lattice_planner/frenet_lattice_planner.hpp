@@ -5,9 +5,13 @@
 #include <planning_msgs/Trajectory.h>
 #include "trajectory_planner.hpp"
 #include "end_condition_sampler.hpp"
+#include "constraint_checker.hpp"
+#include "trajectory_sample_cache.hpp"
 #include "curves/quartic_polynomial.hpp"
 #include "curves/quintic_polynomial.hpp"
 #include "thread_pool/thread_pool.hpp"
+#include "collision_checker/obstacle_occupancy.hpp"
+#include "obstacle_manager/st_graph_cache.hpp"
 
 namespace planning {
 
@@ -35,15 +39,29 @@ class FrenetLatticePlanner : public TrajectoryPlanner {
 
  protected:
 
+  /**
+   * @brief: the combined trajectory of a lon-lat pair and the result of checking it
+   */
+  struct TrajectoryCheckResult {
+    planning_msgs::Trajectory trajectory;
+    ConstraintChecker::Result constraint_result = ConstraintChecker::Result::VALID;
+    bool is_collision = false;
+  };
+
   static void GenerateEmergencyStopTrajectory(const planning_msgs::TrajectoryPoint &init_trajectory_point,
                                               planning_msgs::Trajectory &stop_trajectory);
   /**
-   * @brief: generate lon trajectories and lat trajectories
-   * @param maneuver_info: maneuver goal, comes from maneuver planner
-   * @param[out] ptr_lon_traj_vec: lon trajectories
-   * @param[out] ptr_lat_traj_vec: lat trajectories
+   * @brief: plan on a single reference line, reentrant, so the lines can be planned concurrently
+   * @param obstacles: the key obstacles
+   * @param obstacle_occupancy: the buffered predicted boxes of the key obstacles, shared by every reference line
+   * @param init_trajectory_point
+   * @param planning_target
+   * @param[out] optimal_trajectory: the optimal trajectory and its cost
+   * @param[out] valid_trajectories
    */
-  bool PlanningOnRef(const planning_msgs::TrajectoryPoint &init_trajectory_point,
+  bool PlanningOnRef(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
+                     const std::shared_ptr<const ObstacleOccupancy> &obstacle_occupancy,
+                     const planning_msgs::TrajectoryPoint &init_trajectory_point,
                      const PlanningTarget &planning_target,
                      std::pair<planning_msgs::Trajectory, double> &optimal_trajectory,
                      std::vector<planning_msgs::Trajectory> *valid_trajectories) const;
@@ -61,6 +79,35 @@ class FrenetLatticePlanner : public TrajectoryPlanner {
                                                        const common::Polynomial &lat_traj,
                                                        double start_time);
 
+  /**
+   * @brief: combine the lon and lat trajectories from the cached lon samples and the exact lat trajectory
+   * @param ref_line: reference line
+   * @param sample_cache: samples of the lon and lat trajectories
+   * @param lon_index: index of the lon trajectory in the cache
+   * @param lat_index: index of the lat trajectory in the cache
+   * @param start_time
+   * @return
+   */
+  static planning_msgs::Trajectory CombineTrajectories(const ReferenceLine &ref_line,
+                                                       const TrajectorySampleCache &sample_cache,
+                                                       size_t lon_index,
+                                                       size_t lat_index,
+                                                       double start_time);
+
+  /**
+   * @brief: convert a frenet state to cartesian and append it to the combined trajectory
+   * @param ref_line
+   * @param s_conditions: s, s_dot, s_ddot
+   * @param d_conditions: d, d_prime, d_primeprime
+   * @param relative_time
+   * @param combined_trajectory
+   */
+  static void AppendCombinedTrajectoryPoint(const ReferenceLine &ref_line,
+                                            const std::array<double, 3> &s_conditions,
+                                            const std::array<double, 3> &d_conditions,
+                                            double relative_time,
+                                            planning_msgs::Trajectory *combined_trajectory);
+
  private:
 
   static void GetInitCondition(const ReferenceLine &ptr_ref_line,
@@ -128,7 +175,8 @@ class FrenetLatticePlanner : public TrajectoryPlanner {
                                              std::vector<std::shared_ptr<common::Polynomial>> *ptr_traj_vec);
  private:
   common::ThreadPool *thread_pool_ = nullptr;
-  std::vector<std::shared_ptr<Obstacle>> obstacles_;
+  // the sl boundaries of the last cycle, shared by the st graphs of every reference line
+  std::shared_ptr<STGraphCache> st_graph_cache_;
 };
 
 }
@@ -1,14 +1,135 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <tf/transform_datatypes.h>
 #include "lattice_trajectory1d.hpp"
 #include "curves/quintic_polynomial.hpp"
+#include "curves/quartic_polynomial.hpp"
+#include "trajectory_sample_cache.hpp"
+#include "collision_checker/test_fixtures.hpp"
 #define private public
+#define protected public
 #include "frenet_lattice_planner.hpp"
+#include "polynomial_trajectory_evaluator.hpp"
+#undef protected
 #undef private
 
 #include <boost/numeric/odeint.hpp>
 
 namespace planning {
 
+namespace {
+// the planning params of motion_planner_params.yaml the lattice planner reads
+void SetUpLatticeConfig() {
+  auto &config = PlanningConfig::Instance();
+  config.delta_t_ = 0.1;
+  config.max_lookahead_time_ = 8.0;
+  config.max_lookahead_distance_ = 100.0;
+  config.lon_safety_buffer_ = 2.0;
+  config.lat_safety_buffer_ = 0.3;
+  config.max_lon_acc_ = 4.0;
+  config.min_lon_acc_ = -4.0;
+  config.max_lon_velocity_ = 40.0;
+  config.min_lon_velocity_ = -0.01;
+  config.max_lon_jerk_ = 8.0;
+  config.min_lon_jerk_ = -8.0;
+  config.lattice_weight_opposite_side_offset_ = 10.0;
+  config.lattice_weight_same_side_offset_ = 1.0;
+  config.lattice_weight_dist_travelled_ = 10.0;
+  config.lattice_weight_target_speed_ = 1.0;
+  config.lattice_weight_collision_ = 5.0;
+  config.lattice_weight_lon_jerk_ = 0.5;
+  config.lattice_weight_lon_target_ = 10.0;
+  config.lattice_weight_lat_offset_ = 7.0;
+  config.lattice_weight_lat_jerk_ = 5.0;
+  config.lattice_weight_centripetal_acc_ = 1.0;
+  config.min_lookahead_time_ = 0.1;
+  config.min_kappa_ = -3.0;
+  config.max_kappa_ = 3.0;
+  config.min_lat_acc_ = -3.0;
+  config.max_lat_acc_ = 3.0;
+  config.vehicle_params_.length = 4.7;
+  config.vehicle_params_.width = 2.0;
+  config.vehicle_params_.half_length = 2.35;
+  config.vehicle_params_.half_width = 1.0;
+}
+
+// a left turn of radius 50 m, 118 m long
+ReferenceLine MakeCurvedReferenceLine() {
+  std::vector<planning_msgs::WayPoint> way_points(60);
+  for (size_t i = 0; i < way_points.size(); ++i) {
+    double theta = 2.0 * i / 50.0;
+    way_points[i].s = 2.0 * i;
+    way_points[i].pose.position.x = 50.0 * std::sin(theta);
+    way_points[i].pose.position.y = 50.0 * (1.0 - std::cos(theta));
+    way_points[i].pose.orientation = tf::createQuaternionMsgFromYaw(theta);
+    way_points[i].lane_width = 3.5;
+  }
+  return ReferenceLine(way_points);
+}
+
+// a car standing on the center of MakeCurvedReferenceLine at s, predicted
+std::shared_ptr<Obstacle> MakeStandingObstacle(int id, double s) {
+  const double theta = s / 50.0;
+  auto obstacle = test::MakeObstacle(id, 50.0 * std::sin(theta), 50.0 * (1.0 - std::cos(theta)), theta, 0.0);
+  obstacle->PredictTrajectory(PlanningConfig::Instance().max_lookahead_time(), PlanningConfig::Instance().delta_t());
+  return obstacle;
+}
+
+// the state at s on the center of MakeCurvedReferenceLine
+planning_msgs::TrajectoryPoint MakeInitTrajectoryPoint(double s, double v) {
+  const double theta = s / 50.0;
+  planning_msgs::TrajectoryPoint init_trajectory_point;
+  init_trajectory_point.path_point.x = 50.0 * std::sin(theta);
+  init_trajectory_point.path_point.y = 50.0 * (1.0 - std::cos(theta));
+  init_trajectory_point.path_point.theta = theta;
+  init_trajectory_point.path_point.kappa = 1.0 / 50.0;
+  init_trajectory_point.vel = v;
+  init_trajectory_point.acc = 0.0;
+  init_trajectory_point.relative_time = 0.0;
+  return init_trajectory_point;
+}
+
+void ExpectSameTrajectory(const planning_msgs::Trajectory &trajectory, const planning_msgs::Trajectory &expected) {
+  ASSERT_EQ(trajectory.trajectory_points.size(), expected.trajectory_points.size());
+  for (size_t i = 0; i < expected.trajectory_points.size(); ++i) {
+    EXPECT_EQ(trajectory.trajectory_points[i].relative_time, expected.trajectory_points[i].relative_time);
+    EXPECT_EQ(trajectory.trajectory_points[i].path_point.x, expected.trajectory_points[i].path_point.x);
+    EXPECT_EQ(trajectory.trajectory_points[i].path_point.y, expected.trajectory_points[i].path_point.y);
+    EXPECT_EQ(trajectory.trajectory_points[i].vel, expected.trajectory_points[i].vel);
+  }
+}
+
+// cruising and stopping lon trajectories from init_s, some of them exceed the lon limits
+std::vector<std::shared_ptr<common::Polynomial>> MakeLonTrajectories(const std::array<double, 3> &init_s) {
+  std::vector<std::shared_ptr<common::Polynomial>> lon_trajectories;
+  for (double v : {0.0, 4.0, 8.0, 12.0, 16.0}) {
+    for (double t : {3.0, 5.0, 8.0}) {
+      lon_trajectories.push_back(std::make_shared<LatticeTrajectory1d>(
+          std::make_shared<common::QuarticPolynomial>(init_s[0], init_s[1], init_s[2], v, 0.0, t)));
+    }
+  }
+  for (double s : {30.0, 50.0}) {
+    for (double t : {6.0, 8.0}) {
+      lon_trajectories.push_back(std::make_shared<LatticeTrajectory1d>(
+          std::make_shared<common::QuinticPolynomial>(init_s, std::array<double, 3>{s, 0.0, 0.0}, t)));
+    }
+  }
+  return lon_trajectories;
+}
+
+// lat trajectories from init_d, the ones to 2.5 m leave the lane
+std::vector<std::shared_ptr<common::Polynomial>> MakeLatTrajectories(const std::array<double, 3> &init_d) {
+  std::vector<std::shared_ptr<common::Polynomial>> lat_trajectories;
+  for (double d : {-2.5, -1.0, -0.5, 0.0, 0.5, 1.0}) {
+    for (double s : {20.0, 40.0, 60.0}) {
+      lat_trajectories.push_back(std::make_shared<LatticeTrajectory1d>(
+          std::make_shared<common::QuinticPolynomial>(init_d, std::array<double, 3>{d, 0.0, 0.0}, s)));
+    }
+  }
+  return lat_trajectories;
+}
+}
+
 TEST(LatticeTrajectroyTest, generate_lattice_trajectory1d_test) {
   std::array<double, 3> init_d{-1.43473, 0.4, 0.0};
   std::array<double, 3> end_d{0.5, 0, 0};
@@ -86,6 +207,271 @@ TEST(LatticeTrajectoryTest, lattice_planner_trajectory_generator) {
     }
   }
 }
+TEST(LatticeTrajectoryTest, trajectory_sample_cache) {
+  std::vector<std::shared_ptr<common::Polynomial>> lon_trajectories;
+  lon_trajectories.push_back(std::make_shared<LatticeTrajectory1d>(
+      std::make_shared<common::QuinticPolynomial>(std::array<double, 3>{30.0, 15.0, 0.0},
+                                                  std::array<double, 3>{70.0, 8.0, 0.0}, 4.0)));
+  lon_trajectories.push_back(std::make_shared<LatticeTrajectory1d>(
+      std::make_shared<common::QuarticPolynomial>(30.0, 15.0, 0.0, 10.0, 0.0, 6.0)));
+  std::vector<std::shared_ptr<common::Polynomial>> lat_trajectories;
+  lat_trajectories.push_back(std::make_shared<LatticeTrajectory1d>(
+      std::make_shared<common::QuinticPolynomial>(std::array<double, 3>{-1.43473, 0.4, 0.0},
+                                                  std::array<double, 3>{0.5, 0.0, 0.0}, 20.0)));
+  TrajectorySampleCache cache(lon_trajectories, lat_trajectories, 0.1, 8.0, 0.1, 40.0);
+
+  size_t index = 0;
+  EXPECT_TRUE(cache.FindLonIndex(lon_trajectories[1].get(), &index));
+  EXPECT_EQ(index, 1);
+  EXPECT_FALSE(cache.FindLatIndex(lon_trajectories[1].get(), &index));
+  // the lon samples equal the trajectory, including the extrapolated part
+  EXPECT_GT(cache.t_samples().back() + 0.1, 8.0);
+  for (size_t n = 0; n < lon_trajectories.size(); ++n) {
+    for (size_t i = 0; i < cache.t_samples().size(); ++i) {
+      double t = cache.t_samples()[i];
+      for (size_t order = 0; order < 4; ++order) {
+        EXPECT_DOUBLE_EQ(cache.LonSamples(order, n)[i], lon_trajectories[n]->Evaluate(order, t));
+      }
+    }
+  }
+  // the lat samples are interpolated between the grid points
+  for (double s = 0.0; s < 45.0; s += 0.37) {
+    EXPECT_NEAR(cache.LatSample(0, 0, s), lat_trajectories[0]->Evaluate(0, s), 1e-3);
+    EXPECT_NEAR(cache.LatSample(1, 0, s), lat_trajectories[0]->Evaluate(1, s), 1e-3);
+    EXPECT_NEAR(cache.LatSample(2, 0, s), lat_trajectories[0]->Evaluate(2, s), 1e-3);
+  }
+}
+
+TEST(LatticeTrajectoryTest, combine_trajectories_from_sample_cache) {
+  SetUpLatticeConfig();
+  const ReferenceLine ref_line = MakeCurvedReferenceLine();
+  std::vector<std::shared_ptr<common::Polynomial>> lon_trajectories;
+  lon_trajectories.push_back(std::make_shared<LatticeTrajectory1d>(
+      std::make_shared<common::QuarticPolynomial>(10.0, 8.0, 0.0, 10.0, 0.0, 6.0)));
+  std::vector<std::shared_ptr<common::Polynomial>> lat_trajectories;
+  // a short lane change, its curvature is far from linear on the 0.1 m grid of the cache
+  lat_trajectories.push_back(std::make_shared<LatticeTrajectory1d>(
+      std::make_shared<common::QuinticPolynomial>(std::array<double, 3>{0.0, 0.0, 0.0},
+                                                  std::array<double, 3>{3.5, 0.0, 0.0}, 12.0)));
+  TrajectorySampleCache cache(lon_trajectories, lat_trajectories, 0.1, 8.0, 0.1, 80.0);
+  auto expected = FrenetLatticePlanner::CombineTrajectories(ref_line, *lon_trajectories[0], *lat_trajectories[0], 1.0);
+  auto combined = FrenetLatticePlanner::CombineTrajectories(ref_line, cache, 0, 0, 1.0);
+  ASSERT_GT(expected.trajectory_points.size(), 10);
+  ASSERT_EQ(combined.trajectory_points.size(), expected.trajectory_points.size());
+  for (size_t i = 0; i < expected.trajectory_points.size(); ++i) {
+    const auto &point = combined.trajectory_points[i];
+    const auto &expected_point = expected.trajectory_points[i];
+    EXPECT_NEAR(point.relative_time, expected_point.relative_time, 1e-9);
+    EXPECT_NEAR(point.path_point.x, expected_point.path_point.x, 1e-9);
+    EXPECT_NEAR(point.path_point.y, expected_point.path_point.y, 1e-9);
+    EXPECT_NEAR(point.path_point.theta, expected_point.path_point.theta, 1e-9);
+    EXPECT_NEAR(point.path_point.kappa, expected_point.path_point.kappa, 1e-9);
+    EXPECT_NEAR(point.vel, expected_point.vel, 1e-9);
+    EXPECT_NEAR(point.acc, expected_point.acc, 1e-9);
+  }
+}
+
+TEST(LatticeTrajectoryTest, evaluator_pair_costs) {
+  SetUpLatticeConfig();
+  const auto &config = PlanningConfig::Instance();
+  const ReferenceLine ref_line = MakeCurvedReferenceLine();
+  const std::array<double, 3> init_s{5.0, 8.0, 0.0};
+  const std::array<double, 3> init_d{0.3, 0.0, 0.0};
+  PlanningTarget planning_target;
+  planning_target.desired_vel = 10.0;
+  planning_target.ref_lane = ref_line;
+  auto st_graph = std::make_shared<STGraph>(std::vector<std::shared_ptr<Obstacle>>{}, ref_line,
+                                            init_s[0], init_s[0] + config.max_lookahead_distance(),
+                                            0.0, config.max_lookahead_time(), init_d,
+                                            config.max_lookahead_time(), config.delta_t());
+  PolynomialTrajectoryEvaluator evaluator(init_s, planning_target, MakeLonTrajectories(init_s),
+                                          MakeLatTrajectories(init_d), ref_line, st_graph, nullptr);
+  ASSERT_FALSE(evaluator.lon_candidates_.empty());
+  ASSERT_FALSE(evaluator.lat_candidates_.empty());
+  std::vector<double> t_values;
+  for (double t = 0.0; t < config.max_lookahead_time(); t += config.delta_t()) {
+    t_values.push_back(t);
+  }
+  // the cached lon costs against the lon terms computed from the trajectory, no obstacle, no collision cost
+  for (const auto &lon_candidate : evaluator.lon_candidates_) {
+    const auto &lon_traj = *lon_candidate.trajectory;
+    const double t_max = lon_traj.ParamLength();
+    double jerk_sqr_sum = 0.0;
+    double jerk_abs_sum = 0.0;
+    double speed_cost_sum = 0.0;
+    double speed_weight_sum = 0.0;
+    double centripetal_acc_sqr_sum = 0.0;
+    double centripetal_acc_abs_sum = 0.0;
+    for (const double t : t_values) {
+      double jerk = lon_traj.Evaluate(3, t) / config.max_lon_jerk();
+      jerk_sqr_sum += jerk * jerk;
+      jerk_abs_sum += std::fabs(jerk);
+      if (t <= t_max) {
+        speed_cost_sum += t * t * std::fabs(planning_target.desired_vel - lon_traj.Evaluate(1, t));
+        speed_weight_sum += t * t;
+      }
+      double v = lon_traj.Evaluate(1, t);
+      double centripetal_acc = v * v * ref_line.GetReferencePoint(lon_traj.Evaluate(0, t)).kappa();
+      centripetal_acc_sqr_sum += centripetal_acc * centripetal_acc;
+      centripetal_acc_abs_sum += std::fabs(centripetal_acc);
+    }
+    double dist_s = lon_traj.Evaluate(0, t_max) - lon_traj.Evaluate(0, 0.0);
+    double target_cost = speed_cost_sum / (speed_weight_sum + 1e-5) * config.lattice_weight_target_speed() +
+        1.0 / (1.0 + std::fabs(dist_s)) * config.lattice_weight_dist_travelled();
+    double expected_cost = jerk_sqr_sum / (jerk_abs_sum + 1e-5) * config.lattice_weight_lon_jerk() +
+        target_cost * config.lattice_weight_lon_target() +
+        centripetal_acc_sqr_sum / (centripetal_acc_abs_sum + 1e-5) * config.lattice_weight_centripetal_acc();
+    EXPECT_NEAR(lon_candidate.cost, expected_cost, 1e-9 * (1.0 + expected_cost));
+  }
+  // a pair adds the lat terms computed from the trajectories, the lat samples are interpolated
+  size_t num_valid_pairs = 0;
+  for (const auto &lon_candidate : evaluator.lon_candidates_) {
+    const auto &lon_traj = *lon_candidate.trajectory;
+    for (const auto &lat_candidate : evaluator.lat_candidates_) {
+      const auto &lat_traj = *lat_candidate.trajectory;
+      PolynomialTrajectoryEvaluator::TrajectoryCostPair trajectory_pair;
+      if (!evaluator.EvaluatePair(lon_candidate, lat_candidate, &trajectory_pair)) {
+        continue;
+      }
+      ++num_valid_pairs;
+      EXPECT_EQ(trajectory_pair.first.first.get(), &lon_traj);
+      EXPECT_EQ(trajectory_pair.first.second.get(), &lat_traj);
+      double lat_jerk_cost = 0.0;
+      for (const double t : t_values) {
+        double s_dot = lon_traj.Evaluate(1, t);
+        double relative_s = lon_traj.Evaluate(0, t) - init_s[0];
+        lat_jerk_cost = std::max(lat_jerk_cost, std::fabs(lat_traj.Evaluate(2, relative_s) * s_dot * s_dot +
+            lat_traj.Evaluate(1, relative_s) * lon_traj.Evaluate(2, t)));
+      }
+      double offset_sqr_sum = 0.0;
+      double offset_abs_sum = 0.0;
+      const double lat_offset_start = lat_traj.Evaluate(0, 0.0);
+      for (double s = 0.0; s < lon_candidate.evaluation_horizon; s += 0.1) {
+        double lat_offset = lat_traj.Evaluate(0, s);
+        double weight = lat_offset * lat_offset_start < 0.0 ? config.lattice_weight_opposite_side_offset()
+                                                            : config.lattice_weight_same_side_offset();
+        offset_sqr_sum += lat_offset / 3.0 * lat_offset / 3.0 * weight;
+        offset_abs_sum += std::fabs(lat_offset / 3.0) * weight;
+      }
+      double expected_cost = lon_candidate.cost + lat_jerk_cost * config.lattice_weight_lat_jerk() +
+          offset_sqr_sum / (offset_abs_sum + 1e-5) * config.lattice_weight_lat_offset();
+      EXPECT_NEAR(trajectory_pair.second, expected_cost, 1e-3 * (1.0 + expected_cost));
+    }
+  }
+  EXPECT_GT(num_valid_pairs, 0);
+  EXPECT_LT(num_valid_pairs, evaluator.lon_candidates_.size() * evaluator.lat_candidates_.size());
+}
+
+TEST(LatticeTrajectoryTest, evaluator_best_first_order) {
+  SetUpLatticeConfig();
+  const auto &config = PlanningConfig::Instance();
+  const ReferenceLine ref_line = MakeCurvedReferenceLine();
+  const std::array<double, 3> init_s{5.0, 8.0, 0.0};
+  const std::array<double, 3> init_d{0.3, 0.0, 0.0};
+  PlanningTarget planning_target;
+  planning_target.desired_vel = 10.0;
+  planning_target.ref_lane = ref_line;
+  auto st_graph = std::make_shared<STGraph>(std::vector<std::shared_ptr<Obstacle>>{}, ref_line,
+                                            init_s[0], init_s[0] + config.max_lookahead_distance(),
+                                            0.0, config.max_lookahead_time(), init_d,
+                                            config.max_lookahead_time(), config.delta_t());
+  PolynomialTrajectoryEvaluator evaluator(init_s, planning_target, MakeLonTrajectories(init_s),
+                                          MakeLatTrajectories(init_d), ref_line, st_graph, nullptr);
+  // every pair scored up front, the same as the fully materialised queue
+  std::vector<double> expected_costs;
+  for (const auto &lon_candidate : evaluator.lon_candidates_) {
+    for (const auto &lat_candidate : evaluator.lat_candidates_) {
+      PolynomialTrajectoryEvaluator::TrajectoryCostPair trajectory_pair;
+      if (evaluator.EvaluatePair(lon_candidate, lat_candidate, &trajectory_pair)) {
+        expected_costs.push_back(trajectory_pair.second);
+      }
+    }
+  }
+  std::sort(expected_costs.begin(), expected_costs.end());
+  ASSERT_FALSE(expected_costs.empty());
+  // the lazy frontier releases the same costs in the same order
+  std::vector<double> costs;
+  while (evaluator.has_more_trajectory_pairs()) {
+    EXPECT_GE(evaluator.num_of_trajectory_pairs(), expected_costs.size() - costs.size());
+    const double cost = evaluator.top_trajectory_pair_cost();
+    auto trajectory_pair = evaluator.next_top_trajectory_pair();
+    EXPECT_TRUE(trajectory_pair.first != nullptr && trajectory_pair.second != nullptr);
+    costs.push_back(cost);
+  }
+  ASSERT_EQ(costs.size(), expected_costs.size());
+  for (size_t i = 0; i < costs.size(); ++i) {
+    EXPECT_DOUBLE_EQ(costs[i], expected_costs[i]) << "i: " << i;
+  }
+}
+
+TEST(LatticeTrajectoryTest, parallel_validation_same_as_serial) {
+  SetUpLatticeConfig();
+  auto &config = PlanningConfig::Instance();
+  PlanningTarget planning_target;
+  planning_target.desired_vel = 10.0;
+  planning_target.ref_lane = MakeCurvedReferenceLine();
+  planning_target.is_best_behaviour = true;
+  // the car ahead rejects the cheapest pairs, the winner is not in the first batch
+  const std::vector<std::shared_ptr<Obstacle>> obstacles{MakeStandingObstacle(1, 35.0)};
+  auto obstacle_occupancy = std::make_shared<ObstacleOccupancy>(obstacles, config.lon_safety_buffer(),
+                                                                config.lat_safety_buffer(),
+                                                                config.max_lookahead_time(), config.delta_t());
+  const auto init_trajectory_point = MakeInitTrajectoryPoint(5.0, 8.0);
+
+  FrenetLatticePlanner serial_planner;
+  std::pair<planning_msgs::Trajectory, double> expected;
+  ASSERT_TRUE(serial_planner.PlanningOnRef(obstacles, obstacle_occupancy, init_trajectory_point, planning_target,
+                                           expected, nullptr));
+
+  common::ThreadPool thread_pool(4);
+  FrenetLatticePlanner parallel_planner(&thread_pool);
+  config.enable_parallel_validation_ = true;
+  for (int batch_size : {2, 3, 8}) {
+    config.validation_batch_size_ = batch_size;
+    std::pair<planning_msgs::Trajectory, double> optimal_trajectory;
+    EXPECT_TRUE(parallel_planner.PlanningOnRef(obstacles, obstacle_occupancy, init_trajectory_point,
+                                               planning_target, optimal_trajectory, nullptr));
+    EXPECT_EQ(optimal_trajectory.second, expected.second) << "batch size: " << batch_size;
+    ExpectSameTrajectory(optimal_trajectory.first, expected.first);
+  }
+  config.enable_parallel_validation_ = false;
+  config.validation_batch_size_ = 8;
+}
+
+TEST(LatticeTrajectoryTest, concurrent_reference_lines_same_as_serial) {
+  SetUpLatticeConfig();
+  const ReferenceLine ref_line = MakeCurvedReferenceLine();
+  std::vector<PlanningTarget> planning_targets(3);
+  for (size_t i = 0; i < planning_targets.size(); ++i) {
+    planning_targets[i].desired_vel = 4.0 + 3.0 * i;
+    planning_targets[i].ref_lane = ref_line;
+    planning_targets[i].is_best_behaviour = i == 1;
+  }
+  const std::vector<std::shared_ptr<Obstacle>> obstacles{MakeStandingObstacle(1, 35.0)};
+  const auto init_trajectory_point = MakeInitTrajectoryPoint(5.0, 8.0);
+
+  FrenetLatticePlanner serial_planner;
+  planning_msgs::Trajectory expected;
+  std::vector<planning_msgs::Trajectory> expected_valid_trajectories;
+  ASSERT_TRUE(serial_planner.Process(obstacles, init_trajectory_point, planning_targets, expected,
+                                     &expected_valid_trajectories));
+
+  // the result does not depend on which line finishes first
+  common::ThreadPool thread_pool(4);
+  FrenetLatticePlanner concurrent_planner(&thread_pool);
+  for (size_t run = 0; run < 3; ++run) {
+    planning_msgs::Trajectory pub_trajectory;
+    std::vector<planning_msgs::Trajectory> valid_trajectories;
+    EXPECT_TRUE(concurrent_planner.Process(obstacles, init_trajectory_point, planning_targets, pub_trajectory,
+                                           &valid_trajectories));
+    ExpectSameTrajectory(pub_trajectory, expected);
+    ASSERT_EQ(valid_trajectories.size(), expected_valid_trajectories.size());
+    for (size_t i = 0; i < valid_trajectories.size(); ++i) {
+      ExpectSameTrajectory(valid_trajectories[i], expected_valid_trajectories[i]);
+    }
+  }
+}
+
 typedef boost::array<double, 3> state_type;
 const double sigma = 10.0;
 const double R = 28.0;
@@ -16,200 +16,313 @@ PolynomialTrajectoryEvaluator::PolynomialTrajectoryEvaluator(const std::array<do
       ref_line_(ref_line) {
   double start_time = 0.0;
   double end_time = PlanningConfig::Instance().max_lookahead_time();
-  intervals_ = ptr_st_graph_->GetPathBlockingIntervals(start_time, end_time, PlanningConfig::Instance().delta_t());
+  if (ptr_st_graph_->blocking_intervals().IsOnGrid(start_time, end_time, PlanningConfig::Instance().delta_t())) {
+    blocking_intervals_ = ptr_st_graph_->blocking_intervals();
+  } else {
+    blocking_intervals_ = BlockingIntervalTable(ptr_st_graph_->GetObstaclesSTBoundary(), start_time, end_time,
+                                                PlanningConfig::Instance().delta_t());
+  }
   double stop_point = std::numeric_limits<double>::max();
   if (planning_target.has_stop_point) {
     stop_point = planning_target.stop_s;
   }
   auto begin = ros::Time::now();
+  std::vector<std::shared_ptr<common::Polynomial>> lon_trajectories;
+  for (const auto &lon_traj : lon_trajectory_vec) {
+    double lon_end_s = lon_traj->Evaluate(0, end_time);
+    if (init_s[0] < stop_point && lon_end_s +
+        PlanningConfig::Instance().lon_safety_buffer() > stop_point) {
+      continue;
+    }
+    lon_trajectories.push_back(lon_traj);
+  }
+  // every trajectory is sampled once here, the validity checks and the costs read the samples
+  sample_cache_ = TrajectorySampleCache(lon_trajectories, lat_trajectory_vec,
+                                        PlanningConfig::Instance().delta_t(), end_time,
+                                        0.1, PlanningConfig::Instance().max_lookahead_distance());
+
+  lat_candidates_.reserve(sample_cache_.NumLatTrajectories());
+  for (size_t i = 0; i < sample_cache_.NumLatTrajectories(); ++i) {
+    lat_candidates_.push_back(MakeLatCandidate(i));
+  }
+
+  std::vector<size_t> valid_lon_indices;
+  for (size_t i = 0; i < sample_cache_.NumLonTrajectories(); ++i) {
+    if (!IsValidLongitudinalTrajectory(i)) {
+      continue;
+    }
+    valid_lon_indices.push_back(i);
+  }
+
+  // the lon only terms are computed once per lon trajectory, a pair only pays for the coupled terms
+  lon_candidates_.reserve(valid_lon_indices.size());
   if (thread_pool != nullptr) {
-    std::vector<std::future<TrajectoryCostPair>> futures;
-    for (const auto &lon_traj : lon_trajectory_vec) {
-      double lon_end_s = lon_traj->Evaluate(0, end_time);
-      if (init_s[0] < stop_point && lon_end_s +
-          PlanningConfig::Instance().lon_safety_buffer() > stop_point) {
-        continue;
-      }
-      if (!IsValidLongitudinalTrajectory(*lon_traj)) {
-        continue;
-      }
-      for (const auto &lat_traj : lat_trajectory_vec) {
-        if (!IsValidLateralTrajectory(*lon_traj, *lat_traj)) {
-          continue;
-        }
-        auto lambda = [&lon_traj, &lat_traj, &planning_target, this]() -> TrajectoryCostPair {
-          double cost = Evaluate(planning_target, lon_traj, lat_traj);
-          return TrajectoryCostPair(TrajectoryPair(lon_traj, lat_traj), cost);
-        };
-        futures.push_back(thread_pool->PushTask(lambda));
-      }
+    std::vector<std::future<LonCandidate>> futures;
+    futures.reserve(valid_lon_indices.size());
+    for (const auto &index : valid_lon_indices) {
+      const auto &lon_traj = sample_cache_.LonTrajectory(index);
+      auto lambda = [&lon_traj, index, &planning_target, this]() -> LonCandidate {
+        return MakeLonCandidate(planning_target, lon_traj, index);
+      };
+      futures.push_back(thread_pool->PushTask(lambda));
     }
     for (auto &task : futures) {
-      cost_queue_.emplace(task.get());
+      lon_candidates_.push_back(task.get());
     }
   } else {
-    for (const auto &lon_traj : lon_trajectory_vec) {
-      double lon_end_s = lon_traj->Evaluate(0, end_time);
-      if (init_s[0] < stop_point && lon_end_s +
-          PlanningConfig::Instance().lon_safety_buffer() > stop_point) {
-        continue;
-      }
-      if (!IsValidLongitudinalTrajectory(*lon_traj)) {
-        continue;
-      }
-
-      for (const auto &lat_traj : lat_trajectory_vec) {
-        if (!IsValidLateralTrajectory(*lon_traj, *lat_traj)) {
-          continue;
-        }
-        double cost = Evaluate(planning_target, lon_traj, lat_traj);
-        cost_queue_.emplace(TrajectoryPair(lon_traj, lat_traj), cost);
-      }
+    for (const auto &index : valid_lon_indices) {
+      lon_candidates_.push_back(MakeLonCandidate(planning_target, sample_cache_.LonTrajectory(index), index));
     }
   }
 
+  // every lon evaluation horizon is at least min_evaluation_horizon, so the smallest lat offset cost
+  // beyond it is a lower bound of the lat part of any pair.
+  double min_evaluation_horizon = std::numeric_limits<double>::max();
+  for (const auto &lon_candidate : lon_candidates_) {
+    min_evaluation_horizon = std::min(min_evaluation_horizon, lon_candidate.evaluation_horizon);
+  }
+  for (auto &lat_candidate : lat_candidates_) {
+    lat_candidate.lower_bound_cost = LatOffsetLowerBound(lat_candidate, min_evaluation_horizon) *
+        PlanningConfig::Instance().lattice_weight_lat_offset();
+  }
+
+  std::stable_sort(lon_candidates_.begin(), lon_candidates_.end(),
+                   [](const LonCandidate &left, const LonCandidate &right) {
+                     return left.cost < right.cost;
+                   });
+  std::stable_sort(lat_candidates_.begin(), lat_candidates_.end(),
+                   [](const LatCandidate &left, const LatCandidate &right) {
+                     return left.lower_bound_cost < right.lower_bound_cost;
+                   });
+  if (!lon_candidates_.empty() && !lat_candidates_.empty()) {
+    frontier_.emplace(lon_candidates_[0].cost + lat_candidates_[0].lower_bound_cost, std::make_pair(0, 0));
+  }
+
   auto end = ros::Time::now();
   ROS_WARN("[PolynomialTrajectoryEvaluator], the time elapsed by PolynomialTrajectoryEvaluator is %lf s",
            (end - begin).toSec());
-  ROS_INFO("[PolynomialTrajectoryEvaluator], the numeber of trajectory pairs: %zu", cost_queue_.size());
+  ROS_INFO("[PolynomialTrajectoryEvaluator], the numeber of trajectory pairs: %zu", num_of_trajectory_pairs());
 }
 
-bool PolynomialTrajectoryEvaluator::IsValidLongitudinalTrajectory(const common::Polynomial &lon_traj) {
-
-  double t = 0.0;
-  while (t < lon_traj.ParamLength()) {
-    double v = lon_traj.Evaluate(1, t);
-    if (!ConstraintChecker::WithInRange(v, PlanningConfig::Instance().min_lon_velocity(),
-                                        PlanningConfig::Instance().max_lon_velocity())) {
-
-//      ROS_FATAL("[PolynomialTrajectoryEvaluator], the lon_traj is not valid, because **LON_VEL** exceeds the  vel range. vel: %lf", v);
-      return false;
-    }
-    double a = lon_traj.Evaluate(2, t);
-    if (!ConstraintChecker::WithInRange(a,
-                                        PlanningConfig::Instance().min_lon_acc(),
-                                        PlanningConfig::Instance().max_lon_acc())) {
-//      ROS_FATAL("[PolynomialTrajectoryEvaluator], the lon_traj is not valid, because **LON_ACC** exceeds the  acc range. a: %lf", a);
-      return false;
-    }
-    double j = lon_traj.Evaluate(3, t);
-    if (!ConstraintChecker::WithInRange(j,
-                                        PlanningConfig::Instance().min_lon_jerk(),
-                                        PlanningConfig::Instance().max_lon_jerk())) {
-//      ROS_FATAL("[PolynomialTrajectoryEvaluator], the lon_traj is not valid, because **LON_JERK** exceeds the  jerk range. jerk: %lf", j);
-      return false;
-    }
-    t += PlanningConfig::Instance().delta_t();
+bool PolynomialTrajectoryEvaluator::IsValidLongitudinalTrajectory(size_t cache_index) const {
+  // exact bounds over the whole param length, violations between the delta_t samples are caught too
+  const auto &lon_traj = sample_cache_.LonTrajectory(cache_index);
+  const double param_length = lon_traj->ParamLength();
+  double min_v = 0.0;
+  double max_v = 0.0;
+  lon_traj->DerivativeBounds(1, 0.0, param_length, &min_v, &max_v);
+  if (!ConstraintChecker::WithInRange(min_v, PlanningConfig::Instance().min_lon_velocity(),
+                                      PlanningConfig::Instance().max_lon_velocity()) ||
+      !ConstraintChecker::WithInRange(max_v, PlanningConfig::Instance().min_lon_velocity(),
+                                      PlanningConfig::Instance().max_lon_velocity())) {
+//    ROS_FATAL("[PolynomialTrajectoryEvaluator], the lon_traj is not valid, because **LON_VEL** exceeds the  vel range. vel: [%lf, %lf]", min_v, max_v);
+    return false;
+  }
+  double min_a = 0.0;
+  double max_a = 0.0;
+  lon_traj->DerivativeBounds(2, 0.0, param_length, &min_a, &max_a);
+  if (!ConstraintChecker::WithInRange(min_a, PlanningConfig::Instance().min_lon_acc(),
+                                      PlanningConfig::Instance().max_lon_acc()) ||
+      !ConstraintChecker::WithInRange(max_a, PlanningConfig::Instance().min_lon_acc(),
+                                      PlanningConfig::Instance().max_lon_acc())) {
+//    ROS_FATAL("[PolynomialTrajectoryEvaluator], the lon_traj is not valid, because **LON_ACC** exceeds the  acc range. a: [%lf, %lf]", min_a, max_a);
+    return false;
+  }
+  double min_j = 0.0;
+  double max_j = 0.0;
+  lon_traj->DerivativeBounds(3, 0.0, param_length, &min_j, &max_j);
+  if (!ConstraintChecker::WithInRange(min_j, PlanningConfig::Instance().min_lon_jerk(),
+                                      PlanningConfig::Instance().max_lon_jerk()) ||
+      !ConstraintChecker::WithInRange(max_j, PlanningConfig::Instance().min_lon_jerk(),
+                                      PlanningConfig::Instance().max_lon_jerk())) {
+//    ROS_FATAL("[PolynomialTrajectoryEvaluator], the lon_traj is not valid, because **LON_JERK** exceeds the  jerk range. jerk: [%lf, %lf]", min_j, max_j);
+    return false;
   }
   return true;
 }
 
-bool PolynomialTrajectoryEvaluator::IsValidLateralTrajectory(const common::Polynomial &lon_traj,
-                                                             const common::Polynomial &lat_traj) {
-  double t = 0.0;
-  while (t < lon_traj.ParamLength()) {
-    double s = lon_traj.Evaluate(0, t);
-    double l = lat_traj.Evaluate(0, s);
-//    double dsdt = lon_traj.Evaluate(1, t);
-//    double dsddt = lon_traj.Evaluate(2, t);
-//    double dlds = lat_traj.Evaluate(1, s);
-//    double dldds = lat_traj.Evaluate(2, s);
-//    double dldt = dlds * dsdt;
-//    double dlddt = dldds * dsdt * dsdt + dlds * dsddt;
-    if (!ConstraintChecker::WithInRange(l, -3.5/2, 3.5/2)) {
+bool PolynomialTrajectoryEvaluator::IsValidLateralTrajectory(const LonCandidate &lon_candidate,
+                                                             const LatCandidate &lat_candidate) const {
+  for (size_t i = 0; i < lon_candidate.num_param_samples; ++i) {
+    double l = sample_cache_.LatSample(0, lat_candidate.cache_index, lon_candidate.s_samples[i]);
+    if (!ConstraintChecker::WithInRange(l, -3.5 / 2, 3.5 / 2)) {
       return false;
     }
-    t += PlanningConfig::Instance().delta_t();
-//    if (!ConstraintChecker::WithInRange(dlddt,
-//                                        PlanningConfig::Instance().min_lat_acc(),
-//                                        PlanningConfig::Instance().max_lat_acc())) {
-//      return false;
-//    }
   }
   return true;
 }
 
-double PolynomialTrajectoryEvaluator::Evaluate(const PlanningTarget &planning_target,
-                                               const std::shared_ptr<common::Polynomial> &lon_traj,
-                                               const std::shared_ptr<common::Polynomial> &lat_traj) {
-  double lon_target_cost = PolynomialTrajectoryEvaluator::LonTargetCost(lon_traj, planning_target);
-  double lon_jerk_cost = PolynomialTrajectoryEvaluator::LonJerkCost(lon_traj);
-  double lon_collision_cost = this->LonCollisionCost(lon_traj);
-  double lat_offset_cost = PolynomialTrajectoryEvaluator::LatOffsetCost(lat_traj, lon_traj);
-  double lat_jerk_cost = this->LatJerkCost(lat_traj, lon_traj);
-  double centripental_cost = this->CentripetalAccelerationCost(lon_traj);
-#if DEBUG
-  //  std::cout << " lon_target_cost: " << lon_target_cost << ",lon_jerk_cost: " << lon_jerk_cost
-  //            << ", lon_collision_cost: " << lon_collision_cost
-  //            << ", lat_offset_cost: " << lat_offset_cost << ", lat_jerk_cost: " << lat_jerk_cost
-  //            << ", centripental_cost: " << centripental_cost << std::endl;
-#endif
-  return lon_collision_cost * PlanningConfig::Instance().lattice_weight_collision() +
+PolynomialTrajectoryEvaluator::LonCandidate PolynomialTrajectoryEvaluator::MakeLonCandidate(
+    const PlanningTarget &planning_target,
+    const std::shared_ptr<common::Polynomial> &lon_trajectory,
+    size_t cache_index) const {
+  LonCandidate lon_candidate;
+  lon_candidate.trajectory = lon_trajectory;
+  lon_candidate.cache_index = cache_index;
+  lon_candidate.s_samples = sample_cache_.LonSamples(0, cache_index);
+  lon_candidate.s_dot_samples = sample_cache_.LonSamples(1, cache_index);
+  lon_candidate.s_ddot_samples = sample_cache_.LonSamples(2, cache_index);
+  lon_candidate.jerk_samples = sample_cache_.LonSamples(3, cache_index);
+  const double max_lookahead_time = PlanningConfig::Instance().max_lookahead_time();
+  const double param_length = lon_trajectory->ParamLength();
+  for (const auto &t : sample_cache_.t_samples()) {
+    if (t < max_lookahead_time) {
+      ++lon_candidate.num_lookahead_samples;
+    }
+    if (t < param_length) {
+      ++lon_candidate.num_param_samples;
+    }
+  }
+  lon_candidate.evaluation_horizon = std::min(PlanningConfig::Instance().max_lookahead_distance(),
+                                              lon_trajectory->Evaluate(0, param_length));
+
+  double lon_target_cost = this->LonTargetCost(lon_candidate, planning_target);
+  double lon_jerk_cost = PolynomialTrajectoryEvaluator::LonJerkCost(lon_candidate);
+  double lon_collision_cost = this->LonCollisionCost(lon_candidate);
+  double centripental_cost = this->CentripetalAccelerationCost(lon_candidate);
+  lon_candidate.cost = lon_collision_cost * PlanningConfig::Instance().lattice_weight_collision() +
       lon_jerk_cost * PlanningConfig::Instance().lattice_weight_lon_jerk() +
       lon_target_cost * PlanningConfig::Instance().lattice_weight_lon_target() +
-      lat_jerk_cost * PlanningConfig::Instance().lattice_weight_lat_jerk() +
-      lat_offset_cost * PlanningConfig::Instance().lattice_weight_lat_offset() +
       centripental_cost * PlanningConfig::Instance().lattice_weight_centripetal_acc();
+  return lon_candidate;
 }
 
-size_t PolynomialTrajectoryEvaluator::num_of_trajectory_pairs() const {
-  return cost_queue_.size();
+PolynomialTrajectoryEvaluator::LatCandidate PolynomialTrajectoryEvaluator::MakeLatCandidate(
+    size_t cache_index) const {
+  const size_t num_s = sample_cache_.s_samples().size();
+  const double *l_samples = sample_cache_.LatSamples(0, cache_index);
+  LatCandidate lat_candidate;
+  lat_candidate.trajectory = sample_cache_.LatTrajectory(cache_index);
+  lat_candidate.cache_index = cache_index;
+  lat_candidate.offset_cost_sqr_sums.reserve(num_s + 1);
+  lat_candidate.offset_cost_abs_sums.reserve(num_s + 1);
+  double lat_offset_start = lat_candidate.trajectory->Evaluate(0, 0.0);
+  double cost_sqr_sum = 0.0;
+  double cost_abs_sum = 0.0;
+  lat_candidate.offset_cost_sqr_sums.push_back(cost_sqr_sum);
+  lat_candidate.offset_cost_abs_sums.push_back(cost_abs_sum);
+  for (size_t i = 0; i < num_s; ++i) {
+    double lat_offset = l_samples[i];
+    double cost = lat_offset / 3.0;
+    if (lat_offset * lat_offset_start < 0.0) {
+      cost_sqr_sum += cost * cost * PlanningConfig::Instance().lattice_weight_opposite_side_offset();
+      cost_abs_sum += std::fabs(cost) * PlanningConfig::Instance().lattice_weight_opposite_side_offset();
+    } else {
+      cost_sqr_sum += cost * cost * PlanningConfig::Instance().lattice_weight_same_side_offset();
+      cost_abs_sum += std::fabs(cost) * PlanningConfig::Instance().lattice_weight_same_side_offset();
+    }
+    lat_candidate.offset_cost_sqr_sums.push_back(cost_sqr_sum);
+    lat_candidate.offset_cost_abs_sums.push_back(cost_abs_sum);
+  }
+  return lat_candidate;
 }
-bool PolynomialTrajectoryEvaluator::has_more_trajectory_pairs() const {
+
+bool PolynomialTrajectoryEvaluator::EvaluatePair(const LonCandidate &lon_candidate,
+                                                 const LatCandidate &lat_candidate,
+                                                 TrajectoryCostPair *trajectory_pair) const {
+  if (!IsValidLateralTrajectory(lon_candidate, lat_candidate)) {
+    return false;
+  }
+  double lat_offset_cost = this->LatOffsetCost(lat_candidate, lon_candidate.evaluation_horizon);
+  double lat_jerk_cost = this->LatJerkCost(lat_candidate, lon_candidate);
+  double cost = lon_candidate.cost +
+      lat_jerk_cost * PlanningConfig::Instance().lattice_weight_lat_jerk() +
+      lat_offset_cost * PlanningConfig::Instance().lattice_weight_lat_offset();
+  *trajectory_pair = TrajectoryCostPair(TrajectoryPair(lon_candidate.trajectory, lat_candidate.trajectory), cost);
+  return true;
+}
+
+void PolynomialTrajectoryEvaluator::ExpandFrontier() {
+  // a scored pair is only released once no unscored pair can beat it
+  while (!frontier_.empty() &&
+      (cost_queue_.empty() || frontier_.top().first < cost_queue_.top().second)) {
+    const auto index = frontier_.top().second;
+    frontier_.pop();
+    const size_t lon_index = index.first;
+    const size_t lat_index = index.second;
+    if (lat_index + 1 < lat_candidates_.size()) {
+      frontier_.emplace(lon_candidates_[lon_index].cost + lat_candidates_[lat_index + 1].lower_bound_cost,
+                        std::make_pair(lon_index, lat_index + 1));
+    }
+    if (lat_index == 0 && lon_index + 1 < lon_candidates_.size()) {
+      frontier_.emplace(lon_candidates_[lon_index + 1].cost + lat_candidates_[0].lower_bound_cost,
+                        std::make_pair(lon_index + 1, 0));
+    }
+    ++num_of_inspected_pairs_;
+    TrajectoryCostPair trajectory_pair;
+    if (EvaluatePair(lon_candidates_[lon_index], lat_candidates_[lat_index], &trajectory_pair)) {
+      cost_queue_.push(std::move(trajectory_pair));
+    }
+  }
+}
+
+bool PolynomialTrajectoryEvaluator::has_more_trajectory_pairs() {
+  ExpandFrontier();
   return !cost_queue_.empty();
 }
 
-double PolynomialTrajectoryEvaluator::LatJerkCost(const std::shared_ptr<common::Polynomial> &lat_trajectory,
-                                                  const std::shared_ptr<common::Polynomial> &lon_trajectory) const {
+double PolynomialTrajectoryEvaluator::top_trajectory_pair_cost() {
+  ExpandFrontier();
+  return cost_queue_.top().second;
+}
+
+PolynomialTrajectoryEvaluator::TrajectoryPair PolynomialTrajectoryEvaluator::next_top_trajectory_pair() {
+  ROS_ASSERT(has_more_trajectory_pairs());
+  auto top = cost_queue_.top();
+  cost_queue_.pop();
+  return top.first;
+}
+
+size_t PolynomialTrajectoryEvaluator::num_of_trajectory_pairs() const {
+  return lon_candidates_.size() * lat_candidates_.size() - num_of_inspected_pairs_ + cost_queue_.size();
+}
+
+double PolynomialTrajectoryEvaluator::LatJerkCost(const LatCandidate &lat_candidate,
+                                                  const LonCandidate &lon_candidate) const {
 
   double max_cost = 0.0;
-  for (double t = 0.0; t < PlanningConfig::Instance().max_lookahead_time();
-       t += PlanningConfig::Instance().delta_t()) {
-    double s = lon_trajectory->Evaluate(0, t);
-    double s_dot = lon_trajectory->Evaluate(1, t);
-    double s_dotdot = lon_trajectory->Evaluate(2, t);
-
-    double relative_s = s - init_s_[0];
-    double l_prime = lat_trajectory->Evaluate(1, relative_s);
-    double l_primeprime = lat_trajectory->Evaluate(2, relative_s);
+  for (size_t i = 0; i < lon_candidate.num_lookahead_samples; ++i) {
+    double s_dot = lon_candidate.s_dot_samples[i];
+    double s_dotdot = lon_candidate.s_ddot_samples[i];
+
+    double relative_s = lon_candidate.s_samples[i] - init_s_[0];
+    double l_prime = sample_cache_.LatSample(1, lat_candidate.cache_index, relative_s);
+    double l_primeprime = sample_cache_.LatSample(2, lat_candidate.cache_index, relative_s);
     double cost = l_primeprime * s_dot * s_dot + l_prime * s_dotdot;
     max_cost = std::max(max_cost, std::fabs(cost));
   }
   return max_cost;
 }
 
-double PolynomialTrajectoryEvaluator::LatOffsetCost(const std::shared_ptr<common::Polynomial> &lat_trajectory,
-                                                    const std::shared_ptr<common::Polynomial> &lon_trajectory) {
-  const double param_length = lon_trajectory->ParamLength();
-  double evaluation_horizon = std::min(PlanningConfig::Instance().max_lookahead_distance(),
-                                       lon_trajectory->Evaluate(0, param_length));
-  std::vector<double> s_values;
-  for (double s = 0.0; s < evaluation_horizon; s += 0.1) {
-    s_values.emplace_back(s);
-  }
-  double lat_offset_start = lat_trajectory->Evaluate(0, 0.0);
-  double cost_sqr_sum = 0.0;
-  double cost_abs_sum = 0.0;
-  for (const auto &s : s_values) {
-    double lat_offset = lat_trajectory->Evaluate(0, s);
-    double cost = lat_offset / 3.0;
-    if (lat_offset * lat_offset_start < 0.0) {
-      cost_sqr_sum += cost * cost * PlanningConfig::Instance().lattice_weight_opposite_side_offset();
-      cost_abs_sum += std::fabs(cost) * PlanningConfig::Instance().lattice_weight_opposite_side_offset();
-    } else {
-      cost_sqr_sum += cost * cost * PlanningConfig::Instance().lattice_weight_same_side_offset();
-      cost_abs_sum += std::fabs(cost) * PlanningConfig::Instance().lattice_weight_same_side_offset();
-    }
+double PolynomialTrajectoryEvaluator::LatOffsetCost(const LatCandidate &lat_candidate,
+                                                    double evaluation_horizon) const {
+  // number of grid points with s < evaluation_horizon
+  const auto &s_samples = sample_cache_.s_samples();
+  size_t num_s = std::distance(s_samples.begin(),
+                               std::lower_bound(s_samples.begin(), s_samples.end(),
+                                                evaluation_horizon));
+  return lat_candidate.offset_cost_sqr_sums[num_s] / (lat_candidate.offset_cost_abs_sums[num_s] + 1e-5);
+}
+
+double PolynomialTrajectoryEvaluator::LatOffsetLowerBound(const LatCandidate &lat_candidate,
+                                                          double min_evaluation_horizon) const {
+  const auto &s_samples = sample_cache_.s_samples();
+  size_t num_s = std::distance(s_samples.begin(),
+                               std::lower_bound(s_samples.begin(), s_samples.end(),
+                                                min_evaluation_horizon));
+  double lower_bound = std::numeric_limits<double>::max();
+  for (size_t i = num_s; i < lat_candidate.offset_cost_sqr_sums.size(); ++i) {
+    lower_bound = std::min(lower_bound,
+                           lat_candidate.offset_cost_sqr_sums[i] / (lat_candidate.offset_cost_abs_sums[i] + 1e-5));
   }
-  return cost_sqr_sum / (cost_abs_sum + 1e-5);
+  return lower_bound;
 }
 
-double PolynomialTrajectoryEvaluator::LonJerkCost(const std::shared_ptr<common::Polynomial> &lon_trajectory) {
+double PolynomialTrajectoryEvaluator::LonJerkCost(const LonCandidate &lon_candidate) {
   double cost_sqr_sum = 0.0;
   double cost_abs_sum = 0.0;
-  for (double t = 0.0; t < PlanningConfig::Instance().max_lookahead_time();
-       t += PlanningConfig::Instance().delta_t()) {
-    double jerk = lon_trajectory->Evaluate(3, t);
+  for (size_t i = 0; i < lon_candidate.num_lookahead_samples; ++i) {
+    double jerk = lon_candidate.jerk_samples[i];
     double cost = jerk / PlanningConfig::Instance().max_lon_jerk();
     cost_sqr_sum += cost * cost;
     cost_abs_sum += std::fabs(cost);
@@ -217,18 +330,21 @@ double PolynomialTrajectoryEvaluator::LonJerkCost(const std::shared_ptr<common::
   return cost_sqr_sum / (cost_abs_sum + 1.0e-5);
 }
 
-double PolynomialTrajectoryEvaluator::LonTargetCost(const std::shared_ptr<common::Polynomial> &lon_trajectory,
-                                                    const PlanningTarget &planning_target) {
+double PolynomialTrajectoryEvaluator::LonTargetCost(const LonCandidate &lon_candidate,
+                                                    const PlanningTarget &planning_target) const {
 
+  const auto &lon_trajectory = lon_candidate.trajectory;
   double t_max = lon_trajectory->ParamLength();
-  double dist_s = lon_trajectory->Evaluate(0, t_max) - lon_trajectory->Evaluate(0, 0.0);
+  double dist_s = lon_trajectory->Evaluate(0, t_max) - lon_candidate.s_samples[0];
 //  std::cout << " ............dist_s: " << dist_s << std::endl;
   double speed_cost_sqr_sum = 0.0;
   double speed_cost_weight_sum = 0.0;
 //  ROS_INFO("LonTargetCost: the desired vel is %f", planning_target.desired_vel);
   double target_speed = /*planning_target.has_stop_point ? 0.0 :*/ planning_target.desired_vel;
-  for (double t = 0; t <= t_max; t += PlanningConfig::Instance().delta_t()) {
-    double cost = target_speed - lon_trajectory->Evaluate(1, t);
+  const auto &t_samples = sample_cache_.t_samples();
+  for (size_t i = 0; i < t_samples.size() && t_samples[i] <= t_max; ++i) {
+    double t = t_samples[i];
+    double cost = target_speed - lon_candidate.s_dot_samples[i];
 //    std::cout << " ============cost:=======      " << cost << ", lon_trajectory->Evaluate(1, t): "
 //              << lon_trajectory->Evaluate(1, t) << ",  target_speed: " << target_speed << std::endl;
 
@@ -243,26 +359,37 @@ double PolynomialTrajectoryEvaluator::LonTargetCost(const std::shared_ptr<common
       dist_travelled_cost * PlanningConfig::Instance().lattice_weight_dist_travelled();
 }
 
-double PolynomialTrajectoryEvaluator::LonCollisionCost(const std::shared_ptr<common::Polynomial> &lon_trajectory) const {
+double PolynomialTrajectoryEvaluator::LonCollisionCost(const LonCandidate &lon_candidate) const {
+  // the blocking intervals and the lon samples are on the same time grid
+  const size_t num_samples = std::min(blocking_intervals_.NumTicks(), sample_cache_.t_samples().size());
+  return LonCollisionCost(blocking_intervals_, lon_candidate.s_samples, num_samples,
+                          PlanningConfig::Instance().lon_safety_buffer(), 2.0);
+}
+
+double PolynomialTrajectoryEvaluator::LonCollisionCost(const BlockingIntervalTable &blocking_intervals,
+                                                       const double *s_samples,
+                                                       size_t num_samples,
+                                                       double lon_safety_buffer,
+                                                       double sigma) {
+  constexpr size_t kBlockSize = 64;
+  const size_t num_intervals = blocking_intervals.TickBegin(std::min(num_samples, blocking_intervals.NumTicks()));
+  const std::pair<double, double> *intervals = blocking_intervals.Intervals();
+  const uint32_t *interval_ticks = blocking_intervals.IntervalTicks();
+  double exponents[kBlockSize];
   double cost_sqr_sum = 0.0;
   double cost_abs_sum = 0.0;
-  for (size_t i = 0; i < intervals_.size(); ++i) {
-    const auto &pt_interval = intervals_[i];
-    if (pt_interval.empty()) {
-      continue;
+  for (size_t begin = 0; begin < num_intervals; begin += kBlockSize) {
+    const size_t end = std::min(begin + kBlockSize, num_intervals);
+    // branch free over the flat intervals, so it vectorizes, the distance is 0 within the buffered interval
+    for (size_t k = begin; k < end; ++k) {
+      const double traj_s = s_samples[interval_ticks[k]];
+      const double dist = std::max(0.0, std::max(intervals[k].first - lon_safety_buffer - traj_s,
+                                                 traj_s - intervals[k].second - lon_safety_buffer));
+      exponents[k - begin] = -dist * dist / (2.0 * sigma * sigma);
     }
-    double t = static_cast<double>(i) * PlanningConfig::Instance().delta_t();
-    double traj_s = lon_trajectory->Evaluate(0, t);
-    double sigma = 2.0;
-    for (const auto &m : pt_interval) {
-      double dist = 0.0;
-      if (traj_s < m.first - PlanningConfig::Instance().lon_safety_buffer()) {
-        dist = m.first - PlanningConfig::Instance().lon_safety_buffer() - traj_s;
-      } else if (traj_s > m.second + PlanningConfig::Instance().lon_safety_buffer()) {
-        dist = traj_s - m.second - PlanningConfig::Instance().lon_safety_buffer();
-      }
-      double cost = std::exp(-dist * dist / (2.0 * sigma * sigma));
-
+    // summed in the order of the ticks, as interval by interval
+    for (size_t k = begin; k < end; ++k) {
+      const double cost = std::exp(exponents[k - begin]);
       cost_sqr_sum += cost * cost;
       cost_abs_sum += cost;
     }
@@ -270,15 +397,12 @@ double PolynomialTrajectoryEvaluator::LonCollisionCost(const std::shared_ptr<com
   return cost_sqr_sum / (cost_abs_sum + 1e-5);
 }
 
-double PolynomialTrajectoryEvaluator::CentripetalAccelerationCost(
-    const std::shared_ptr<common::Polynomial> &lon_trajectory) const {
+double PolynomialTrajectoryEvaluator::CentripetalAccelerationCost(const LonCandidate &lon_candidate) const {
   double centripetal_acc_sum = 0.0;
   double centripetal_acc_sqr_sum = 0.0;
-  for (double t = 0.0; t < PlanningConfig::Instance().max_lookahead_time();
-       t += PlanningConfig::Instance().delta_t()) {
-    double s = lon_trajectory->Evaluate(0, t);
-    double v = lon_trajectory->Evaluate(1, t);
-    auto ref_point = ref_line_.GetReferencePoint(s);
+  for (size_t i = 0; i < lon_candidate.num_lookahead_samples; ++i) {
+    double v = lon_candidate.s_dot_samples[i];
+    auto ref_point = ref_line_.GetReferencePoint(lon_candidate.s_samples[i]);
     double centripetal_acc = v * v * ref_point.kappa();
     centripetal_acc_sum += std::fabs(centripetal_acc);
     centripetal_acc_sqr_sum += centripetal_acc * centripetal_acc;
@@ -288,4 +412,4 @@ double PolynomialTrajectoryEvaluator::CentripetalAccelerationCost(
       (centripetal_acc_sum + 1e-5);
 }
 
-}
\ No newline at end of file
+}
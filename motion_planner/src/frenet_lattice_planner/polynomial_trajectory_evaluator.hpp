@@ -8,6 +8,7 @@
 #include "curves/polynomial.hpp"
 #include "obstacle_manager/st_graph.hpp"
 #include "end_condition_sampler.hpp"
+#include "trajectory_sample_cache.hpp"
 #include "planning_config.hpp"
 #include "frenet_lattice_planner.hpp"
 
@@ -18,6 +19,9 @@ class PolynomialTrajectoryEvaluator {
   typedef std::pair<TrajectoryPair, double> TrajectoryCostPair;
   PolynomialTrajectoryEvaluator() = default;
   ~PolynomialTrajectoryEvaluator() = default;
+  // the candidates point into sample_cache_
+  PolynomialTrajectoryEvaluator(const PolynomialTrajectoryEvaluator &) = delete;
+  PolynomialTrajectoryEvaluator &operator=(const PolynomialTrajectoryEvaluator &) = delete;
 
   /**
    *
@@ -34,33 +38,112 @@ class PolynomialTrajectoryEvaluator {
                                 const ReferenceLine &ref_line,
                                 std::shared_ptr<STGraph> ptr_st_graph,
                                 common::ThreadPool *thread_pool);
-  bool has_more_trajectory_pairs() const;
+
+  /**
+   * @brief: pairs are scored lazily, these expand the best-first frontier until the
+   * lowest cost pair is known
+   */
+  bool has_more_trajectory_pairs();
+
+  /**
+   * @brief: upper bound of the pairs left, pairs not scored yet may still be rejected
+   * @return
+   */
   size_t num_of_trajectory_pairs() const;
-  double top_trajectory_pair_cost() const { return cost_queue_.top().second; }
-  TrajectoryPair next_top_trajectory_pair() {
-    ROS_ASSERT(has_more_trajectory_pairs());
-    auto top = cost_queue_.top();
-    cost_queue_.pop();
-    return top.first;
-  }
+  double top_trajectory_pair_cost();
+  TrajectoryPair next_top_trajectory_pair();
+
+  /**
+   * @brief: the samples of the lon and lat trajectories of this cycle, valid as long as the evaluator
+   * @return
+   */
+  const TrajectorySampleCache &sample_cache() const { return sample_cache_; }
  private:
-  double CentripetalAccelerationCost(
-      const  std::shared_ptr<common::Polynomial>& lon_trajectory) const;
-  double LatJerkCost(const std::shared_ptr<common::Polynomial> &lat_trajectory,
-                     const std::shared_ptr<common::Polynomial> &lon_trajectory) const;
-  static double LatOffsetCost(const std::shared_ptr<common::Polynomial> &lat_trajectory,
-                              const std::shared_ptr<common::Polynomial> &lon_trajectory);
-  static double LonJerkCost(const std::shared_ptr<common::Polynomial> &lon_trajectory);
-  static double LonTargetCost(const std::shared_ptr<common::Polynomial> &lon_trajectory,
-                              const PlanningTarget &planning_target);
-  double LonCollisionCost(const std::shared_ptr<common::Polynomial> &lon_trajectory) const;
+  /**
+   * @brief: per lon trajectory data, computed once and shared by every pair built on it
+   */
+  struct LonCandidate {
+    std::shared_ptr<common::Polynomial> trajectory;
+    // s, s_dot, s_ddot and jerk on sample_cache_.t_samples(), owned by sample_cache_
+    size_t cache_index = 0;
+    const double *s_samples = nullptr;
+    const double *s_dot_samples = nullptr;
+    const double *s_ddot_samples = nullptr;
+    const double *jerk_samples = nullptr;
+    // number of samples with t < max_lookahead_time
+    size_t num_lookahead_samples = 0;
+    // number of samples with t < ParamLength()
+    size_t num_param_samples = 0;
+    double evaluation_horizon = 0.0;
+    // weighted sum of the lon only cost terms
+    double cost = 0.0;
+  };
 
-  static bool IsValidLongitudinalTrajectory(const common::Polynomial &lon_traj);
 
-  static bool IsValidLateralTrajectory(const common::Polynomial &lon_traj, const common::Polynomial &lat_traj);
+  /**
+   * @brief: per lat trajectory data, prefix sums of the lat offset cost on the s grid
+   */
+  struct LatCandidate {
+    std::shared_ptr<common::Polynomial> trajectory;
+    size_t cache_index = 0;
+    std::vector<double> offset_cost_sqr_sums;
+    std::vector<double> offset_cost_abs_sums;
+    // weighted lat offset cost lower bound over all the lon evaluation horizons
+    double lower_bound_cost = 0.0;
+  };
+
+  LonCandidate MakeLonCandidate(const PlanningTarget &planning_target,
+                                const std::shared_ptr<common::Polynomial> &lon_trajectory,
+                                size_t cache_index) const;
 
-  double Evaluate(const PlanningTarget &planning_target, const std::shared_ptr<common::Polynomial> &lon_traj,
-                  const std::shared_ptr<common::Polynomial> &lat_traj);
+  LatCandidate MakeLatCandidate(size_t cache_index) const;
+
+  /**
+   * @brief: score a pair. the lon samples are exact, the lat offset check and the lat jerk cost use the lat
+   * samples linearly interpolated on the s grid of 0.1 m, so they are approximate. the combined trajectory of a
+   * returned pair is built from the exact lat trajectory and checked again.
+   * @param lon_candidate
+   * @param lat_candidate
+   * @param[out] trajectory_pair
+   * @return false if the pair is not valid
+   */
+  bool EvaluatePair(const LonCandidate &lon_candidate,
+                    const LatCandidate &lat_candidate,
+                    TrajectoryCostPair *trajectory_pair) const;
+
+  /**
+   * @brief: score frontier pairs until the top of cost_queue_ is no worse than any unscored pair
+   */
+  void ExpandFrontier();
+
+  double CentripetalAccelerationCost(const LonCandidate &lon_candidate) const;
+  double LatJerkCost(const LatCandidate &lat_candidate,
+                     const LonCandidate &lon_candidate) const;
+  double LatOffsetCost(const LatCandidate &lat_candidate, double evaluation_horizon) const;
+  double LatOffsetLowerBound(const LatCandidate &lat_candidate, double min_evaluation_horizon) const;
+  static double LonJerkCost(const LonCandidate &lon_candidate);
+  double LonTargetCost(const LonCandidate &lon_candidate,
+                       const PlanningTarget &planning_target) const;
+  double LonCollisionCost(const LonCandidate &lon_candidate) const;
+
+  /**
+   * @brief: the lon collision cost of a sampled lon profile against all blocking intervals at once
+   * @param blocking_intervals
+   * @param s_samples: s at the ticks of blocking_intervals
+   * @param num_samples: the ticks past num_samples are ignored
+   * @param lon_safety_buffer
+   * @param sigma
+   * @return
+   */
+  static double LonCollisionCost(const BlockingIntervalTable &blocking_intervals,
+                                 const double *s_samples,
+                                 size_t num_samples,
+                                 double lon_safety_buffer,
+                                 double sigma);
+
+  bool IsValidLongitudinalTrajectory(size_t cache_index) const;
+
+  bool IsValidLateralTrajectory(const LonCandidate &lon_candidate, const LatCandidate &lat_candidate) const;
 
   // comparator for priority queue
   struct Comparator : public std::binary_function<const TrajectoryCostPair &, const TrajectoryCostPair &, bool> {
@@ -69,13 +152,30 @@ class PolynomialTrajectoryEvaluator {
     }
   };
 
+  // lower bound cost and (lon index, lat index) of a pair not scored yet
+  typedef std::pair<double, std::pair<size_t, size_t>> FrontierNode;
+  struct FrontierComparator : public std::binary_function<const FrontierNode &, const FrontierNode &, bool> {
+    bool operator()(const FrontierNode &left, const FrontierNode &right) {
+      return left.first > right.first;
+    }
+  };
+
  private:
+  // scored pairs
   std::priority_queue<TrajectoryCostPair, std::vector<TrajectoryCostPair>, Comparator> cost_queue_;
+  std::priority_queue<FrontierNode, std::vector<FrontierNode>, FrontierComparator> frontier_;
+  size_t num_of_inspected_pairs_ = 0;
   std::array<double, 3> init_s_{0.0, 0.0, 0.0};
   std::shared_ptr<STGraph> ptr_st_graph_;
   ReferenceLine ref_line_;
 
-  std::vector<std::vector<std::pair<double, double>>> intervals_;
+  // on the lon sample grid
+  BlockingIntervalTable blocking_intervals_;
+  // lon trajectories on the delta_t grid, lat trajectories on the 0.1 m grid up to max_lookahead_distance
+  TrajectorySampleCache sample_cache_;
+  // sorted by their own lower bound cost
+  std::vector<LonCandidate> lon_candidates_;
+  std::vector<LatCandidate> lat_candidates_;
 
 };
 }
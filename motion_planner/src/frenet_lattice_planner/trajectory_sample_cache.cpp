@@ -0,0 +1,74 @@
+#include "frenet_lattice_planner/trajectory_sample_cache.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace planning {
+
+TrajectorySampleCache::TrajectorySampleCache(const std::vector<std::shared_ptr<common::Polynomial>> &lon_trajectories,
+                                             const std::vector<std::shared_ptr<common::Polynomial>> &lat_trajectories,
+                                             double delta_t, double max_t,
+                                             double delta_s, double max_s)
+    : lon_trajectories_(lon_trajectories), lat_trajectories_(lat_trajectories), delta_s_(delta_s) {
+  // the lattice trajectories extrapolate with constant acceleration past their param length,
+  // the batches do the same, so the samples equal trajectory->Evaluate(order, param)
+  double max_param_length = 0.0;
+  lon_batch_.Reserve(lon_trajectories_.size());
+  for (size_t i = 0; i < lon_trajectories_.size(); ++i) {
+    lon_batch_.AddPolynomial(*lon_trajectories_[i], true);
+    lon_indices_.emplace(lon_trajectories_[i].get(), i);
+    max_param_length = std::max(max_param_length, lon_trajectories_[i]->ParamLength());
+  }
+  // accumulated the same way as the time grid of the st graph and the combined trajectory
+  for (double t = 0.0; t <= max_t || t <= max_param_length; t += delta_t) {
+    t_samples_.push_back(t);
+  }
+  lon_batch_.Evaluate(t_samples_);
+
+  lat_batch_.Reserve(lat_trajectories_.size());
+  for (size_t i = 0; i < lat_trajectories_.size(); ++i) {
+    lat_batch_.AddPolynomial(*lat_trajectories_[i], true);
+    lat_indices_.emplace(lat_trajectories_[i].get(), i);
+  }
+  for (double s = 0.0; s < max_s; s += delta_s) {
+    s_samples_.push_back(s);
+  }
+  lat_batch_.Evaluate(s_samples_);
+}
+
+bool TrajectorySampleCache::FindLonIndex(const common::Polynomial *trajectory, size_t *index) const {
+  auto iter = lon_indices_.find(trajectory);
+  if (iter == lon_indices_.end()) {
+    return false;
+  }
+  *index = iter->second;
+  return true;
+}
+
+bool TrajectorySampleCache::FindLatIndex(const common::Polynomial *trajectory, size_t *index) const {
+  auto iter = lat_indices_.find(trajectory);
+  if (iter == lat_indices_.end()) {
+    return false;
+  }
+  *index = iter->second;
+  return true;
+}
+
+double TrajectorySampleCache::LatSample(size_t order, size_t index, double s) const {
+  const size_t num_s = s_samples_.size();
+  if (num_s < 2 || s < 0.0 || s > s_samples_.back()) {
+    return lat_trajectories_[index]->Evaluate(order, s);
+  }
+  // the grid is accumulated, so the guess may be one cell off
+  auto k = std::min(static_cast<size_t>(s / delta_s_), num_s - 2);
+  while (k > 0 && s < s_samples_[k]) {
+    --k;
+  }
+  while (k + 2 < num_s && s >= s_samples_[k + 1]) {
+    ++k;
+  }
+  const double *samples = lat_batch_.Samples(order, index);
+  const double ratio = (s - s_samples_[k]) / (s_samples_[k + 1] - s_samples_[k]);
+  return samples[k] + ratio * (samples[k + 1] - samples[k]);
+}
+
+}
@@ -0,0 +1,96 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_MOTION_PLANNER_SRC_FRENET_LATTICE_PLANNER_TRAJECTORY_SAMPLE_CACHE_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_MOTION_PLANNER_SRC_FRENET_LATTICE_PLANNER_TRAJECTORY_SAMPLE_CACHE_HPP_
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "curves/polynomial.hpp"
+#include "curves/polynomial_batch.hpp"
+
+namespace planning {
+
+/**
+ * @brief: per cycle samples of the lattice trajectories, the lon trajectories on the time grid
+ * 0, delta_t, 2 * delta_t ... and the lat trajectories on the s grid 0, delta_s, 2 * delta_s ...
+ * every trajectory is evaluated once and the samples are shared by the validity checks, the costs and
+ * the combination of the lon-lat pairs.
+ */
+class TrajectorySampleCache {
+ public:
+  TrajectorySampleCache() = default;
+  ~TrajectorySampleCache() = default;
+
+  /**
+   * @param lon_trajectories: lon trajectories, s(t)
+   * @param lat_trajectories: lat trajectories, l(s), s is relative to the init s
+   * @param delta_t: time resolution
+   * @param max_t: the time grid covers [0, max_t] and the param length of every lon trajectory
+   * @param delta_s: s resolution
+   * @param max_s: the s grid covers [0, max_s)
+   */
+  TrajectorySampleCache(const std::vector<std::shared_ptr<common::Polynomial>> &lon_trajectories,
+                        const std::vector<std::shared_ptr<common::Polynomial>> &lat_trajectories,
+                        double delta_t, double max_t,
+                        double delta_s, double max_s);
+
+  const std::vector<double> &t_samples() const { return t_samples_; }
+
+  const std::vector<double> &s_samples() const { return s_samples_; }
+
+  size_t NumLonTrajectories() const { return lon_trajectories_.size(); }
+
+  size_t NumLatTrajectories() const { return lat_trajectories_.size(); }
+
+  const std::shared_ptr<common::Polynomial> &LonTrajectory(size_t index) const { return lon_trajectories_[index]; }
+
+  const std::shared_ptr<common::Polynomial> &LatTrajectory(size_t index) const { return lat_trajectories_[index]; }
+
+  /**
+   * @brief: find the index of a cached lon trajectory
+   * @param trajectory
+   * @param[out] index
+   * @return false if the trajectory is not cached
+   */
+  bool FindLonIndex(const common::Polynomial *trajectory, size_t *index) const;
+
+  bool FindLatIndex(const common::Polynomial *trajectory, size_t *index) const;
+
+  /**
+   * @brief: s, s_dot, s_ddot or jerk of a lon trajectory on t_samples()
+   * @param order: 0 to 3
+   * @param index: the index of the lon trajectory
+   * @return
+   */
+  const double *LonSamples(size_t order, size_t index) const { return lon_batch_.Samples(order, index); }
+
+  /**
+   * @brief: l, l_prime, l_primeprime or l_primeprimeprime of a lat trajectory on s_samples()
+   * @param order: 0 to 3
+   * @param index: the index of the lat trajectory
+   * @return
+   */
+  const double *LatSamples(size_t order, size_t index) const { return lat_batch_.Samples(order, index); }
+
+  /**
+   * @brief: the order-th derivative of a lat trajectory at s, linearly interpolated on the s grid,
+   * s out of the grid is evaluated on the trajectory itself.
+   * @param order: 0 to 3
+   * @param index: the index of the lat trajectory
+   * @param s: relative s
+   * @return
+   */
+  double LatSample(size_t order, size_t index, double s) const;
+
+ private:
+  std::vector<std::shared_ptr<common::Polynomial>> lon_trajectories_;
+  std::vector<std::shared_ptr<common::Polynomial>> lat_trajectories_;
+  std::unordered_map<const common::Polynomial *, size_t> lon_indices_;
+  std::unordered_map<const common::Polynomial *, size_t> lat_indices_;
+  std::vector<double> t_samples_;
+  std::vector<double> s_samples_;
+  double delta_s_ = 0.1;
+  common::PolynomialBatch lon_batch_;
+  common::PolynomialBatch lat_batch_;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_MOTION_PLANNER_SRC_FRENET_LATTICE_PLANNER_TRAJECTORY_SAMPLE_CACHE_HPP_
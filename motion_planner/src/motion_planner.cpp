@@ -20,6 +20,21 @@ MotionPlanner::MotionPlanner(const ros::NodeHandle &nh) : nh_(nh), thread_pool_s
               PlanningConfig::Instance().planner_type().c_str());
     ROS_ASSERT(false);
   }
+  ObstaclePredictor::Mode prediction_mode;
+  if (!ObstaclePredictor::GetMode(PlanningConfig::Instance().prediction_mode(), &prediction_mode)) {
+    ROS_WARN("MotionPlanner, no such [%s] prediction mode, predict at constant velocity",
+             PlanningConfig::Instance().prediction_mode().c_str());
+    prediction_mode = ObstaclePredictor::Mode::kConstantVelocity;
+  }
+  obstacle_predictor_ = std::make_unique<ObstaclePredictor>(
+      prediction_mode,
+      PlanningConfig::Instance().max_lookahead_time(),
+      PlanningConfig::Instance().delta_t(),
+      thread_pool_.get(),
+      PlanningConfig::Instance().enable_prediction_cache(),
+      PlanningConfig::Instance().prediction_cache_position_tolerance(),
+      PlanningConfig::Instance().prediction_cache_heading_tolerance(),
+      PlanningConfig::Instance().prediction_cache_speed_tolerance());
   this->InitPublisher();
   this->InitSubscriber();
   this->InitServiceClient();
@@ -33,6 +48,13 @@ MotionPlanner::MotionPlanner(const ros::NodeHandle &nh) : nh_(nh), thread_pool_s
   reference_line_config.reference_smooth_max_curvature_ =
       PlanningConfig::Instance().reference_smoother_max_curvature();
   reference_line_config.reference_smooth_slack_weight_ = PlanningConfig::Instance().reference_smoother_slack_weight();
+  if (!ReferenceLineSmoother::GetBackend(PlanningConfig::Instance().reference_smoother_backend(),
+                                         &reference_line_config.reference_smoother_backend_)) {
+    ROS_WARN("MotionPlanner, no such [%s] reference smoother backend, smooth by ipopt",
+             PlanningConfig::Instance().reference_smoother_backend().c_str());
+    reference_line_config.reference_smoother_backend_ = ReferenceLineSmoother::Backend::kIpopt;
+  }
+  reference_line_config.reference_smooth_incremental_ = PlanningConfig::Instance().incremental_reference_smoothing();
   double lookahead_length = 300.0;
   double lookback_length = 30.0;
   reference_generator_ = std::make_unique<ReferenceGenerator>(reference_line_config, lookahead_length, lookback_length);
@@ -84,11 +106,12 @@ void MotionPlanner::RunOnce() {
   if (ego_vehicle_id_ == -1) {
     return;
   }
-  if (objects_map_.find(ego_vehicle_id_) == objects_map_.end()) {
+  const auto *ego_entry = obstacle_store_.Find(ego_vehicle_id_);
+  if (ego_entry == nullptr) {
     ROS_FATAL("[MotionPlanner::RunOnce], no ego vehicle");
     return;
   }
-  ego_object_ = objects_map_[ego_vehicle_id_];
+  ego_object_ = ego_entry->object;
   vehicle_state_->Update(ego_vehicle_status_, ego_vehicle_info_, ego_object_);
   VisualizeEgoVehicle();
   PlanningConfig::Instance().set_vehicle_params(vehicle_state_->vehicle_params());
@@ -114,11 +137,13 @@ void MotionPlanner::RunOnce() {
   std::vector<PlanningTarget> planning_targets = GetPlanningTargets(ref_lines, init_trajectory_point);
 
   std::vector<std::shared_ptr<Obstacle>> obstacles = GetKeyObstacle(
-      objects_map_,
+      obstacle_store_,
       traffic_light_status_list_,
       traffic_lights_info_list_,
       init_trajectory_point,
       ego_vehicle_id_, planning_targets);
+  obstacle_predictor_->Predict(obstacles, ref_lines, current_time_stamp.toSec());
+  obstacle_store_.ClearDirtyFlags();
 
   VisualizeObstacleTrajectory(obstacles);
 
@@ -203,11 +228,8 @@ void MotionPlanner::InitSubscriber() {
   this->objects_subscriber_ = nh_.subscribe<derived_object_msgs::ObjectArray>(
       common::topic::kObjectsName, 5,
       [this](const derived_object_msgs::ObjectArray::ConstPtr &object_array) {
-        this->objects_map_.clear();
-        for (const auto &object : object_array->objects) {
-          objects_map_.emplace(object.id, object);
-        }
-        ROS_INFO("the objects map_ size is: %lu", objects_map_.size());
+        obstacle_store_.Update(object_array->objects, object_array->header.stamp.toSec());
+        ROS_INFO("the obstacle store size is: %lu, dirty: %lu", obstacle_store_.Size(), obstacle_store_.NumDirty());
       });
 
   this->goal_pose_subscriber_ = nh_.subscribe<geometry_msgs::PoseStamped>(
@@ -253,7 +275,7 @@ void MotionPlanner::VisualizeObstacleTrajectory(const std::vector<std::shared_pt
     info_marker.pose.position.x = obstacle->x();
     info_marker.pose.position.y = obstacle->y();
     info_marker.pose.position.z = obstacle->IsVirtual() ? traffic_lights_info_list_[obstacle->Id()].trigger_volume.center.z
-                                                        : objects_map_[obstacle->Id()].pose.position.z;
+                                                        : obstacle_store_.Find(obstacle->Id())->object.pose.position.z;
     info_marker.header.stamp = ros::Time::now();
     info_marker.header.frame_id = "map";
     info_marker.lifetime = ros::Duration(1.0);
@@ -261,7 +283,7 @@ void MotionPlanner::VisualizeObstacleTrajectory(const std::vector<std::shared_pt
     info_marker.scale.x = obstacle->GetBoundingBox().length();
     info_marker.scale.y = obstacle->GetBoundingBox().width();
     info_marker.scale.z = obstacle->IsVirtual() ? traffic_lights_info_list_[obstacle->Id()].trigger_volume.size.z
-                                                : objects_map_[obstacle->Id()].shape.dimensions[2];
+                                                : obstacle_store_.Find(obstacle->Id())->object.shape.dimensions[2];
     obstacle_info_mark_array.markers.push_back(info_marker);
 
     trajectory_marker.type = visualization_msgs::Marker::LINE_STRIP;
@@ -277,7 +299,7 @@ void MotionPlanner::VisualizeObstacleTrajectory(const std::vector<std::shared_pt
     trajectory_marker.header.frame_id = "map";
     trajectory_marker.lifetime = ros::Duration(1.0);
     trajectory_marker.action = visualization_msgs::Marker::ADD;
-    auto tj = obstacle->trajectory();
+    auto tj = obstacle->GetPredictedTrajectory();
     for (const auto &tp : tj.trajectory_points) {
       geometry_msgs::Point p;
       p.x = tp.path_point.x;
@@ -585,109 +607,91 @@ MotionPlanner::~MotionPlanner() {
 }
 
 std::vector<std::shared_ptr<Obstacle>> MotionPlanner::GetKeyObstacle(
-    const std::unordered_map<int, derived_object_msgs::Object> &objects,
+    const ObstacleStore &obstacle_store,
     const std::unordered_map<int, carla_msgs::CarlaTrafficLightStatus> &traffic_light_status_list,
     const std::unordered_map<int, carla_msgs::CarlaTrafficLightInfo> &traffic_lights_info_list,
     const planning_msgs::TrajectoryPoint &trajectory_point,
     int ego_id, const std::vector<PlanningTarget> &targets) {
+  constexpr double kSpatialHashCellSize = 10.0;
   std::vector<std::shared_ptr<Obstacle>> obstacles;
-  auto ego_object = objects.at(ego_id);
+  const auto &objects = obstacle_store.entries();
+  const auto &ego_object = objects.at(ego_id).object;
   const double front_distance = PlanningConfig::Instance().max_lookahead_distance();
   const double back_distance = PlanningConfig::Instance().max_lookback_distance();
-  for (const auto& target : targets) {
-    if (!target.is_best_behaviour) {
+  const double lat_threshold = PlanningConfig::Instance().sample_lat_threshold();
+  // the filters that do not depend on the target run once, the survivors are hashed for the corridor queries
+  ObjectSpatialHash spatial_hash(kSpatialHashCellSize);
+  for (const auto &object : objects) {
+    if (object.first == ego_id) {
       continue;
     }
-    for (const auto &object : objects) {
-      if (object.first == ego_id) {
-        continue;
-      }
-      double height_diff = std::fabs(object.second.pose.position.z - ego_object.pose.position.z);
-      if (height_diff > 3) {
-        continue;
-      }
-      double distance = std::hypot(object.second.pose.position.x - trajectory_point.path_point.x,
-                                   object.second.pose.position.y - trajectory_point.path_point.y);
-
-      if (distance > front_distance) {
-        continue;
-      }
-      common::SLPoint sl_point;
-      if (!target.ref_lane.XYToSL(object.second.pose.position.x, object.second.pose.position.y, &sl_point)) {
-        continue;
-      }
-      if (sl_point.s > front_distance || sl_point.s < -back_distance ||
-          sl_point.l > PlanningConfig::Instance().sample_lat_threshold() ||
-          sl_point.l < -PlanningConfig::Instance().sample_lat_threshold()) {
-        continue;
-      }
-
-//    Eigen::Vector2d
-//        ego_heading{std::cos(trajectory_point.path_point.theta), std::sin(trajectory_point.path_point.theta)};
-//    Eigen::Vector2d agent_to_ego{object.second.pose.position.x - trajectory_point.path_point.x,
-//                                 object.second.pose.position.y - trajectory_point.path_point.y};
-//    const double cross_prod = agent_to_ego.x() * ego_heading.y() - agent_to_ego.y() * ego_heading.x();
-//    if (std::fabs(cross_prod) > PlanningConfig::Instance().sample_lat_threshold()) {
-//      continue;
-//    }
-//    const double dot_prod = agent_to_ego.x() * ego_heading.x() + agent_to_ego.y() * ego_heading.y();
-//    if (dot_prod > front_distance || dot_prod < -back_distance) {
-//      continue;
-//    }
-      auto obstacle = std::make_shared<Obstacle>(object.second);
-      obstacle->PredictTrajectory(PlanningConfig::Instance().max_lookahead_time(),
-                                  PlanningConfig::Instance().delta_t());
-      obstacles.emplace_back(obstacle);
+    const auto &position = object.second.object.pose.position;
+    double height_diff = std::fabs(position.z - ego_object.pose.position.z);
+    if (height_diff > 3) {
+      continue;
+    }
+    double distance = std::hypot(position.x - trajectory_point.path_point.x,
+                                 position.y - trajectory_point.path_point.y);
+    if (distance > front_distance) {
+      continue;
     }
+    spatial_hash.AddEntry(object.first, false, Eigen::Vector2d(position.x, position.y));
+  }
+  for (const auto &light_info : traffic_lights_info_list) {
+    auto id = light_info.first;
+    auto light_status = traffic_light_status_list.find(id);
+    if (light_status == traffic_light_status_list.end()) {
+      continue;
+    }
+    if (light_status->second.state == carla_msgs::CarlaTrafficLightStatus::GREEN
+        || light_status->second.state == carla_msgs::CarlaTrafficLightStatus::UNKNOWN) {
+      continue;
+    }
+    auto x = light_info.second.trigger_volume.center.x;
+    auto y = light_info.second.trigger_volume.center.y;
+    auto z = light_info.second.trigger_volume.center.z;
+    double height_diff = std::fabs(z - ego_object.pose.position.z);
+    if (height_diff > 3) {
+      continue;
+    }
+    double dist = std::hypot(trajectory_point.path_point.x - x,
+                             trajectory_point.path_point.y - y);
+    if (dist > front_distance) {
+      continue;
+    }
+    spatial_hash.AddEntry(id, true, Eigen::Vector2d(x, y));
+  }
+  spatial_hash.Build();
 
-    for (const auto &light_info : traffic_lights_info_list) {
-      auto id = light_info.first;
-      if (traffic_light_status_list.find(id) == traffic_light_status_list.end()) {
-        continue;
-      }
-      const auto light_status = traffic_light_status_list.at(id);
-      if (light_status.state == carla_msgs::CarlaTrafficLightStatus::GREEN
-          || light_status.state == carla_msgs::CarlaTrafficLightStatus::UNKNOWN) {
-        continue;
-      }
-      auto x = light_info.second.trigger_volume.center.x;
-      auto y = light_info.second.trigger_volume.center.y;
-      auto z = light_info.second.trigger_volume.center.z;
-      double height_diff = std::fabs(z - ego_object.pose.position.z);
-      if (height_diff > 3) {
-        continue;
-      }
-      double dist = std::hypot(trajectory_point.path_point.x - x,
-                               trajectory_point.path_point.y - y);
-      if (dist > front_distance) {
+  // an actor around several targets is one obstacle, shared by them
+  std::vector<bool> is_selected(spatial_hash.Size(), false);
+  std::vector<size_t> candidates;
+  for (const auto &target : targets) {
+    if (!target.is_best_behaviour) {
+      continue;
+    }
+    // the same s range as the projection filter below, past the ends of the line too
+    spatial_hash.QueryCorridor(target.ref_lane, -back_distance, front_distance, lat_threshold, &candidates);
+    for (const size_t index : candidates) {
+      if (is_selected[index]) {
         continue;
       }
-
+      const auto &entry = spatial_hash.GetEntry(index);
       common::SLPoint sl_point;
-      if (!target.ref_lane.XYToSL(x, y, &sl_point)) {
+      if (!target.ref_lane.XYToSL(entry.xy, &sl_point)) {
         continue;
       }
       if (sl_point.s > front_distance || sl_point.s < -back_distance ||
-          sl_point.l > PlanningConfig::Instance().sample_lat_threshold() ||
-          sl_point.l < -PlanningConfig::Instance().sample_lat_threshold()) {
+          sl_point.l > lat_threshold || sl_point.l < -lat_threshold) {
         continue;
       }
-//    Eigen::Vector2d
-//        ego_heading{std::cos(trajectory_point.path_point.theta), std::sin(trajectory_point.path_point.theta)};
-//    Eigen::Vector2d agent_to_ego{x - trajectory_point.path_point.x, y - trajectory_point.path_point.y};
-//    const double cross_prod = agent_to_ego.x() * ego_heading.y() - agent_to_ego.y() * ego_heading.x();
-//    if (std::fabs(cross_prod) > PlanningConfig::Instance().sample_lat_threshold()) {
-//      continue;
-//    }
-//    const double dot_prod = agent_to_ego.x() * ego_heading.x() + agent_to_ego.y() * ego_heading.y();
-//    if (dot_prod > front_distance || dot_prod < -back_distance) {
-//      continue;
-//    }
-
-      auto obstacle = std::make_shared<Obstacle>(light_info.second, light_status);
-      obstacle->PredictTrajectory(PlanningConfig::Instance().max_lookahead_time(),
-                                  PlanningConfig::Instance().delta_t());
-      obstacles.emplace_back(obstacle);
+      is_selected[index] = true;
+      if (entry.is_traffic_light) {
+        obstacles.emplace_back(std::make_shared<Obstacle>(traffic_lights_info_list.at(entry.id),
+                                                          traffic_light_status_list.at(entry.id)));
+      } else {
+        obstacles.push_back(objects.at(entry.id).obstacle);
+      }
     }
   }
 
@@ -17,6 +17,9 @@
 #include "vehicle_state/vehicle_state.hpp"
 #include "thread_pool/thread_pool.hpp"
 #include "obstacle_manager/obstacle.hpp"
+#include "obstacle_manager/obstacle_predictor.hpp"
+#include "obstacle_manager/object_spatial_hash.hpp"
+#include "obstacle_manager/obstacle_store.hpp"
 #include <planning_msgs/Trajectory.h>
 #include <planning_msgs/Behaviour.h>
 #include <reference_line/reference_line.hpp>
@@ -43,8 +46,13 @@ class MotionPlanner {
   std::vector<PlanningTarget> GetPlanningTargets(const std::vector<ReferenceLine> &ref_lines,
                                                  const planning_msgs::TrajectoryPoint &init_point);
 
+  /**
+   * @brief: the objects and traffic lights around the best behaviour targets, not predicted yet. the actors are
+   * hashed once per cycle and queried along every target. the objects are the obstacles of the store, shared
+   * across the targets and the cycles
+   */
   static std::vector<std::shared_ptr<Obstacle>> GetKeyObstacle(
-      const std::unordered_map<int, derived_object_msgs::Object> &objects,
+      const ObstacleStore &obstacle_store,
       const std::unordered_map<int, carla_msgs::CarlaTrafficLightStatus> &traffic_light_status_list,
       const std::unordered_map<int, carla_msgs::CarlaTrafficLightInfo> &traffic_lights_info_list,
       const planning_msgs::TrajectoryPoint &trajectory_point, int ego_id,
@@ -199,7 +207,7 @@ class MotionPlanner {
   carla_msgs::CarlaEgoVehicleStatus ego_vehicle_status_;
   std::unordered_map<int, carla_msgs::CarlaTrafficLightStatus> traffic_light_status_list_;
   std::unordered_map<int, carla_msgs::CarlaTrafficLightInfo> traffic_lights_info_list_;
-  std::unordered_map<int, derived_object_msgs::Object> objects_map_;
+  ObstacleStore obstacle_store_;
   derived_object_msgs::Object ego_object_;
   ros::NodeHandle nh_;
   planning_msgs::Trajectory history_trajectory_;
@@ -234,6 +242,7 @@ class MotionPlanner {
   size_t thread_pool_size_ = 6;
   std::unique_ptr<common::ThreadPool> thread_pool_;
   std::unique_ptr<ReferenceGenerator> reference_generator_;
+  std::unique_ptr<ObstaclePredictor> obstacle_predictor_;
 
   std::vector<PlanningTarget> planning_targets_;
 //  std::vector<std::shared_ptr<Obstacle>> obstacles_;
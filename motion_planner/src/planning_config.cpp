@@ -18,6 +18,8 @@ void PlanningConfig::UpdateParams(const ros::NodeHandle &nh) {
   nh.param<double>("/motion_planner/reference_smoother_distance_weight", reference_smoother_distance_weight_, 6);
   nh.param<double>("/motion_planner/reference_smoother_max_curvature", reference_smoother_max_curvature_, 6);
   nh.param<double>("/motion_planner//reference_smoother_slack_weight", reference_smoother_slack_weight_, 5.0);
+  nh.param<std::string>("/motion_planner/reference_smoother_backend", reference_smoother_backend_, "ipopt");
+  nh.param<bool>("/motion_planner/incremental_reference_smoothing", incremental_reference_smoothing_, false);
   nh.param<int>("/motion_planner/spline_order", spline_order_, 3);
   nh.param<double>("/motion_planner/max_lookahead_time", max_lookahead_time_, 8.0);
   nh.param<double>("/motion_planner/min_lookahead_time", min_lookahead_time_, 1.0);
@@ -63,6 +65,18 @@ void PlanningConfig::UpdateParams(const ros::NodeHandle &nh) {
   nh.param<double>("/motion_planner/cutting_in_lateral_approach_ratio", cutting_in_lateral_approach_ratio_, 0.95);
   nh.param<double>("/motion_planner/sample_lat_threshold", sample_lat_threshold_, 6.0);
   nh.param<double>("/motion_planner/sample_min_lon_threshold", sample_min_lon_threshold_, 20.0);
+  nh.param<bool>("/motion_planner/enable_parallel_validation", enable_parallel_validation_, false);
+  nh.param<int>("/motion_planner/validation_batch_size", validation_batch_size_, 8);
+  nh.param<bool>("/motion_planner/enable_occupancy_bitmap", enable_occupancy_bitmap_, false);
+  nh.param<double>("/motion_planner/occupancy_bitmap_resolution", occupancy_bitmap_resolution_, 0.5);
+  nh.param<bool>("/motion_planner/enable_st_graph_reuse", enable_st_graph_reuse_, false);
+  nh.param<double>("/motion_planner/st_graph_reuse_position_tolerance", st_graph_reuse_position_tolerance_, 0.1);
+  nh.param<double>("/motion_planner/st_graph_reuse_heading_tolerance", st_graph_reuse_heading_tolerance_, 0.02);
+  nh.param<std::string>("/motion_planner/prediction_mode", prediction_mode_, "constant_velocity");
+  nh.param<bool>("/motion_planner/enable_prediction_cache", enable_prediction_cache_, false);
+  nh.param<double>("/motion_planner/prediction_cache_position_tolerance", prediction_cache_position_tolerance_, 0.2);
+  nh.param<double>("/motion_planner/prediction_cache_heading_tolerance", prediction_cache_heading_tolerance_, 0.05);
+  nh.param<double>("/motion_planner/prediction_cache_speed_tolerance", prediction_cache_speed_tolerance_, 0.3);
 }
 const std::string &PlanningConfig::planner_type() const { return planner_type_; }
 double PlanningConfig::max_lookahead_distance() const { return max_lookahead_distance_; }
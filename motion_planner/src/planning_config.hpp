@@ -36,6 +36,8 @@ class PlanningConfig {
   double reference_smoother_heading_weight() const;
   double reference_smoother_max_curvature() const;
   double reference_smoother_slack_weight() const { return reference_smoother_slack_weight_; }
+  const std::string &reference_smoother_backend() const { return reference_smoother_backend_; }
+  bool incremental_reference_smoothing() const { return incremental_reference_smoothing_; }
   const std::string &behaviour_planner_type() const { return behaviour_planner_type_; }
   double desired_velocity() const { return desired_velocity_; }
   double sim_horizon() const { return sim_horizon_; }
@@ -48,6 +50,18 @@ class PlanningConfig {
   double cutting_in_lateral_approach_ratio() const { return cutting_in_lateral_approach_ratio_; }
   double sample_lat_threshold() const { return sample_lat_threshold_; }
   double sample_min_lon_threshold() const { return sample_min_lon_threshold_; }
+  bool enable_parallel_validation() const { return enable_parallel_validation_; }
+  int validation_batch_size() const { return validation_batch_size_; }
+  bool enable_occupancy_bitmap() const { return enable_occupancy_bitmap_; }
+  double occupancy_bitmap_resolution() const { return occupancy_bitmap_resolution_; }
+  bool enable_st_graph_reuse() const { return enable_st_graph_reuse_; }
+  double st_graph_reuse_position_tolerance() const { return st_graph_reuse_position_tolerance_; }
+  double st_graph_reuse_heading_tolerance() const { return st_graph_reuse_heading_tolerance_; }
+  const std::string &prediction_mode() const { return prediction_mode_; }
+  bool enable_prediction_cache() const { return enable_prediction_cache_; }
+  double prediction_cache_position_tolerance() const { return prediction_cache_position_tolerance_; }
+  double prediction_cache_heading_tolerance() const { return prediction_cache_heading_tolerance_; }
+  double prediction_cache_speed_tolerance() const { return prediction_cache_speed_tolerance_; }
 
   double max_lon_acc() const;
   double min_lon_acc() const;
@@ -95,6 +109,8 @@ class PlanningConfig {
   double reference_smoother_heading_weight_ = 50.0;
   double reference_smoother_max_curvature_ = 100;
   double reference_smoother_slack_weight_{5.0};
+  std::string reference_smoother_backend_ = "ipopt"; // ipopt or banded_sqp
+  bool incremental_reference_smoothing_ = false;
   int spline_order_ = 3;
   double max_lon_acc_ = 1.0;
   double min_lon_acc_{};
@@ -132,6 +148,18 @@ class PlanningConfig {
   double cutting_in_lateral_approach_ratio_{};
   double sample_lat_threshold_{};
   double sample_min_lon_threshold_{};
+  bool enable_parallel_validation_ = false; // check the top trajectory pairs concurrently
+  int validation_batch_size_ = 8; // number of trajectory pairs checked concurrently
+  bool enable_occupancy_bitmap_ = false; // reject the collision free ego boxes by an (x, y, t) bitmap
+  double occupancy_bitmap_resolution_ = 0.5;
+  bool enable_st_graph_reuse_ = false; // reuse the st boundaries of the last cycle for unchanged predictions
+  double st_graph_reuse_position_tolerance_ = 0.1;
+  double st_graph_reuse_heading_tolerance_ = 0.02;
+  std::string prediction_mode_ = "constant_velocity"; // constant_velocity, lane_following or constant_turn_rate
+  bool enable_prediction_cache_ = false; // reuse the obstacle predictions of the last cycles
+  double prediction_cache_position_tolerance_ = 0.2;
+  double prediction_cache_heading_tolerance_ = 0.05;
+  double prediction_cache_speed_tolerance_ = 0.3;
 
  private:
   PlanningConfig() = default;
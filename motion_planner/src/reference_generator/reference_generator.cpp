@@ -2,6 +2,10 @@
 #include "planning_config.hpp"
 namespace planning {
 /********************************** ReferenceGenerator ******************************/
+constexpr size_t ReferenceGenerator::kNumOfFixedPoints;
+constexpr size_t ReferenceGenerator::kNumOfResmoothedPoints;
+constexpr double ReferenceGenerator::kMaxNewPointsRatio;
+
 ReferenceGenerator::ReferenceGenerator(const ReferenceLineConfig &config,
                                        double lookahead_distance,
                                        double lookback_distance)
@@ -9,6 +13,7 @@ ReferenceGenerator::ReferenceGenerator(const ReferenceLineConfig &config,
       lookahead_distance_(lookahead_distance),
       lookback_distance_(lookback_distance),
       reference_line_history_(boost::circular_buffer<std::vector<ReferenceLine>>(3)) {
+  reference_smoother_ = std::make_unique<ReferenceLineSmoother>();
   is_initialized_ = true;
 }
 
@@ -33,18 +38,25 @@ bool ReferenceGenerator::CreateReferenceLines(bool smooth, std::vector<Reference
   }
 
   RouteInfo route_info;
+  uint64_t route_version = 0;
   {
     std::lock_guard<std::mutex> lock_guard(route_mutex_);
     route_info = route_info_;
+    route_version = route_version_;
   }
 
   auto main_ref_lane = ReferenceLine();
-  auto result = ReferenceGenerator::RetriveReferenceLine(
-      main_ref_lane, vehicle_state,
-      route_info.main_lane,
-      lookahead_distance_,
-      lookback_distance_,
-      smooth, smooth_config_);
+  bool result = false;
+  if (smooth && smooth_config_.reference_smooth_incremental_) {
+    result = RetriveIncrementalReferenceLine(main_ref_lane, vehicle_state, route_info.main_lane, route_version);
+  } else {
+    result = ReferenceGenerator::RetriveReferenceLine(
+        main_ref_lane, vehicle_state,
+        route_info.main_lane,
+        lookahead_distance_,
+        lookback_distance_,
+        smooth, smooth_config_, reference_smoother_.get());
+  }
   if (!result) {
     return false;
   }
@@ -127,7 +139,53 @@ bool ReferenceGenerator::RetriveReferenceLine(ReferenceLine &ref_lane,
                                               double lookahead_distance,
                                               double lookback_distance,
                                               bool smooth,
-                                              const ReferenceLineConfig &smooth_config) {
+                                              const ReferenceLineConfig &smooth_config,
+                                              ReferenceLineSmoother *smoother) {
+  size_t begin_index = 0;
+  size_t end_index = 0;
+  if (!GetWayPointsWindow(vehicle_state, lane, lookahead_distance, lookback_distance, &begin_index, &end_index)) {
+    return false;
+  }
+  std::vector<planning_msgs::WayPoint> sampled_way_points(lane.begin() + begin_index, lane.begin() + end_index);
+//  auto main_ref_lane = ReferenceLine(sampled_way_points);
+  ref_lane = ReferenceLine(sampled_way_points);
+  if (smooth) {
+    bool smoothed = false;
+    if (smoother != nullptr) {
+      smoother->SetSmoothParams(smooth_config.reference_smooth_deviation_weight_,
+                                smooth_config.reference_smooth_length_weight_,
+                                smooth_config.reference_smooth_heading_weight_,
+                                smooth_config.reference_smooth_slack_weight_,
+                                smooth_config.reference_smooth_max_curvature_);
+      smoother->SetBackend(smooth_config.reference_smoother_backend_);
+      std::vector<ReferencePoint> smoothed_points;
+      smoothed = smoother->SmoothReferenceLine(ref_lane.reference_points(), &smoothed_points)
+          && ref_lane.SetSmoothedPoints(smoothed_points);
+    } else {
+      smoothed = ref_lane.Smooth(smooth_config.reference_smooth_deviation_weight_,
+                                 smooth_config.reference_smooth_heading_weight_,
+                                 smooth_config.reference_smooth_length_weight_,
+                                 smooth_config.reference_smooth_slack_weight_,
+                                 smooth_config.reference_smooth_max_curvature_,
+                                 smooth_config.reference_smoother_backend_);
+    }
+    if (!smoothed) {
+      ROS_WARN("Failed to Smooth Reference Line");
+    }
+  }
+
+  return true;
+}
+
+bool ReferenceGenerator::GetWayPointsWindow(const vehicle_state::KinoDynamicState &vehicle_state,
+                                            const std::vector<planning_msgs::WayPoint> &lane,
+                                            double lookahead_distance,
+                                            double lookback_distance,
+                                            size_t *begin_index,
+                                            size_t *end_index) {
+  if (lane.empty()) {
+    return false;
+  }
   auto dist_sqr = [](const planning_msgs::WayPoint &way_point, Eigen::Vector2d &xy) -> double {
     return (way_point.pose.position.x - xy.x()) * (way_point.pose.position.x - xy.x())
         + (way_point.pose.position.y - xy.y()) * (way_point.pose.position.y - xy.y());
@@ -143,39 +201,95 @@ bool ReferenceGenerator::RetriveReferenceLine(ReferenceLine &ref_lane,
       index_min = i;
     }
   }
-  std::vector<planning_msgs::WayPoint> sampled_way_points;
   double s = 0;
-  size_t index = index_min > 0 ? index_min - 1 : index_min;;
+  *begin_index = index_min;
+  size_t index = index_min > 0 ? index_min - 1 : index_min;
   while (index > 0 && s < lookback_distance - std::numeric_limits<double>::epsilon()) {
-    sampled_way_points.push_back(lane[index]);
+    *begin_index = index;
     Eigen::Vector2d xy_last{lane[index].pose.position.x, lane[index].pose.position.y};
     s += std::sqrt(dist_sqr(lane[--index], xy_last));
   }
-  if (!sampled_way_points.empty()) {
-    std::reverse(sampled_way_points.begin(), sampled_way_points.end());
-  }
   index = index_min;
   s = 0;
   while (index < lane.size() && s < lookahead_distance - std::numeric_limits<double>::epsilon()) {
-    sampled_way_points.push_back(lane[index]);
     Eigen::Vector2d xy_last{lane[index].pose.position.x, lane[index].pose.position.y};
-    s += std::sqrt(dist_sqr(lane[++index], xy_last));
+    if (++index < lane.size()) {
+      s += std::sqrt(dist_sqr(lane[index], xy_last));
+    }
   }
-  if (sampled_way_points.size() < 3) {
+  *end_index = index;
+  return *end_index - *begin_index >= 3;
+}
+
+bool ReferenceGenerator::RetriveIncrementalReferenceLine(ReferenceLine &ref_lane,
+                                                         const vehicle_state::KinoDynamicState &vehicle_state,
+                                                         const std::vector<planning_msgs::WayPoint> &lane,
+                                                         uint64_t route_version) {
+  size_t begin_index = 0;
+  size_t end_index = 0;
+  if (!GetWayPointsWindow(vehicle_state, lane, lookahead_distance_, lookback_distance_, &begin_index, &end_index)) {
     return false;
   }
-//  auto main_ref_lane = ReferenceLine(sampled_way_points);
-  ref_lane = ReferenceLine(sampled_way_points);
-  if (smooth) {
-    if (!ref_lane.Smooth(smooth_config.reference_smooth_deviation_weight_,
-                         smooth_config.reference_smooth_heading_weight_,
-                         smooth_config.reference_smooth_length_weight_,
-                         smooth_config.reference_smooth_slack_weight_,
-                         smooth_config.reference_smooth_max_curvature_)) {
-      ROS_WARN("Failed to Smooth Reference Line");
-    }
+  ref_lane = ReferenceLine(std::vector<planning_msgs::WayPoint>(lane.begin() + begin_index,
+                                                                lane.begin() + end_index));
+  reference_smoother_->SetSmoothParams(smooth_config_.reference_smooth_deviation_weight_,
+                                       smooth_config_.reference_smooth_length_weight_,
+                                       smooth_config_.reference_smooth_heading_weight_,
+                                       smooth_config_.reference_smooth_slack_weight_,
+                                       smooth_config_.reference_smooth_max_curvature_);
+  reference_smoother_->SetBackend(smooth_config_.reference_smoother_backend_);
+  std::vector<ReferencePoint> smoothed_points;
+  if (!SmoothIncrementally(ref_lane, begin_index, end_index, route_version, &smoothed_points)
+      && !reference_smoother_->SmoothReferenceLine(ref_lane.reference_points(), &smoothed_points)) {
+    ROS_WARN("Failed to Smooth Reference Line");
+    smoothed_window_.points.clear();
+    return true;
+  }
+  if (!ref_lane.SetSmoothedPoints(smoothed_points)) {
+    ROS_WARN("Failed to Smooth Reference Line");
+    smoothed_window_.points.clear();
+    return true;
   }
+  smoothed_window_.route_version = route_version;
+  smoothed_window_.begin_index = begin_index;
+  smoothed_window_.end_index = end_index;
+  smoothed_window_.points = std::move(smoothed_points);
+  return true;
+}
 
+bool ReferenceGenerator::SmoothIncrementally(const ReferenceLine &ref_lane,
+                                             size_t begin_index,
+                                             size_t end_index,
+                                             uint64_t route_version,
+                                             std::vector<ReferencePoint> *smoothed_points) {
+  const auto &window = smoothed_window_;
+  if (window.points.empty() || window.route_version != route_version || begin_index < window.begin_index
+      || begin_index >= window.end_index || end_index < window.end_index) {
+    return false;
+  }
+  // a large jump of the window is smoothed fully
+  const size_t num_of_kept_points = window.end_index - begin_index;
+  const size_t num_of_new_points = end_index - window.end_index;
+  if (num_of_kept_points < kNumOfFixedPoints + kNumOfResmoothedPoints
+      || static_cast<double>(num_of_new_points) > kMaxNewPointsRatio * static_cast<double>(end_index - begin_index)) {
+    return false;
+  }
+  smoothed_points->assign(window.points.begin() + (begin_index - window.begin_index), window.points.end());
+  if (num_of_new_points == 0) {
+    return true;
+  }
+  // the end of the last window was open, it is smoothed again with the new points after the fixed ones
+  const size_t first_free_index = num_of_kept_points - kNumOfResmoothedPoints;
+  const auto &raw_points = ref_lane.reference_points();
+  std::vector<ReferencePoint> points(smoothed_points->begin() + (first_free_index - kNumOfFixedPoints),
+                                     smoothed_points->begin() + first_free_index);
+  points.insert(points.end(), raw_points.begin() + first_free_index, raw_points.end());
+  std::vector<ReferencePoint> smoothed_tail;
+  if (!reference_smoother_->SmoothReferenceLine(points, kNumOfFixedPoints, &smoothed_tail)) {
+    return false;
+  }
+  smoothed_points->resize(first_free_index);
+  smoothed_points->insert(smoothed_points->end(), smoothed_tail.begin() + kNumOfFixedPoints, smoothed_tail.end());
   return true;
 }
 
@@ -226,6 +340,7 @@ bool ReferenceGenerator::UpdateRouteResponse(const planning_srvs::RoutePlanServi
   std::lock_guard<std::mutex> lock_guard(route_mutex_);
   auto raw_ref_lane = route_response.route;
   route_info_.main_lane = raw_ref_lane.way_points;
+  ++route_version_;
 
   has_route_ = true;
   return true;
@@ -2,6 +2,7 @@
 #define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_MOTION_PLANNER_SRC_REFERENCE_GENERATOR_REFERENCE_GENERATOR_HPP_
 #include "reference_line/reference_line.hpp"
 #include "vehicle_state/vehicle_state.hpp"
+#include <cstdint>
 #include <mutex>
 #include <boost/circular_buffer.hpp>
 #include <future>
@@ -14,12 +15,17 @@ struct ReferenceLineConfig {
         reference_smooth_deviation_weight_(0.0),
         reference_smooth_heading_weight_(0.0),
         reference_smooth_length_weight_(0.0),
-        reference_smooth_slack_weight_(0.0) {}
+        reference_smooth_slack_weight_(0.0),
+        reference_smoother_backend_(ReferenceLineSmoother::Backend::kIpopt),
+        reference_smooth_incremental_(false) {}
   double reference_smooth_max_curvature_{0.0};
   double reference_smooth_deviation_weight_{0.0};
   double reference_smooth_heading_weight_{0.0};
   double reference_smooth_length_weight_{0.0};
   double reference_smooth_slack_weight_{0.0};
+  ReferenceLineSmoother::Backend reference_smoother_backend_{ReferenceLineSmoother::Backend::kIpopt};
+  // smooth only the new points of the main reference line, the points smoothed by the last one kept
+  bool reference_smooth_incremental_{false};
 
 };
 
@@ -91,6 +97,8 @@ class ReferenceGenerator {
    * @param heading_weight
    * @param length_weight
    * @param ref_lane
+   * @param smoother: a smoother reused across the calls of one thread, it's not kept by ref_lane. the reference
+   * line's own if nullptr
    * @return
    */
   static bool RetriveReferenceLine(ReferenceLine &ref_lane,
@@ -99,9 +107,67 @@ class ReferenceGenerator {
                                    double lookahead_distance,
                                    double lookback_distance,
                                    bool smooth = false,
-                                   const ReferenceLineConfig &smooth_config = ReferenceLineConfig());
+                                   const ReferenceLineConfig &smooth_config = ReferenceLineConfig(),
+                                   ReferenceLineSmoother *smoother = nullptr);
+
+  /**
+   * @brief: the way points of a lane within the lookback and the lookahead distances of the vehicle
+   * @param vehicle_state
+   * @param lane
+   * @param lookahead_distance
+   * @param lookback_distance
+   * @param begin_index: the first way point
+   * @param end_index: the way point after the last one
+   * @return: false if there are less than 3 way points
+   */
+  static bool GetWayPointsWindow(const vehicle_state::KinoDynamicState &vehicle_state,
+                                 const std::vector<planning_msgs::WayPoint> &lane,
+                                 double lookahead_distance,
+                                 double lookback_distance,
+                                 size_t *begin_index,
+                                 size_t *end_index);
 
  private:
+  /**
+   * @brief: the smoothed points of the last main reference line, by the indices of their way points on the route
+   */
+  struct SmoothedWindow {
+    uint64_t route_version = 0;
+    size_t begin_index = 0;
+    size_t end_index = 0;
+    std::vector<ReferencePoint> points;
+  };
+
+  /**
+   * @brief: retrive the main reference line and smooth it incrementally, it is smoothed fully on a route change, a
+   * large jump or a failure
+   * @param ref_lane
+   * @param vehicle_state
+   * @param lane
+   * @param route_version
+   * @return
+   */
+  bool RetriveIncrementalReferenceLine(ReferenceLine &ref_lane,
+                                       const vehicle_state::KinoDynamicState &vehicle_state,
+                                       const std::vector<planning_msgs::WayPoint> &lane,
+                                       uint64_t route_version);
+
+  /**
+   * @brief: the smoothed points of the way points [begin_index, end_index) from the last smoothed window: its points
+   * behind the window are dropped, its last points and the new ones are smoothed with the points before them fixed
+   * @param ref_lane: the reference line of the way points
+   * @param begin_index
+   * @param end_index
+   * @param route_version
+   * @param smoothed_points
+   * @return: false if the window can not be smoothed incrementally
+   */
+  bool SmoothIncrementally(const ReferenceLine &ref_lane,
+                           size_t begin_index,
+                           size_t end_index,
+                           uint64_t route_version,
+                           std::vector<ReferencePoint> *smoothed_points);
+
   /**
    * @brief: has overlap with ref lane along s direction?
    * @param ref_lane
@@ -126,10 +192,15 @@ class ReferenceGenerator {
   bool is_initialized_ = false;
   std::atomic<bool> is_stop_{false};
   ReferenceLineConfig smooth_config_;
+  // reused by the smoothing of every cycle, so its recorded problems are kept. it's not thread safe: only used by
+  // the generate thread and never attached to the published reference lines
+  std::unique_ptr<ReferenceLineSmoother> reference_smoother_;
   double lookahead_distance_{};
   double lookback_distance_{};
   std::mutex route_mutex_;
   RouteInfo route_info_;
+  // increased by every route response
+  uint64_t route_version_ = 0;
   bool has_route_ = false;
   bool has_vehicle_state_ = false;
   std::mutex vehicle_mutex_;
@@ -138,6 +209,14 @@ class ReferenceGenerator {
   std::vector<ReferenceLine> ref_lines_;
   boost::circular_buffer<std::vector<ReferenceLine>> reference_line_history_;
   std::future<void> task_future_;
+  // only used by the generate thread
+  SmoothedWindow smoothed_window_;
+  // the smoothed points held fixed before the points smoothed incrementally
+  static constexpr size_t kNumOfFixedPoints = 2;
+  // the last smoothed points smoothed again with the new points, they were at the open end of the last window
+  static constexpr size_t kNumOfResmoothedPoints = 10;
+  // a window with more new points than this ratio is smoothed fully
+  static constexpr double kMaxNewPointsRatio = 0.5;
 
 };
 
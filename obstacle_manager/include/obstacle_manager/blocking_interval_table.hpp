@@ -0,0 +1,72 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_BLOCKING_INTERVAL_TABLE_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_BLOCKING_INTERVAL_TABLE_HPP_
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "math/frenet_frame.hpp"
+
+namespace planning {
+
+/**
+ * @brief: the path blocking intervals of st boundaries on a time grid, in one flat array. the intervals of
+ * tick k are Intervals()[TickBegin(k), TickBegin(k + 1)), in the order of the st boundaries, the same as
+ * STGraph::GetPathBlockingIntervals(TickTime(k)).
+ */
+class BlockingIntervalTable {
+ public:
+  BlockingIntervalTable() = default;
+  ~BlockingIntervalTable() = default;
+
+  /**
+   * @param st_boundaries
+   * @param start_time
+   * @param end_time: the last tick is the last start_time + k * resolution <= end_time
+   * @param resolution
+   */
+  BlockingIntervalTable(const std::vector<common::STBoundary> &st_boundaries,
+                        double start_time, double end_time, double resolution);
+
+  size_t NumTicks() const { return tick_times_.size(); }
+
+  double TickTime(size_t tick) const { return tick_times_[tick]; }
+
+  size_t NumIntervals() const { return intervals_.size(); }
+
+  /**
+   * @param tick: <= NumTicks()
+   * @return: the index of the first interval of the tick
+   */
+  size_t TickBegin(size_t tick) const { return tick_offsets_[tick]; }
+
+  /**
+   * @brief: [s_lower, s_upper] of every interval
+   */
+  const std::pair<double, double> *Intervals() const { return intervals_.data(); }
+
+  /**
+   * @brief: the tick of every interval
+   */
+  const uint32_t *IntervalTicks() const { return interval_ticks_.data(); }
+
+  /**
+   * @brief: check the table has the ticks of GetPathBlockingIntervals(start_time, end_time, resolution)
+   */
+  bool IsOnGrid(double start_time, double end_time, double resolution) const;
+
+  /**
+   * @brief: the intervals of every tick, as returned by STGraph::GetPathBlockingIntervals
+   */
+  std::vector<std::vector<std::pair<double, double>>> GetPathBlockingIntervals() const;
+
+ private:
+  double start_time_ = 0.0;
+  double end_time_ = 0.0;
+  double resolution_ = 0.0;
+  std::vector<double> tick_times_;
+  std::vector<size_t> tick_offsets_{0};
+  std::vector<std::pair<double, double>> intervals_;
+  std::vector<uint32_t> interval_ticks_;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_BLOCKING_INTERVAL_TABLE_HPP_
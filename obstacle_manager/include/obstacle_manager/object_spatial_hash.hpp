@@ -0,0 +1,78 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_OBJECT_SPATIAL_HASH_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_OBJECT_SPATIAL_HASH_HPP_
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <Eigen/Core>
+#include "reference_line/reference_line.hpp"
+
+namespace planning {
+
+/**
+ * @brief: the objects and traffic light trigger volumes of a planning cycle, hashed by their xy on a uniform
+ * grid, so the ones around a reference line are found without projecting every object on it.
+ */
+class ObjectSpatialHash {
+ public:
+  struct Entry {
+    int id = 0;
+    bool is_traffic_light = false;
+    Eigen::Vector2d xy{0.0, 0.0};
+  };
+
+  ObjectSpatialHash() = default;
+  ~ObjectSpatialHash() = default;
+
+  /**
+   * @param cell_size: the side of a grid cell, in meters
+   */
+  explicit ObjectSpatialHash(double cell_size);
+
+  /**
+   * @brief: add an entry, call Build after the last one
+   * @param id
+   * @param is_traffic_light
+   * @param xy
+   * @return: the index of the entry
+   */
+  size_t AddEntry(int id, bool is_traffic_light, const Eigen::Vector2d &xy);
+
+  /**
+   * @brief: hash the entries added so far
+   */
+  void Build();
+
+  size_t Size() const { return entries_.size(); }
+
+  const Entry &GetEntry(size_t index) const { return entries_[index]; }
+
+  /**
+   * @brief: the entries within radius of ref_line between s_start and s_end. it is a superset of the entries with
+   * their projection on ref_line in [s_start, s_end] and |l| <= radius, the caller projects the candidates.
+   * s before 0 or past the length of ref_line is on the line extended along the heading of its end.
+   * thread safe after Build
+   * @param ref_line
+   * @param s_start
+   * @param s_end
+   * @param radius
+   * @param[out] entry_indices: the candidates, in the order they were added
+   */
+  void QueryCorridor(const ReferenceLine &ref_line, double s_start, double s_end, double radius,
+                     std::vector<size_t> *entry_indices) const;
+
+ private:
+  int64_t GetCellKey(double x, double y) const;
+
+  static int64_t GetCellKey(int64_t cell_x, int64_t cell_y);
+
+ private:
+  double cell_size_ = 10.0;
+  std::vector<Entry> entries_;
+  // the entry indices sorted by cell, the range of every cell
+  std::vector<size_t> cell_entries_;
+  std::unordered_map<int64_t, std::pair<size_t, size_t>> cells_;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_OBJECT_SPATIAL_HASH_HPP_
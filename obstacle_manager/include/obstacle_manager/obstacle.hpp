@@ -1,6 +1,7 @@
 
 #ifndef CATKIN_WS_SRC_LOCAL_PLANNER_INCLUDE_OBSTACLE_FILTER_OBSTACLE_HPP_
 #define CATKIN_WS_SRC_LOCAL_PLANNER_INCLUDE_OBSTACLE_FILTER_OBSTACLE_HPP_
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <geometry_msgs/Point.h>
@@ -10,6 +11,7 @@
 #include <carla_msgs/CarlaTrafficLightStatus.h>
 #include <carla_msgs/CarlaTrafficLightInfo.h>
 #include "polygon/box2d.hpp"
+#include "obstacle_manager/pose_track.hpp"
 
 namespace planning {
 class Obstacle {
@@ -24,7 +26,27 @@ class Obstacle {
   void PredictTrajectory(double predict_horizon, double predict_step);
 
   void SetTrajectory(const planning_msgs::Trajectory &trajectory);
-  const planning_msgs::Trajectory &trajectory() const { return trajectory_; }
+  void SetPoseTrack(PoseTrack pose_track) { pose_track_ = std::move(pose_track); }
+  const PoseTrack &pose_track() const { return pose_track_; }
+
+  /**
+   * @brief: the version of the actor state in ObstacleStore, 0 for the obstacles not from a store
+   */
+  uint64_t Version() const { return version_; }
+  void SetVersion(uint64_t version) { version_ = version; }
+
+  /**
+   * @brief: the predicted pose at a relative time, the current pose if there is no prediction
+   * @param relative_time
+   * @return
+   */
+  PoseTrack::Pose GetPoseAtTime(double relative_time) const;
+
+  /**
+   * @brief: GetPoseAtTime as a trajectory point
+   * @param relative_time
+   * @return
+   */
   planning_msgs::TrajectoryPoint GetPointAtTime(double relative_time) const;
   const common::Box2d &GetBoundingBox() const;
   bool HasTrajectory() const;
@@ -42,11 +64,16 @@ class Obstacle {
   const int &Id() const;
   const bool &IsVirtual() const { return is_virtual_; }
   const bool &IsValidObstacle() const;
-  const planning_msgs::Trajectory &GetPredictedTrajectory() const;
+  /**
+   * @brief: the prediction as a trajectory message, made on every call, e.g. for visualization
+   * @return
+   */
+  planning_msgs::Trajectory GetPredictedTrajectory() const;
   const double &AngularSpeed() const;
   const double &Heading() const;
   const common::Box2d &BoundingBox() const;
   common::Box2d GetBoundingBoxAtPoint(const planning_msgs::TrajectoryPoint &point) const;
+  common::Box2d GetBoundingBoxAtPose(const PoseTrack::Pose &pose) const;
 
  private:
   int id_{};
@@ -58,12 +85,25 @@ class Obstacle {
   bool is_static_ = false;
   bool is_virtual_ = false;
   bool is_valid_obstacle_{};
-  planning_msgs::Trajectory trajectory_;
+  PoseTrack pose_track_;
+  uint64_t version_{};
   double speed_{};
   double angular_speed_{};
 
   common::Box2d bounding_box_;
 
 };
+
+inline PoseTrack::Pose Obstacle::GetPoseAtTime(double relative_time) const {
+  // for static obstacle
+  if (pose_track_.Size() < 2) {
+    PoseTrack::Pose pose;
+    pose.x = center_.x();
+    pose.y = center_.y();
+    pose.theta = heading_;
+    return pose;
+  }
+  return pose_track_.GetPoseAtTime(relative_time);
+}
 }
 #endif
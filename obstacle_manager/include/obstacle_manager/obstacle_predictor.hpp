@@ -0,0 +1,147 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_OBSTACLE_PREDICTOR_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_OBSTACLE_PREDICTOR_HPP_
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "obstacle_manager/obstacle.hpp"
+#include "obstacle_manager/pose_track.hpp"
+#include "reference_line/reference_line.hpp"
+#include "thread_pool/thread_pool.hpp"
+
+namespace planning {
+
+/**
+ * @brief: the prediction stage of a planning cycle. every obstacle id is predicted once per cycle, the obstacles
+ * concurrently on a thread pool. a prediction is kept per id for the next cycles and reused, shifted by the time
+ * since it was made, as long as the actor still moves along it. an obstacle of an ObstacleStore keeps its prediction
+ * while its version does not change.
+ */
+class ObstaclePredictor {
+ public:
+  enum class Mode {
+    // straight line at the current speed and heading, as Obstacle::PredictTrajectory
+    kConstantVelocity,
+    // along the nearest aligned reference line at the current speed, converging to its center
+    kLaneFollowing,
+    // constant speed and yaw rate
+    kConstantTurnRate
+  };
+
+  ObstaclePredictor() = default;
+  ~ObstaclePredictor() = default;
+
+  /**
+   * @param mode
+   * @param predict_horizon
+   * @param predict_step
+   * @param thread_pool: predict the obstacles concurrently on it, nullptr to predict them one by one
+   * @param enable_cache: reuse the predictions of the last cycles
+   * @param position_tolerance: the max distance between the actor and its cached prediction to reuse it
+   * @param heading_tolerance: the max heading difference between the actor and its cached prediction
+   * @param speed_tolerance: the max speed difference between the actor and its cached prediction
+   */
+  ObstaclePredictor(Mode mode, double predict_horizon, double predict_step, common::ThreadPool *thread_pool,
+                    bool enable_cache, double position_tolerance, double heading_tolerance, double speed_tolerance);
+
+  /**
+   * @brief: the mode of a name: constant_velocity, lane_following or constant_turn_rate
+   * @param name
+   * @param mode
+   * @return: false if there is no such mode
+   */
+  static bool GetMode(const std::string &name, Mode *mode);
+
+  /**
+   * @brief: set the predicted trajectories of the obstacles, the obstacles with the same id share one prediction.
+   * not thread safe, call it once per planning cycle
+   * @param obstacles
+   * @param ref_lines: the reference lines of the cycle, for the lane following mode
+   * @param timestamp: the time of the cycle, in seconds
+   */
+  void Predict(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
+               const std::vector<ReferenceLine> &ref_lines,
+               double timestamp);
+
+  /**
+   * @brief: the number of obstacle ids the last Predict reused the cached prediction of
+   */
+  size_t NumReusedPredictions() const { return num_reused_predictions_; }
+
+  /**
+   * @brief: the number of obstacle ids the last Predict kept the prediction of, their version did not change
+   */
+  size_t NumUnchangedObstacles() const { return num_unchanged_obstacles_; }
+
+ private:
+  struct CachedPrediction {
+    double timestamp = 0.0;
+    // longer than predict_horizon_ by the max reuse time, so a shifted one still covers the whole horizon
+    PoseTrack track;
+  };
+
+  struct PredictionTask {
+    const Obstacle *obstacle = nullptr;
+    CachedPrediction *cached_prediction = nullptr;
+    bool reused = false;
+    // the obstacle version was predicted in the last cycle, its prediction is kept
+    bool unchanged = false;
+    CachedPrediction prediction;
+    PoseTrack track;
+  };
+
+  /**
+   * @brief: reuse the cached prediction of the task or predict the obstacle, thread safe
+   * @param ref_lines
+   * @param timestamp
+   * @param task
+   */
+  void PredictObstacle(const std::vector<ReferenceLine> &ref_lines, double timestamp, PredictionTask *task) const;
+
+  bool IsCachedPredictionValid(const Obstacle &obstacle, const CachedPrediction &cached_prediction,
+                               double time_offset) const;
+
+  /**
+   * @brief: the predict_horizon_ long window of a prediction starting at time_offset
+   * @param prediction
+   * @param time_offset
+   * @param track
+   */
+  void GetTrackWindow(const PoseTrack &prediction, double time_offset, PoseTrack *track) const;
+
+  void PredictConstantVelocity(const Obstacle &obstacle, size_t num_points, PoseTrack *track) const;
+
+  void PredictConstantTurnRate(const Obstacle &obstacle, size_t num_points, PoseTrack *track) const;
+
+  /**
+   * @brief: predict along the best matched reference line
+   * @return: false if no reference line matches the obstacle
+   */
+  bool PredictLaneFollowing(const Obstacle &obstacle, const std::vector<ReferenceLine> &ref_lines, size_t num_points,
+                            PoseTrack *track) const;
+
+  static PoseTrack::Pose GetInitPose(const Obstacle &obstacle);
+
+ private:
+  Mode mode_ = Mode::kConstantVelocity;
+  double predict_horizon_ = 8.0;
+  double predict_step_ = 0.1;
+  // the points of a prediction, as Obstacle::PredictTrajectory
+  size_t num_points_ = 80;
+  // the points of a cached prediction
+  size_t num_cached_points_ = 90;
+  common::ThreadPool *thread_pool_ = nullptr;
+  bool enable_cache_ = false;
+  double position_tolerance_ = 0.2;
+  double heading_tolerance_ = 0.05;
+  double speed_tolerance_ = 0.3;
+  std::unordered_map<int, CachedPrediction> cached_predictions_;
+  // the obstacle versions predicted in the last cycle, by id
+  std::unordered_map<int, uint64_t> predicted_versions_;
+  size_t num_reused_predictions_ = 0;
+  size_t num_unchanged_obstacles_ = 0;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_OBSTACLE_PREDICTOR_HPP_
@@ -0,0 +1,95 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_OBSTACLE_STORE_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_OBSTACLE_STORE_HPP_
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <derived_object_msgs/ObjectArray.h>
+#include "obstacle_manager/obstacle.hpp"
+
+namespace planning {
+
+/**
+ * @brief: the objects of the world, kept across the object messages by actor id. an entry is updated in place,
+ * its obstacle is rebuilt and its version increased only when the actor state changes, so the data derived from
+ * an obstacle (predictions, projections, boundaries) is reused for the actors that did not change.
+ */
+class ObstacleStore {
+ public:
+  struct State {
+    double timestamp = 0.0;
+    double x = 0.0;
+    double y = 0.0;
+    double heading = 0.0;
+    double speed = 0.0;
+  };
+
+  struct Entry {
+    derived_object_msgs::Object object;
+    // rebuilt on every change, shared with the planning cycles, its version is the entry version
+    std::shared_ptr<Obstacle> obstacle;
+    // increased on every change, starts from 1
+    uint64_t version = 0;
+    // changed since the last ClearDirtyFlags
+    bool dirty = true;
+    // the states of the last updates, the latest at the back
+    std::deque<State> history;
+  };
+
+  ObstacleStore() = default;
+  ~ObstacleStore() = default;
+
+  /**
+   * @param max_history_size: the states kept per actor
+   */
+  explicit ObstacleStore(size_t max_history_size);
+
+  /**
+   * @brief: update the store by an object message, the actors not in it are removed
+   * @param objects
+   * @param timestamp: the time of the message, in seconds
+   */
+  void Update(const std::vector<derived_object_msgs::Object> &objects, double timestamp);
+
+  /**
+   * @brief: the entry of an actor
+   * @param id
+   * @return: nullptr if there is no such actor
+   */
+  const Entry *Find(int id) const;
+
+  bool Contains(int id) const { return entries_.find(id) != entries_.end(); }
+
+  const std::unordered_map<int, Entry> &entries() const { return entries_; }
+
+  size_t Size() const { return entries_.size(); }
+
+  /**
+   * @brief: the number of the dirty actors
+   */
+  size_t NumDirty() const;
+
+  /**
+   * @brief: mark every actor as unchanged, e.g. at the end of a planning cycle
+   */
+  void ClearDirtyFlags();
+
+  /**
+   * @brief: whether the actor state used by the planner differs between two objects
+   * @param lhs
+   * @param rhs
+   * @return
+   */
+  static bool IsStateChanged(const derived_object_msgs::Object &lhs, const derived_object_msgs::Object &rhs);
+
+ private:
+  static State GetState(const Obstacle &obstacle, double timestamp);
+
+ private:
+  size_t max_history_size_ = 10;
+  std::unordered_map<int, Entry> entries_;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_OBSTACLE_STORE_HPP_
@@ -0,0 +1,135 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_POSE_TRACK_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_POSE_TRACK_HPP_
+#include <cmath>
+#include <vector>
+#include <planning_msgs/Trajectory.h>
+#include "math/math_utils.hpp"
+
+namespace planning {
+
+/**
+ * @brief: the predicted poses of an obstacle on a uniform time grid, one array per field. the pose at a time is
+ * interpolated between the two grid poses around it, found by index. GetPoseAtTime is inline, it is called
+ * for every obstacle at every time step of the st graphs and the collision checks.
+ */
+class PoseTrack {
+ public:
+  struct Pose {
+    double x = 0.0;
+    double y = 0.0;
+    double theta = 0.0;
+    double v = 0.0;
+    // the distance travelled along the track
+    double s = 0.0;
+  };
+
+  PoseTrack() = default;
+  ~PoseTrack() = default;
+
+  /**
+   * @param start_time: the relative time of the first pose
+   * @param time_step: the time between two poses
+   */
+  PoseTrack(double start_time, double time_step);
+
+  /**
+   * @brief: the track of a trajectory, resampled at its first time step if its points are not uniform in time
+   * @param trajectory
+   * @return
+   */
+  static PoseTrack FromTrajectory(const planning_msgs::Trajectory &trajectory);
+
+  /**
+   * @brief: the trajectory message of the track, e.g. for visualization
+   * @return
+   */
+  planning_msgs::Trajectory ToTrajectory() const;
+
+  void Reserve(size_t num_poses);
+
+  void Clear();
+
+  /**
+   * @brief: append a pose at StartTime() + Size() * TimeStep()
+   * @param pose
+   */
+  void AddPose(const Pose &pose);
+
+  size_t Size() const { return x_.size(); }
+
+  bool Empty() const { return x_.empty(); }
+
+  double StartTime() const { return start_time_; }
+
+  double TimeStep() const { return time_step_; }
+
+  /**
+   * @brief: the relative time of the last pose
+   */
+  double EndTime() const;
+
+  Pose GetPose(size_t index) const;
+
+  /**
+   * @brief: the pose at a relative time, the first or the last pose out of the track, the track is not empty
+   * @param relative_time
+   * @return
+   */
+  Pose GetPoseAtTime(double relative_time) const;
+
+ private:
+  double start_time_ = 0.0;
+  double time_step_ = 0.0;
+  std::vector<double> x_;
+  std::vector<double> y_;
+  // in [-pi, pi]
+  std::vector<double> theta_;
+  std::vector<double> v_;
+  std::vector<double> s_;
+};
+
+inline double PoseTrack::EndTime() const {
+  return x_.empty() ? start_time_ : start_time_ + time_step_ * static_cast<double>(x_.size() - 1);
+}
+
+inline PoseTrack::Pose PoseTrack::GetPose(size_t index) const {
+  Pose pose;
+  pose.x = x_[index];
+  pose.y = y_[index];
+  pose.theta = theta_[index];
+  pose.v = v_[index];
+  pose.s = s_[index];
+  return pose;
+}
+
+inline PoseTrack::Pose PoseTrack::GetPoseAtTime(double relative_time) const {
+  const double position = time_step_ > 0.0 ? (relative_time - start_time_) / time_step_ : 0.0;
+  if (!(position > 0.0)) {
+    return GetPose(0);
+  }
+  const size_t index = static_cast<size_t>(position);
+  if (index + 1 >= x_.size()) {
+    return GetPose(x_.size() - 1);
+  }
+  const double ratio = position - static_cast<double>(index);
+  Pose pose;
+  pose.x = x_[index] + ratio * (x_[index + 1] - x_[index]);
+  pose.y = y_[index] + ratio * (y_[index + 1] - y_[index]);
+  pose.v = v_[index] + ratio * (v_[index + 1] - v_[index]);
+  pose.s = s_[index] + ratio * (s_[index + 1] - s_[index]);
+  // the shorter way around, as MathUtils::slerp
+  double delta_theta = theta_[index + 1] - theta_[index];
+  if (delta_theta > M_PI) {
+    delta_theta -= 2.0 * M_PI;
+  } else if (delta_theta < -M_PI) {
+    delta_theta += 2.0 * M_PI;
+  }
+  pose.theta = theta_[index] + ratio * delta_theta;
+  if (pose.theta > M_PI || pose.theta < -M_PI) {
+    pose.theta = common::MathUtils::NormalizeAngle(pose.theta);
+  }
+  return pose;
+}
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_POSE_TRACK_HPP_
@@ -5,20 +5,31 @@
 #include <array>
 #include <ros/ros.h>
 #include <unordered_map>
+#include "obstacle_manager/blocking_interval_table.hpp"
 #include "obstacle_manager/obstacle.hpp"
+#include "obstacle_manager/st_graph_cache.hpp"
 #include "reference_line/reference_line.hpp"
 #include "math/frenet_frame.hpp"
+#include "thread_pool/thread_pool.hpp"
 namespace planning {
 class STGraph {
  public:
   STGraph() = default;
   ~STGraph() = default;
 
+  /**
+   * @param st_graph_cache: the sl boundaries of the last cycle to reuse, the sl boundaries of this graph are
+   * stored into it for the next cycle, nullptr to project every obstacle
+   * @param thread_pool: set up the obstacles concurrently on it, nullptr to set them up one by one. the graph
+   * is the same either way
+   */
   STGraph(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
           const ReferenceLine &reference_line,
           double s_start, double s_end, double t_start, double t_end,
           const std::array<double, 3> &init_d,
-          double max_lookahead_time, double delta_t);
+          double max_lookahead_time, double delta_t,
+          STGraphCache *st_graph_cache = nullptr,
+          common::ThreadPool *thread_pool = nullptr);
   /**
    *
    * @return
@@ -45,6 +56,12 @@ class STGraph {
                                                                                double end_time,
                                                                                double resolution) const;
 
+  /**
+   * @brief: the path blocking intervals on the time range of the graph, every delta_t
+   * @return
+   */
+  const BlockingIntervalTable &blocking_intervals() const { return blocking_intervals_; }
+
   /**
    *
    * @return
@@ -70,19 +87,72 @@ class STGraph {
 
   bool IsObstacleInGraph(int obstacle_id);
 
+  /**
+   * @brief: the number of obstacles whose cached sl boundaries were reused
+   */
+  size_t NumReusedObstacles() const { return num_reused_obstacles_; }
+
  private:
+  /**
+   * @brief: the result of setting up an obstacle, independent of the other obstacles
+   */
+  struct ObstacleSetUp {
+    bool has_st_boundary = false;
+    common::STBoundary st_boundary;
+    // the samples to cache, if the obstacle got as far as sampling
+    bool has_sl_samples = false;
+    std::vector<STGraphCache::SLSample> sl_samples;
+    bool reused = false;
+  };
+
   void SetUp(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
              ReferenceLine &ref_line);
 
+  void SetUpObstaclesConcurrently(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
+                                  const ReferenceLine &ref_line,
+                                  std::vector<ObstacleSetUp> *set_ups) const;
+
+  void SetUpObstacle(const std::shared_ptr<Obstacle> &obstacle,
+                     const ReferenceLine &ref_line,
+                     ObstacleSetUp *set_up) const;
+
   void SetUpStaticObstacle(const std::shared_ptr<Obstacle> &obstacle,
-                           const ReferenceLine &ref_line);
+                           const ReferenceLine &ref_line,
+                           ObstacleSetUp *set_up) const;
 
   void SetUpDynamicObstacle(const std::shared_ptr<Obstacle> &obstacle,
-                            const ReferenceLine &ref_line);
+                            const ReferenceLine &ref_line,
+                            ObstacleSetUp *set_up) const;
 
   bool MakeSTBoundary(const std::shared_ptr<Obstacle>& obstacle,
                       const ReferenceLine& ref_line,
-                      common::STBoundary& st_boundary) const;
+                      ObstacleSetUp *set_up) const;
+
+  /**
+   * @brief: the sl boundaries of the obstacle over the time range, reused from the cache if possible
+   * @param obstacle
+   * @param ref_line
+   * @param[out] sl_samples
+   * @return: true if cached samples are reused
+   */
+  bool SampleSLBoundaries(const std::shared_ptr<Obstacle> &obstacle,
+                          const ReferenceLine &ref_line,
+                          std::vector<STGraphCache::SLSample> *sl_samples) const;
+
+  /**
+   * @brief: shift the cached sl boundaries of the obstacle to this cycle, if its prediction is unchanged
+   * @param obstacle
+   * @param ref_line
+   * @param[out] sl_samples
+   * @return: false if nothing is reused
+   */
+  bool ReuseSLSamples(const std::shared_ptr<Obstacle> &obstacle,
+                      const ReferenceLine &ref_line,
+                      std::vector<STGraphCache::SLSample> *sl_samples) const;
+
+  static STGraphCache::SLSample MakeSLSample(const Obstacle &obstacle,
+                                             const ReferenceLine &ref_line,
+                                             double relative_time);
 
   static common::STPoint SetSTPoint(double s, double t);
 
@@ -93,8 +163,17 @@ class STGraph {
   std::pair<double, double> s_range_;
   ReferenceLine reference_line_;
   std::array<double, 3> init_d_{};
-  std::unordered_map<int, common::STBoundary> st_map_;
+  // obstacle id to the index in obstacles_st_boundary_
+  std::unordered_map<int, size_t> st_map_;
   std::vector<common::STBoundary> obstacles_st_boundary_;
+  BlockingIntervalTable blocking_intervals_;
+  STGraphCache *st_graph_cache_ = nullptr;
+  // the line of the last cycle matching reference_line_, s on reference_line_ is s on it plus cached_s_offset_
+  std::shared_ptr<const STGraphCache::LineCache> cached_line_;
+  double cached_s_offset_ = 0.0;
+  std::shared_ptr<STGraphCache::LineCache> line_cache_;
+  size_t num_reused_obstacles_ = 0;
+  common::ThreadPool *thread_pool_ = nullptr;
 //  std::vector<common::SLBoundary> obstacles_sl_boundary_;
 };
 }
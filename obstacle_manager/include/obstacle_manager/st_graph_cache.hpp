@@ -0,0 +1,118 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_ST_GRAPH_CACHE_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_ST_GRAPH_CACHE_HPP_
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <Eigen/Core>
+#include "obstacle_manager/obstacle.hpp"
+#include "reference_line/reference_line.hpp"
+
+namespace planning {
+
+/**
+ * @brief: the sl boundaries the st graphs of one planning cycle projected, kept for the next cycle. an obstacle
+ * whose prediction still matches the cached one, shifted by the cycle time, reuses its sl boundaries on the
+ * same reference line instead of projecting its predicted boxes again.
+ */
+class STGraphCache {
+ public:
+  /**
+   * @brief: the sl boundary of an obstacle box at a relative time, valid is false if the projection failed
+   */
+  struct SLSample {
+    double relative_time = 0.0;
+    bool valid = false;
+    double start_s = 0.0;
+    double end_s = 0.0;
+    double start_l = 0.0;
+    double end_l = 0.0;
+  };
+
+  struct ObstacleSamples {
+    // the obstacle with the prediction the samples were made from
+    std::shared_ptr<Obstacle> obstacle;
+    std::vector<SLSample> samples;
+  };
+
+  /**
+   * @brief: the samples of every obstacle on a reference line
+   */
+  struct LineCache {
+    // xy of the reference line every few meters, keyed by s, to recognize the line in the next cycle
+    std::vector<std::pair<double, Eigen::Vector2d>> signature;
+    std::unordered_map<int, ObstacleSamples> obstacles;
+  };
+
+  STGraphCache() = default;
+  ~STGraphCache() = default;
+
+  /**
+   * @param position_tolerance: the max distance between the cached and the new prediction or reference line
+   * @param heading_tolerance: the max heading difference between the cached and the new prediction
+   */
+  STGraphCache(double position_tolerance, double heading_tolerance);
+
+  /**
+   * @brief: start a planning cycle, the lines stored in the last cycle become the ones to reuse.
+   * not thread safe, call it before building the st graphs of the cycle
+   * @param timestamp: the time of the cycle, in seconds
+   */
+  void BeginCycle(double timestamp);
+
+  /**
+   * @brief: the time since the last cycle
+   */
+  double time_offset() const { return time_offset_; }
+
+  double position_tolerance() const { return position_tolerance_; }
+
+  double heading_tolerance() const { return heading_tolerance_; }
+
+  /**
+   * @brief: find the line of the last cycle with the same geometry as ref_line over [s_start, s_end]
+   * @param ref_line
+   * @param s_start
+   * @param s_end
+   * @param[out] s_offset: the s on ref_line minus the s on the cached line
+   * @return: nullptr if no line matches
+   */
+  std::shared_ptr<const LineCache> FindLine(const ReferenceLine &ref_line, double s_start, double s_end,
+                                            double *s_offset) const;
+
+  /**
+   * @brief: store the samples of a reference line for the next cycle, thread safe
+   * @param line_cache
+   */
+  void AddLine(std::shared_ptr<LineCache> line_cache);
+
+  /**
+   * @brief: sample the geometry of ref_line for FindLine
+   * @param ref_line
+   * @param line_cache
+   */
+  static void MakeSignature(const ReferenceLine &ref_line, LineCache *line_cache);
+
+  /**
+   * @brief: check the prediction of obstacle is the cached one, shifted by the time offset
+   * @param cached_obstacle: the obstacle of the last cycle
+   * @param obstacle: the obstacle of this cycle
+   * @param end_time: the last relative time of this cycle to check
+   * @return
+   */
+  bool IsPredictionUnchanged(const Obstacle &cached_obstacle, const Obstacle &obstacle, double end_time) const;
+
+ private:
+  double position_tolerance_ = 0.1;
+  double heading_tolerance_ = 0.02;
+  bool has_timestamp_ = false;
+  double timestamp_ = 0.0;
+  double time_offset_ = 0.0;
+  std::vector<std::shared_ptr<const LineCache>> previous_lines_;
+  std::mutex lines_mutex_;
+  std::vector<std::shared_ptr<const LineCache>> current_lines_;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_OBSTACLE_MANAGER_INCLUDE_OBSTACLE_MANAGER_ST_GRAPH_CACHE_HPP_
@@ -0,0 +1,63 @@
+#include "obstacle_manager/blocking_interval_table.hpp"
+#include <algorithm>
+
+namespace planning {
+using namespace common;
+
+BlockingIntervalTable::BlockingIntervalTable(const std::vector<STBoundary> &st_boundaries,
+                                             double start_time,
+                                             double end_time,
+                                             double resolution)
+    : start_time_(start_time), end_time_(end_time), resolution_(resolution) {
+  if (resolution <= 0.0) {
+    return;
+  }
+  // the same ticks as STGraph::GetPathBlockingIntervals(start_time, end_time, resolution)
+  for (double t = start_time; t <= end_time; t += resolution) {
+    tick_times_.push_back(t);
+  }
+  // every boundary only visits the ticks within its time range
+  std::vector<uint32_t> entry_ticks;
+  std::vector<std::pair<double, double>> entries;
+  for (const auto &st_boundary : st_boundaries) {
+    auto first_tick = std::lower_bound(tick_times_.begin(), tick_times_.end(), st_boundary.min_t());
+    for (auto tick = first_tick; tick != tick_times_.end() && *tick <= st_boundary.max_t(); ++tick) {
+      double s_upper, s_lower;
+      if (!st_boundary.GetBoundarySRange(*tick, &s_upper, &s_lower)) {
+        continue;
+      }
+      entry_ticks.push_back(static_cast<uint32_t>(tick - tick_times_.begin()));
+      entries.emplace_back(s_lower, s_upper);
+    }
+  }
+  // stable counting sort by tick, the intervals of a tick stay in the order of the boundaries
+  tick_offsets_.assign(tick_times_.size() + 1, 0);
+  for (const auto tick : entry_ticks) {
+    ++tick_offsets_[tick + 1];
+  }
+  for (size_t k = 1; k < tick_offsets_.size(); ++k) {
+    tick_offsets_[k] += tick_offsets_[k - 1];
+  }
+  intervals_.resize(entries.size());
+  interval_ticks_.resize(entries.size());
+  std::vector<size_t> tick_fill(tick_offsets_.begin(), tick_offsets_.end() - 1);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const size_t index = tick_fill[entry_ticks[i]]++;
+    intervals_[index] = entries[i];
+    interval_ticks_[index] = entry_ticks[i];
+  }
+}
+
+bool BlockingIntervalTable::IsOnGrid(double start_time, double end_time, double resolution) const {
+  return start_time == start_time_ && end_time == end_time_ && resolution == resolution_;
+}
+
+std::vector<std::vector<std::pair<double, double>>> BlockingIntervalTable::GetPathBlockingIntervals() const {
+  std::vector<std::vector<std::pair<double, double>>> intervals(NumTicks());
+  for (size_t tick = 0; tick < NumTicks(); ++tick) {
+    intervals[tick].assign(intervals_.begin() + tick_offsets_[tick], intervals_.begin() + tick_offsets_[tick + 1]);
+  }
+  return intervals;
+}
+
+}
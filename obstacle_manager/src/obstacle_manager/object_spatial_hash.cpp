@@ -0,0 +1,106 @@
+#include "obstacle_manager/object_spatial_hash.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace planning {
+
+ObjectSpatialHash::ObjectSpatialHash(double cell_size) : cell_size_(cell_size) {}
+
+size_t ObjectSpatialHash::AddEntry(int id, bool is_traffic_light, const Eigen::Vector2d &xy) {
+  Entry entry;
+  entry.id = id;
+  entry.is_traffic_light = is_traffic_light;
+  entry.xy = xy;
+  entries_.push_back(entry);
+  return entries_.size() - 1;
+}
+
+void ObjectSpatialHash::Build() {
+  std::vector<std::pair<int64_t, size_t>> keyed_entries;
+  keyed_entries.reserve(entries_.size());
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    keyed_entries.emplace_back(GetCellKey(entries_[i].xy.x(), entries_[i].xy.y()), i);
+  }
+  // by cell, then in the order the entries were added
+  std::sort(keyed_entries.begin(), keyed_entries.end());
+  cell_entries_.clear();
+  cell_entries_.reserve(keyed_entries.size());
+  cells_.clear();
+  for (size_t i = 0; i < keyed_entries.size(); ++i) {
+    if (i == 0 || keyed_entries[i].first != keyed_entries[i - 1].first) {
+      cells_[keyed_entries[i].first] = std::make_pair(i, i);
+    }
+    ++cells_[keyed_entries[i].first].second;
+    cell_entries_.push_back(keyed_entries[i].second);
+  }
+}
+
+void ObjectSpatialHash::QueryCorridor(const ReferenceLine &ref_line,
+                                      double s_start,
+                                      double s_end,
+                                      double radius,
+                                      std::vector<size_t> *entry_indices) const {
+  entry_indices->clear();
+  if (entries_.empty() || s_start > s_end) {
+    return;
+  }
+  const double length = ref_line.Length();
+  const auto start_point = ref_line.GetReferencePoint(0.0);
+  const auto end_point = ref_line.GetReferencePoint(length);
+  // every point of the line is within half a step of a sample
+  const double step = cell_size_;
+  const double sample_radius = radius + 0.5 * step;
+  const double sqr_sample_radius = sample_radius * sample_radius;
+  std::vector<bool> visited(entries_.size(), false);
+  for (double s = s_start;; s = std::min(s + step, s_end)) {
+    Eigen::Vector2d sample;
+    if (s < 0.0) {
+      sample << start_point.x() + s * std::cos(start_point.theta()),
+          start_point.y() + s * std::sin(start_point.theta());
+    } else if (s > length) {
+      sample << end_point.x() + (s - length) * std::cos(end_point.theta()),
+          end_point.y() + (s - length) * std::sin(end_point.theta());
+    } else {
+      const auto ref_point = ref_line.GetReferencePoint(s);
+      sample << ref_point.x(), ref_point.y();
+    }
+    const int64_t min_cell_x = static_cast<int64_t>(std::floor((sample.x() - sample_radius) / cell_size_));
+    const int64_t max_cell_x = static_cast<int64_t>(std::floor((sample.x() + sample_radius) / cell_size_));
+    const int64_t min_cell_y = static_cast<int64_t>(std::floor((sample.y() - sample_radius) / cell_size_));
+    const int64_t max_cell_y = static_cast<int64_t>(std::floor((sample.y() + sample_radius) / cell_size_));
+    for (int64_t cell_x = min_cell_x; cell_x <= max_cell_x; ++cell_x) {
+      for (int64_t cell_y = min_cell_y; cell_y <= max_cell_y; ++cell_y) {
+        auto cell = cells_.find(GetCellKey(cell_x, cell_y));
+        if (cell == cells_.end()) {
+          continue;
+        }
+        for (size_t k = cell->second.first; k < cell->second.second; ++k) {
+          const size_t index = cell_entries_[k];
+          if (visited[index]) {
+            continue;
+          }
+          const double dx = entries_[index].xy.x() - sample.x();
+          const double dy = entries_[index].xy.y() - sample.y();
+          if (dx * dx + dy * dy <= sqr_sample_radius) {
+            visited[index] = true;
+            entry_indices->push_back(index);
+          }
+        }
+      }
+    }
+    if (s >= s_end) {
+      break;
+    }
+  }
+  std::sort(entry_indices->begin(), entry_indices->end());
+}
+
+int64_t ObjectSpatialHash::GetCellKey(double x, double y) const {
+  return GetCellKey(static_cast<int64_t>(std::floor(x / cell_size_)), static_cast<int64_t>(std::floor(y / cell_size_)));
+}
+
+int64_t ObjectSpatialHash::GetCellKey(int64_t cell_x, int64_t cell_y) {
+  return (cell_x << 32) ^ (cell_y & 0xffffffff);
+}
+
+}
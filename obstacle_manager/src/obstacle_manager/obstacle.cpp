@@ -9,8 +9,7 @@ Obstacle::Obstacle(const derived_object_msgs::Object &object) {
       && !std::isnan(object.shape.dimensions[1])
       && !std::isnan(object.shape.dimensions[2]));
   id_ = object.id;
-  this->speed_ = std::sqrt(object.twist.linear.x +
-      object.twist.linear.y);
+  this->speed_ = std::hypot(object.twist.linear.x, object.twist.linear.y);
   this->angular_speed_ = object.twist.angular.z;
 //  this->is_static_ = std::fabs(this->speed_) < 0.1 && std::fabs(this->angular_speed_) < 0.1;
   this->is_static_ = false;
@@ -29,7 +28,8 @@ Obstacle::Obstacle(const Obstacle &other) {
   this->bounding_box_ = other.bounding_box_;
   this->speed_ = other.speed_;
   this->angular_speed_ = other.angular_speed_;
-  this->trajectory_ = other.trajectory_;
+  this->pose_track_ = other.pose_track_;
+  this->version_ = other.version_;
   this->is_valid_obstacle_ = other.is_valid_obstacle_;
   this->is_static_ = other.is_static_;
   this->center_ = other.center_;
@@ -41,40 +41,30 @@ Box2d Obstacle::GetBoundingBoxAtPoint(const planning_msgs::TrajectoryPoint &poin
   return Box2d(center, point.path_point.theta, bounding_box_.length(), bounding_box_.width());
 }
 
+Box2d Obstacle::GetBoundingBoxAtPose(const PoseTrack::Pose &pose) const {
+  return Box2d(Eigen::Vector2d(pose.x, pose.y), pose.theta, bounding_box_.length(), bounding_box_.width());
+}
+
 planning_msgs::TrajectoryPoint Obstacle::GetPointAtTime(double relative_time) const {
-  const auto &trajectory_points = trajectory_.trajectory_points;
+  const auto pose = GetPoseAtTime(relative_time);
+  planning_msgs::TrajectoryPoint point;
+  point.path_point.s = pose.s;
+  point.path_point.x = pose.x;
+  point.path_point.y = pose.y;
+  point.path_point.theta = pose.theta;
+  point.path_point.kappa = 0.0;
+  point.path_point.dkappa = 0.0;
+  point.vel = pose.v;
+  point.acc = 0.0;
+  point.jerk = 0.0;
+  point.steer_angle = 0.0;
   // for static obstacle
-  if (trajectory_points.size() < 2) {
-    planning_msgs::TrajectoryPoint point;
-    point.path_point.s = 0.0;
-    point.path_point.x = center_[0];
-    point.path_point.y = center_[1];
-    point.path_point.theta = heading_;
-    point.path_point.kappa = 0.0;
-    point.path_point.dkappa = 0.0;
-    point.vel = 0.0;
-    point.acc = 0.0;
-    point.jerk = 0.0;
-    point.steer_angle = 0.0;
-    point.relative_time = 0.0;
-    return point;
-  } else {
-    auto comp = [](const planning_msgs::TrajectoryPoint &p, const double &relative_time) -> bool {
-      return p.relative_time < relative_time;
-    };
-    auto it_lower = std::lower_bound(trajectory_points.begin(),
-                                     trajectory_points.end(), relative_time, comp);
-    if (it_lower == trajectory_points.begin()) {
-      return *trajectory_points.begin();
-    }
-    if (it_lower == trajectory_points.end()) {
-      return *trajectory_points.rbegin();
-    }
-    return MathUtils::InterpolateTrajectoryPoint(*(it_lower - 1), *it_lower, relative_time);
-  }
+  point.relative_time = pose_track_.Size() < 2 ? 0.0 : std::min(std::max(relative_time, pose_track_.StartTime()),
+                                                                 pose_track_.EndTime());
+  return point;
 }
 
-bool Obstacle::HasTrajectory() const { return trajectory_.trajectory_points.size() > 1; }
+bool Obstacle::HasTrajectory() const { return pose_track_.Size() > 1; }
 
 const Box2d &Obstacle::GetBoundingBox() const { return bounding_box_; }
 
@@ -86,7 +76,7 @@ const double &Obstacle::Speed() const { return speed_; }
 
 const int &Obstacle::Id() const { return id_; }
 
-const planning_msgs::Trajectory &Obstacle::GetPredictedTrajectory() const { return this->trajectory_; }
+planning_msgs::Trajectory Obstacle::GetPredictedTrajectory() const { return pose_track_.ToTrajectory(); }
 
 const bool &Obstacle::IsValidObstacle() const { return this->is_valid_obstacle_; }
 
@@ -97,67 +87,36 @@ const double &Obstacle::Heading() const { return heading_; }
 const double &Obstacle::AngularSpeed() const { return angular_speed_; }
 
 void Obstacle::PredictTrajectory(double predict_horizon, double predict_step) {
-  trajectory_ = decltype(trajectory_)();
-//  if (is_static_) {
-//    trajectory_.trajectory_points.emplace_back();
-//    auto &trajectory_point = trajectory_.trajectory_points.back();
-//    trajectory_point.path_point.x = center_.x();
-//    trajectory_point.path_point.y = center_.y();
-//    trajectory_point.path_point.s = 0.0;
-//    trajectory_point.path_point.theta = heading_;
-//    trajectory_point.path_point.kappa = 0.0;
-//    trajectory_point.path_point.dkappa = 0.0;
-//    trajectory_point.relative_time = 0.0;
-//    trajectory_point.vel = this->speed_;
-//    trajectory_point.acc = acc_;
-//    trajectory_point.jerk = 0.0;
-//    trajectory_point.steer_angle = 0.0;
-//  } else {
-  planning_msgs::TrajectoryPoint last_trajectory_point;
-  last_trajectory_point.path_point.x = this->center_.x();
-  last_trajectory_point.path_point.y = this->center_.y();
-  last_trajectory_point.path_point.kappa = 0.0;
-  last_trajectory_point.path_point.dkappa = 0.0;
-  last_trajectory_point.path_point.s = 0.0;
-  last_trajectory_point.path_point.theta = heading_;
-  last_trajectory_point.vel = speed_;
-  last_trajectory_point.acc = acc_;
-  last_trajectory_point.jerk = 0.0;
-  last_trajectory_point.steer_angle = 0.0;
-  last_trajectory_point.relative_time = 0.0;
-  trajectory_.trajectory_points.push_back(last_trajectory_point);
+  pose_track_ = PoseTrack(0.0, predict_step);
   const int kStepSize =
       static_cast<int>(predict_horizon / predict_step) < 1 ? 1 : static_cast<int>(predict_horizon / predict_step);
+  pose_track_.Reserve(kStepSize);
+  PoseTrack::Pose last_pose;
+  last_pose.x = this->center_.x();
+  last_pose.y = this->center_.y();
+  last_pose.theta = heading_;
+  last_pose.v = speed_;
+  last_pose.s = 0.0;
+  pose_track_.AddPose(last_pose);
   for (int i = 1; i < kStepSize; ++i) {
-    planning_msgs::TrajectoryPoint trajectory_point;
-//      trajectory_.trajectory_points.emplace_back();
-//      auto &trajectory_point = trajectory_.trajectory_points.back();
-    trajectory_point.path_point.x = last_trajectory_point.path_point.x +
-        predict_step * last_trajectory_point.vel * std::cos(last_trajectory_point.path_point.theta);
-    trajectory_point.path_point.y = last_trajectory_point.path_point.y +
-        predict_step * last_trajectory_point.vel * std::sin(last_trajectory_point.path_point.theta);
-    trajectory_point.path_point.theta = last_trajectory_point.path_point.theta;
-    trajectory_point.path_point.kappa = 0.0;
-    trajectory_point.path_point.dkappa = 0.0;
-    trajectory_point.relative_time = predict_step * static_cast<double>(i);
-    trajectory_point.vel = last_trajectory_point.vel;
-    trajectory_point.acc = 0.0;
-    trajectory_point.jerk = 0.0;
-    trajectory_point.steer_angle = 0.0;
-    double dx = trajectory_point.path_point.x - last_trajectory_point.path_point.x;
-    double dy = trajectory_point.path_point.y - last_trajectory_point.path_point.y;
+    PoseTrack::Pose pose;
+    pose.x = last_pose.x + predict_step * last_pose.v * std::cos(last_pose.theta);
+    pose.y = last_pose.y + predict_step * last_pose.v * std::sin(last_pose.theta);
+    pose.theta = last_pose.theta;
+    pose.v = last_pose.v;
+    double dx = pose.x - last_pose.x;
+    double dy = pose.y - last_pose.y;
     double delta_s = std::hypot(dx, dy);
-    trajectory_point.path_point.s = last_trajectory_point.path_point.s + delta_s;
-    trajectory_.trajectory_points.push_back(trajectory_point);
-    last_trajectory_point = trajectory_point;
+    pose.s = last_pose.s + delta_s;
+    pose_track_.AddPose(pose);
+    last_pose = pose;
   }
-//  }
 }
 
 Obstacle::Obstacle(const carla_msgs::CarlaTrafficLightInfo &traffic_light_info,
                    const carla_msgs::CarlaTrafficLightStatus &traffic_light_status)
     : id_(traffic_light_info.id), acc_(0.0), centripental_acc_(0.0),
-      kappa_(0.0), is_static_(true), is_virtual_(true), trajectory_(planning_msgs::Trajectory()),
+      kappa_(0.0), is_static_(true), is_virtual_(true),
       speed_(0.0), angular_speed_(0.0) {
   is_valid_obstacle_ = false;
   if (traffic_light_status.state == carla_msgs::CarlaTrafficLightStatus::RED
@@ -172,7 +131,7 @@ Obstacle::Obstacle(const carla_msgs::CarlaTrafficLightInfo &traffic_light_info,
 }
 
 void Obstacle::SetTrajectory(const planning_msgs::Trajectory &trajectory) {
-  this->trajectory_ = trajectory;
+  this->pose_track_ = PoseTrack::FromTrajectory(trajectory);
 }
 
 }
@@ -0,0 +1,281 @@
+#include "obstacle_manager/obstacle_predictor.hpp"
+#include <algorithm>
+#include <cmath>
+#include "math/math_utils.hpp"
+
+namespace {
+// a cached prediction is reused for at most this long, it is predicted this much longer than the horizon
+constexpr double kMaxReuseTime = 1.0;
+// the lane following prediction converges to the lane center over this distance travelled
+constexpr double kLateralDecayDistance = 10.0;
+constexpr double kMaxLaneOffset = 2.5;
+constexpr double kMaxLaneHeadingDiff = M_PI_4;
+constexpr double kMinYawRate = 1e-3;
+}
+
+namespace planning {
+using namespace common;
+
+ObstaclePredictor::ObstaclePredictor(Mode mode,
+                                     double predict_horizon,
+                                     double predict_step,
+                                     ThreadPool *thread_pool,
+                                     bool enable_cache,
+                                     double position_tolerance,
+                                     double heading_tolerance,
+                                     double speed_tolerance)
+    : mode_(mode), predict_horizon_(predict_horizon), predict_step_(predict_step), thread_pool_(thread_pool),
+      enable_cache_(enable_cache), position_tolerance_(position_tolerance), heading_tolerance_(heading_tolerance),
+      speed_tolerance_(speed_tolerance) {
+  const int num_points = static_cast<int>(predict_horizon_ / predict_step_);
+  num_points_ = num_points < 1 ? 1 : static_cast<size_t>(num_points);
+  num_cached_points_ = num_points_ + static_cast<size_t>(std::ceil(kMaxReuseTime / predict_step_));
+}
+
+bool ObstaclePredictor::GetMode(const std::string &name, Mode *mode) {
+  if (name == "constant_velocity") {
+    *mode = Mode::kConstantVelocity;
+  } else if (name == "lane_following") {
+    *mode = Mode::kLaneFollowing;
+  } else if (name == "constant_turn_rate") {
+    *mode = Mode::kConstantTurnRate;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void ObstaclePredictor::Predict(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
+                                const std::vector<ReferenceLine> &ref_lines,
+                                double timestamp) {
+  // one task per obstacle id
+  std::unordered_map<int, size_t> task_indices;
+  std::vector<PredictionTask> tasks;
+  for (const auto &obstacle : obstacles) {
+    if (task_indices.find(obstacle->Id()) != task_indices.end()) {
+      continue;
+    }
+    task_indices.emplace(obstacle->Id(), tasks.size());
+    tasks.emplace_back();
+    tasks.back().obstacle = obstacle.get();
+    if (obstacle->Version() != 0 && !obstacle->pose_track().Empty()) {
+      auto predicted_version = predicted_versions_.find(obstacle->Id());
+      tasks.back().unchanged =
+          predicted_version != predicted_versions_.end() && predicted_version->second == obstacle->Version();
+    }
+    if (enable_cache_) {
+      auto cached = cached_predictions_.find(obstacle->Id());
+      if (cached != cached_predictions_.end()) {
+        tasks.back().cached_prediction = &cached->second;
+      }
+    }
+  }
+
+  const size_t num_tasks = tasks.size();
+  if (thread_pool_ != nullptr && num_tasks > 1) {
+    thread_pool_->ParallelFor(num_tasks, [this, &ref_lines, &tasks, timestamp](size_t index) {
+      PredictObstacle(ref_lines, timestamp, &tasks[index]);
+    });
+  } else {
+    for (auto &task : tasks) {
+      PredictObstacle(ref_lines, timestamp, &task);
+    }
+  }
+
+  num_reused_predictions_ = 0;
+  num_unchanged_obstacles_ = 0;
+  for (const auto &obstacle : obstacles) {
+    obstacle->SetPoseTrack(tasks[task_indices.at(obstacle->Id())].track);
+  }
+  // the actors not seen in this cycle are dropped
+  std::unordered_map<int, CachedPrediction> cached_predictions;
+  std::unordered_map<int, uint64_t> predicted_versions;
+  for (auto &task : tasks) {
+    if (task.obstacle->Version() != 0) {
+      predicted_versions.emplace(task.obstacle->Id(), task.obstacle->Version());
+    }
+    if (task.unchanged) {
+      ++num_unchanged_obstacles_;
+    }
+    if (!enable_cache_) {
+      continue;
+    }
+    if (task.reused) {
+      ++num_reused_predictions_;
+      cached_predictions.emplace(task.obstacle->Id(), std::move(*task.cached_prediction));
+    } else if (!task.unchanged) {
+      cached_predictions.emplace(task.obstacle->Id(), std::move(task.prediction));
+    } else if (task.cached_prediction != nullptr) {
+      cached_predictions.emplace(task.obstacle->Id(), std::move(*task.cached_prediction));
+    }
+  }
+  cached_predictions_ = std::move(cached_predictions);
+  predicted_versions_ = std::move(predicted_versions);
+}
+
+void ObstaclePredictor::PredictObstacle(const std::vector<ReferenceLine> &ref_lines,
+                                        double timestamp,
+                                        PredictionTask *task) const {
+  const Obstacle &obstacle = *task->obstacle;
+  if (task->unchanged) {
+    task->track = obstacle.pose_track();
+    return;
+  }
+  if (task->cached_prediction != nullptr) {
+    const double time_offset = timestamp - task->cached_prediction->timestamp;
+    if (IsCachedPredictionValid(obstacle, *task->cached_prediction, time_offset)) {
+      task->reused = true;
+      GetTrackWindow(task->cached_prediction->track, time_offset, &task->track);
+      return;
+    }
+  }
+  task->prediction.timestamp = timestamp;
+  auto *prediction = &task->prediction.track;
+  // the traffic lights and the other virtual obstacles stay where they are
+  if (obstacle.IsVirtual() || mode_ == Mode::kConstantVelocity) {
+    PredictConstantVelocity(obstacle, num_cached_points_, prediction);
+  } else if (mode_ == Mode::kConstantTurnRate) {
+    PredictConstantTurnRate(obstacle, num_cached_points_, prediction);
+  } else if (!PredictLaneFollowing(obstacle, ref_lines, num_cached_points_, prediction)) {
+    PredictConstantVelocity(obstacle, num_cached_points_, prediction);
+  }
+  GetTrackWindow(*prediction, 0.0, &task->track);
+}
+
+bool ObstaclePredictor::IsCachedPredictionValid(const Obstacle &obstacle,
+                                                const CachedPrediction &cached_prediction,
+                                                double time_offset) const {
+  if (time_offset < 0.0 || time_offset > kMaxReuseTime) {
+    return false;
+  }
+  const auto pose = cached_prediction.track.GetPoseAtTime(time_offset);
+  return std::hypot(pose.x - obstacle.x(), pose.y - obstacle.y()) <= position_tolerance_
+      && std::fabs(MathUtils::NormalizeAngle(pose.theta - obstacle.Heading())) <= heading_tolerance_
+      && std::fabs(pose.v - obstacle.Speed()) <= speed_tolerance_;
+}
+
+void ObstaclePredictor::GetTrackWindow(const PoseTrack &prediction, double time_offset, PoseTrack *track) const {
+  *track = PoseTrack(0.0, predict_step_);
+  const size_t num_points = std::min(num_points_, prediction.Size());
+  track->Reserve(num_points);
+  if (time_offset <= 0.0) {
+    for (size_t i = 0; i < num_points; ++i) {
+      track->AddPose(prediction.GetPose(i));
+    }
+    return;
+  }
+  const double start_s = prediction.GetPoseAtTime(time_offset).s;
+  for (size_t i = 0; i < num_points; ++i) {
+    auto pose = prediction.GetPoseAtTime(predict_step_ * static_cast<double>(i) + time_offset);
+    pose.s -= start_s;
+    track->AddPose(pose);
+  }
+}
+
+PoseTrack::Pose ObstaclePredictor::GetInitPose(const Obstacle &obstacle) {
+  PoseTrack::Pose pose;
+  pose.x = obstacle.x();
+  pose.y = obstacle.y();
+  pose.theta = obstacle.Heading();
+  pose.v = obstacle.Speed();
+  pose.s = 0.0;
+  return pose;
+}
+
+// the same rollout as Obstacle::PredictTrajectory
+void ObstaclePredictor::PredictConstantVelocity(const Obstacle &obstacle, size_t num_points, PoseTrack *track) const {
+  *track = PoseTrack(0.0, predict_step_);
+  track->Reserve(num_points);
+  PoseTrack::Pose last_pose = GetInitPose(obstacle);
+  track->AddPose(last_pose);
+  for (size_t i = 1; i < num_points; ++i) {
+    PoseTrack::Pose pose = last_pose;
+    pose.x = last_pose.x + predict_step_ * last_pose.v * std::cos(last_pose.theta);
+    pose.y = last_pose.y + predict_step_ * last_pose.v * std::sin(last_pose.theta);
+    pose.s = last_pose.s + std::hypot(pose.x - last_pose.x, pose.y - last_pose.y);
+    track->AddPose(pose);
+    last_pose = pose;
+  }
+}
+
+void ObstaclePredictor::PredictConstantTurnRate(const Obstacle &obstacle, size_t num_points, PoseTrack *track) const {
+  const double yaw_rate = obstacle.AngularSpeed();
+  if (std::fabs(yaw_rate) < kMinYawRate) {
+    PredictConstantVelocity(obstacle, num_points, track);
+    return;
+  }
+  *track = PoseTrack(0.0, predict_step_);
+  track->Reserve(num_points);
+  PoseTrack::Pose pose = GetInitPose(obstacle);
+  track->AddPose(pose);
+  const double speed = obstacle.Speed();
+  const double radius = speed / yaw_rate;
+  // on the circle around the turning center, not accumulated step by step
+  const double center_x = obstacle.x() - radius * std::sin(obstacle.Heading());
+  const double center_y = obstacle.y() + radius * std::cos(obstacle.Heading());
+  for (size_t i = 1; i < num_points; ++i) {
+    const double relative_time = predict_step_ * static_cast<double>(i);
+    const double theta = obstacle.Heading() + yaw_rate * relative_time;
+    pose.x = center_x + radius * std::sin(theta);
+    pose.y = center_y - radius * std::cos(theta);
+    pose.theta = MathUtils::NormalizeAngle(theta);
+    pose.s = std::fabs(speed) * relative_time;
+    track->AddPose(pose);
+  }
+}
+
+bool ObstaclePredictor::PredictLaneFollowing(const Obstacle &obstacle,
+                                             const std::vector<ReferenceLine> &ref_lines,
+                                             size_t num_points,
+                                             PoseTrack *track) const {
+  const ReferenceLine *matched_line = nullptr;
+  SLPoint init_sl_point;
+  for (const auto &ref_line : ref_lines) {
+    SLPoint sl_point;
+    if (!ref_line.XYToSL(obstacle.Center(), &sl_point) || sl_point.s < 0.0 || sl_point.s > ref_line.Length()
+        || std::fabs(sl_point.l) > kMaxLaneOffset) {
+      continue;
+    }
+    const double heading_diff = MathUtils::NormalizeAngle(
+        obstacle.Heading() - ref_line.GetReferencePoint(sl_point.s).theta());
+    if (std::fabs(heading_diff) > kMaxLaneHeadingDiff) {
+      continue;
+    }
+    if (matched_line == nullptr || std::fabs(sl_point.l) < std::fabs(init_sl_point.l)) {
+      matched_line = &ref_line;
+      init_sl_point = sl_point;
+    }
+  }
+  if (matched_line == nullptr) {
+    return false;
+  }
+  *track = PoseTrack(0.0, predict_step_);
+  track->Reserve(num_points);
+  PoseTrack::Pose last_pose = GetInitPose(obstacle);
+  track->AddPose(last_pose);
+  const double speed = std::max(obstacle.Speed(), 0.0);
+  for (size_t i = 1; i < num_points; ++i) {
+    PoseTrack::Pose pose = last_pose;
+    SLPoint sl_point;
+    sl_point.s = init_sl_point.s + speed * predict_step_ * static_cast<double>(i);
+    // the lateral offset decays with the distance travelled, a standing actor stays where it is
+    sl_point.l = init_sl_point.l * std::exp(-(sl_point.s - init_sl_point.s) / kLateralDecayDistance);
+    Eigen::Vector2d xy;
+    if (sl_point.s <= matched_line->Length() && matched_line->SLToXY(sl_point, &xy)) {
+      pose.x = xy.x();
+      pose.y = xy.y();
+      pose.theta = MathUtils::NormalizeAngle(matched_line->GetReferencePoint(sl_point.s).theta()
+                                                 - std::atan(sl_point.l / kLateralDecayDistance));
+    } else {
+      // straight on past the end of the reference line
+      pose.x = last_pose.x + predict_step_ * speed * std::cos(last_pose.theta);
+      pose.y = last_pose.y + predict_step_ * speed * std::sin(last_pose.theta);
+    }
+    pose.s = last_pose.s + std::hypot(pose.x - last_pose.x, pose.y - last_pose.y);
+    track->AddPose(pose);
+    last_pose = pose;
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,86 @@
+#include "obstacle_manager/obstacle_store.hpp"
+#include <unordered_set>
+
+namespace planning {
+
+ObstacleStore::ObstacleStore(size_t max_history_size) : max_history_size_(max_history_size) {}
+
+void ObstacleStore::Update(const std::vector<derived_object_msgs::Object> &objects, double timestamp) {
+  std::unordered_set<int> ids;
+  ids.reserve(objects.size());
+  for (const auto &object : objects) {
+    ids.insert(object.id);
+    auto &entry = entries_[object.id];
+    if (entry.obstacle == nullptr || IsStateChanged(entry.object, object)) {
+      entry.object = object;
+      ++entry.version;
+      entry.dirty = true;
+      entry.obstacle = std::make_shared<Obstacle>(object);
+      entry.obstacle->SetVersion(entry.version);
+    }
+    entry.history.push_back(GetState(*entry.obstacle, timestamp));
+    while (entry.history.size() > max_history_size_) {
+      entry.history.pop_front();
+    }
+  }
+  for (auto iter = entries_.begin(); iter != entries_.end();) {
+    if (ids.find(iter->first) == ids.end()) {
+      iter = entries_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+const ObstacleStore::Entry *ObstacleStore::Find(int id) const {
+  auto iter = entries_.find(id);
+  return iter == entries_.end() ? nullptr : &iter->second;
+}
+
+size_t ObstacleStore::NumDirty() const {
+  size_t num_dirty = 0;
+  for (const auto &entry : entries_) {
+    if (entry.second.dirty) {
+      ++num_dirty;
+    }
+  }
+  return num_dirty;
+}
+
+void ObstacleStore::ClearDirtyFlags() {
+  for (auto &entry : entries_) {
+    entry.second.dirty = false;
+  }
+}
+
+bool ObstacleStore::IsStateChanged(const derived_object_msgs::Object &lhs, const derived_object_msgs::Object &rhs) {
+  const auto &lhs_pose = lhs.pose;
+  const auto &rhs_pose = rhs.pose;
+  if (lhs_pose.position.x != rhs_pose.position.x || lhs_pose.position.y != rhs_pose.position.y
+      || lhs_pose.position.z != rhs_pose.position.z || lhs_pose.orientation.x != rhs_pose.orientation.x
+      || lhs_pose.orientation.y != rhs_pose.orientation.y || lhs_pose.orientation.z != rhs_pose.orientation.z
+      || lhs_pose.orientation.w != rhs_pose.orientation.w) {
+    return true;
+  }
+  if (lhs.twist.linear.x != rhs.twist.linear.x || lhs.twist.linear.y != rhs.twist.linear.y
+      || lhs.twist.linear.z != rhs.twist.linear.z || lhs.twist.angular.z != rhs.twist.angular.z) {
+    return true;
+  }
+  if (lhs.accel.linear.x != rhs.accel.linear.x || lhs.accel.linear.y != rhs.accel.linear.y) {
+    return true;
+  }
+  return lhs.shape.dimensions != rhs.shape.dimensions || lhs.classification != rhs.classification
+      || lhs.object_classified != rhs.object_classified;
+}
+
+ObstacleStore::State ObstacleStore::GetState(const Obstacle &obstacle, double timestamp) {
+  State state;
+  state.timestamp = timestamp;
+  state.x = obstacle.x();
+  state.y = obstacle.y();
+  state.heading = obstacle.Heading();
+  state.speed = obstacle.Speed();
+  return state;
+}
+
+}
@@ -0,0 +1,103 @@
+#include "obstacle_manager/pose_track.hpp"
+#include <algorithm>
+#include <ros/ros.h>
+
+namespace planning {
+using namespace common;
+
+PoseTrack::PoseTrack(double start_time, double time_step) : start_time_(start_time), time_step_(time_step) {}
+
+PoseTrack PoseTrack::FromTrajectory(const planning_msgs::Trajectory &trajectory) {
+  const auto &points = trajectory.trajectory_points;
+  if (points.empty()) {
+    return PoseTrack();
+  }
+  const double start_time = points.front().relative_time;
+  const double time_step = points.size() < 2 ? 0.0 : points[1].relative_time - start_time;
+  PoseTrack track(start_time, time_step);
+  track.Reserve(points.size());
+  const auto to_pose = [](const planning_msgs::TrajectoryPoint &point) {
+    Pose pose;
+    pose.x = point.path_point.x;
+    pose.y = point.path_point.y;
+    pose.theta = point.path_point.theta;
+    pose.v = point.vel;
+    pose.s = point.path_point.s;
+    return pose;
+  };
+  constexpr double kEpsilon = 1e-6;
+  bool is_uniform = time_step > kEpsilon || points.size() < 2;
+  for (size_t i = 1; is_uniform && i < points.size(); ++i) {
+    is_uniform = std::fabs(points[i].relative_time - (start_time + time_step * static_cast<double>(i))) < kEpsilon;
+  }
+  if (is_uniform) {
+    for (const auto &point : points) {
+      track.AddPose(to_pose(point));
+    }
+    return track;
+  }
+  if (time_step <= kEpsilon) {
+    ROS_WARN("[PoseTrack::FromTrajectory], the trajectory is not increasing in time");
+    track.AddPose(to_pose(points.front()));
+    return track;
+  }
+  auto comp = [](const planning_msgs::TrajectoryPoint &p, const double &relative_time) -> bool {
+    return p.relative_time < relative_time;
+  };
+  const double end_time = points.back().relative_time;
+  for (size_t i = 0; start_time + time_step * static_cast<double>(i) <= end_time + kEpsilon; ++i) {
+    const double relative_time = start_time + time_step * static_cast<double>(i);
+    auto it_lower = std::lower_bound(points.begin(), points.end(), relative_time, comp);
+    if (it_lower == points.begin()) {
+      track.AddPose(to_pose(points.front()));
+    } else if (it_lower == points.end()) {
+      track.AddPose(to_pose(points.back()));
+    } else {
+      track.AddPose(to_pose(MathUtils::InterpolateTrajectoryPoint(*(it_lower - 1), *it_lower, relative_time)));
+    }
+  }
+  return track;
+}
+
+planning_msgs::Trajectory PoseTrack::ToTrajectory() const {
+  planning_msgs::Trajectory trajectory;
+  trajectory.trajectory_points.reserve(Size());
+  for (size_t i = 0; i < Size(); ++i) {
+    planning_msgs::TrajectoryPoint point;
+    point.path_point.x = x_[i];
+    point.path_point.y = y_[i];
+    point.path_point.theta = theta_[i];
+    point.path_point.s = s_[i];
+    point.path_point.kappa = 0.0;
+    point.path_point.dkappa = 0.0;
+    point.vel = v_[i];
+    point.acc = 0.0;
+    point.jerk = 0.0;
+    point.steer_angle = 0.0;
+    point.relative_time = start_time_ + time_step_ * static_cast<double>(i);
+    trajectory.trajectory_points.push_back(point);
+  }
+  return trajectory;
+}
+
+void PoseTrack::Reserve(size_t num_poses) {
+  for (auto *values : {&x_, &y_, &theta_, &v_, &s_}) {
+    values->reserve(num_poses);
+  }
+}
+
+void PoseTrack::Clear() {
+  for (auto *values : {&x_, &y_, &theta_, &v_, &s_}) {
+    values->clear();
+  }
+}
+
+void PoseTrack::AddPose(const Pose &pose) {
+  x_.push_back(pose.x);
+  y_.push_back(pose.y);
+  theta_.push_back(pose.theta > M_PI || pose.theta < -M_PI ? MathUtils::NormalizeAngle(pose.theta) : pose.theta);
+  v_.push_back(pose.v);
+  s_.push_back(pose.s);
+}
+
+}
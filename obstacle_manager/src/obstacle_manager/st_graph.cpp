@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <utility>
 #include "obstacle_manager/st_graph.hpp"
 #include "obstacle_manager/obstacle.hpp"
@@ -17,13 +18,17 @@ STGraph::STGraph(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
                  double t_end,
                  const std::array<double, 3> &init_d,
                  double max_lookahead_time,
-                 double delta_t)
+                 double delta_t,
+                 STGraphCache *st_graph_cache,
+                 common::ThreadPool *thread_pool)
     : max_lookahed_time_(max_lookahead_time),
       delta_t_(delta_t),
       time_range_({t_start, t_end}),
       s_range_({s_start, s_end}),
       reference_line_(reference_line),
-      init_d_(init_d) {
+      init_d_(init_d),
+      st_graph_cache_(st_graph_cache),
+      thread_pool_(thread_pool) {
 
   ROS_ASSERT(s_end >= s_start);
   ROS_ASSERT(t_end >= t_start);
@@ -35,13 +40,41 @@ void STGraph::SetUp(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
                     ReferenceLine &ref_line) {
 //  obstacles_sl_boundary_.clear();
   st_map_.clear();
-  for (const auto &obstacle : obstacles) {
-    if (obstacle->IsStatic()) {
-      SetUpStaticObstacle(obstacle, ref_line);
-    } else {
-      SetUpDynamicObstacle(obstacle, ref_line);
+  num_reused_obstacles_ = 0;
+  if (st_graph_cache_ != nullptr) {
+    cached_line_ = st_graph_cache_->FindLine(ref_line, s_range_.first, s_range_.second, &cached_s_offset_);
+    line_cache_ = std::make_shared<STGraphCache::LineCache>();
+    STGraphCache::MakeSignature(ref_line, line_cache_.get());
+  }
+  std::vector<ObstacleSetUp> set_ups(obstacles.size());
+  if (thread_pool_ != nullptr && obstacles.size() > 1) {
+    SetUpObstaclesConcurrently(obstacles, ref_line, &set_ups);
+  } else {
+    for (size_t i = 0; i < obstacles.size(); ++i) {
+      SetUpObstacle(obstacles[i], ref_line, &set_ups[i]);
+    }
+  }
+  // merged in the obstacle order, so st_map_ and obstacles_st_boundary_ don't depend on the threads
+  for (size_t i = 0; i < obstacles.size(); ++i) {
+    const auto &obstacle = obstacles[i];
+    auto &set_up = set_ups[i];
+    if (set_up.reused) {
+      ++num_reused_obstacles_;
+    }
+    if (line_cache_ != nullptr && set_up.has_sl_samples) {
+      auto &cached = line_cache_->obstacles[obstacle->Id()];
+      cached.obstacle = obstacle;
+      cached.samples = std::move(set_up.sl_samples);
+    }
+    if (set_up.has_st_boundary) {
+      // a later obstacle with the same id replaces the earlier one
+      st_map_[obstacle->Id()] = i;
     }
   }
+  if (st_graph_cache_ != nullptr) {
+    st_graph_cache_->AddLine(std::move(line_cache_));
+    cached_line_.reset();
+  }
 
 //  // for static obstacles
 //  std::sort(obstacles_sl_boundary_.begin(), obstacles_sl_boundary_.end(),
@@ -49,18 +82,40 @@ void STGraph::SetUp(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
 //              return sl0.start_s < sl1.start_s;
 //            });
 
-  // for static and dynamic obstacles
+  // for static and dynamic obstacles, st_map_ is turned from the set up index to the boundary index
+  obstacles_st_boundary_.reserve(st_map_.size());
   for (auto &obstacle_st : st_map_) {
-    obstacles_st_boundary_.push_back(obstacle_st.second);
+    obstacles_st_boundary_.push_back(std::move(set_ups[obstacle_st.second].st_boundary));
+    obstacle_st.second = obstacles_st_boundary_.size() - 1;
   }
+  blocking_intervals_ = BlockingIntervalTable(obstacles_st_boundary_, time_range_.first, time_range_.second, delta_t_);
   ROS_INFO("[STGraph::SetUp], obstacle_st_boundary size is %zu", obstacles_st_boundary_.size());
 }
 
+void STGraph::SetUpObstaclesConcurrently(const std::vector<std::shared_ptr<Obstacle>> &obstacles,
+                                         const ReferenceLine &ref_line,
+                                         std::vector<ObstacleSetUp> *set_ups) const {
+  thread_pool_->ParallelFor(obstacles.size(), [this, &obstacles, &ref_line, set_ups](size_t index) {
+    SetUpObstacle(obstacles[index], ref_line, &(*set_ups)[index]);
+  });
+}
+
+void STGraph::SetUpObstacle(const std::shared_ptr<Obstacle> &obstacle,
+                            const ReferenceLine &ref_line,
+                            ObstacleSetUp *set_up) const {
+  if (obstacle->IsStatic()) {
+    SetUpStaticObstacle(obstacle, ref_line, set_up);
+  } else {
+    SetUpDynamicObstacle(obstacle, ref_line, set_up);
+  }
+}
+
 void STGraph::SetUpStaticObstacle(const std::shared_ptr<Obstacle> &obstacle,
-                                  const ReferenceLine &ref_line) {
+                                  const ReferenceLine &ref_line,
+                                  ObstacleSetUp *set_up) const {
   auto box = obstacle->BoundingBox();
   SLBoundary sl_boundary;
-  if (!ref_line.GetSLBoundary(box, &sl_boundary)) {
+  if (!ref_line.GetSLBoundary(box, &sl_boundary, false)) {
     ROS_INFO("[STGraph::SetUpStaticObstacle] Failed to GetSLBoundary.");
     return;
   }
@@ -71,62 +126,126 @@ void STGraph::SetUpStaticObstacle(const std::shared_ptr<Obstacle> &obstacle,
     ROS_INFO("[STGraph::SetUpStaticObstacle], obstacle[%i] is out of range. ", obstacle_id);
     return;
   }
-  STBoundary st_boundary;
-  if (!MakeSTBoundary(obstacle, ref_line, st_boundary)) {
+  if (!MakeSTBoundary(obstacle, ref_line, set_up)) {
     ROS_FATAL("[SetUpStaticObstacle Failed], Failed To MakeSTBoundary");
     return;
   }
-  if (st_map_.find(obstacle->Id()) == st_map_.end()) {
-    st_map_.emplace(obstacle->Id(), st_boundary);
-  } else {
-    st_map_[obstacle->Id()] = st_boundary;
-  }
 //  obstacles_sl_boundary_.push_back(std::move(sl_boundary));
 }
 
 bool STGraph::MakeSTBoundary(const std::shared_ptr<Obstacle> &obstacle,
                              const ReferenceLine &ref_line,
-                             STBoundary &st_boundary) const {
-
-  double relative_time = time_range_.first;
+                             ObstacleSetUp *set_up) const {
+  set_up->reused = SampleSLBoundaries(obstacle, ref_line, &set_up->sl_samples);
+  set_up->has_sl_samples = true;
   std::vector<std::pair<STPoint, STPoint>> st_points;
-  while (relative_time < time_range_.second) {
-    planning_msgs::TrajectoryPoint point = obstacle->GetPointAtTime(relative_time);
-    Box2d box = obstacle->GetBoundingBoxAtPoint(point);
-    SLBoundary sl_boundary;
-    if (!ref_line.GetSLBoundary(box, &sl_boundary)) {
-      relative_time += delta_t_;
+  for (const auto &sl_sample : set_up->sl_samples) {
+    if (!sl_sample.valid) {
       continue;
     }
-    if (sl_boundary.start_s > s_range_.second || sl_boundary.end_s < s_range_.first ||
-        sl_boundary.start_l > kLeftWidth || sl_boundary.end_l < -kRightWidth) {
-      relative_time += delta_t_;
+    if (sl_sample.start_s > s_range_.second || sl_sample.end_s < s_range_.first ||
+        sl_sample.start_l > kLeftWidth || sl_sample.end_l < -kRightWidth) {
       continue;
     }
-    STPoint lower_st_point(sl_boundary.start_s, relative_time);
-    STPoint upper_st_point(sl_boundary.end_s, relative_time);
+    STPoint lower_st_point(sl_sample.start_s, sl_sample.relative_time);
+    STPoint upper_st_point(sl_sample.end_s, sl_sample.relative_time);
     st_points.emplace_back(lower_st_point, upper_st_point);
-    relative_time += delta_t_;
   }
   if (st_points.empty()) {
     return false;
   }
-  st_boundary = STBoundary(st_points);
-  st_boundary.set_id(obstacle->Id());
+  set_up->st_boundary = STBoundary(st_points);
+  set_up->st_boundary.set_id(obstacle->Id());
+  set_up->has_st_boundary = true;
   return true;
 }
 
-void STGraph::SetUpDynamicObstacle(const std::shared_ptr<Obstacle> &obstacle,
-                                   const ReferenceLine &ref_line) {
-  common::STBoundary st_boundary;
-  if (!MakeSTBoundary(obstacle, ref_line, st_boundary)) {
-    return;
+bool STGraph::SampleSLBoundaries(const std::shared_ptr<Obstacle> &obstacle,
+                                 const ReferenceLine &ref_line,
+                                 std::vector<STGraphCache::SLSample> *sl_samples) const {
+  constexpr double kEpsilon = 1e-6;
+  sl_samples->clear();
+  double relative_time = time_range_.first;
+  const bool reused = ReuseSLSamples(obstacle, ref_line, sl_samples);
+  if (reused) {
+    // only the times past the reused ones are projected
+    while (relative_time <= sl_samples->back().relative_time + kEpsilon) {
+      relative_time += delta_t_;
+    }
   }
-  if (st_map_.find(obstacle->Id()) == st_map_.end()) {
-    st_map_.emplace(obstacle->Id(), st_boundary);
-  } else {
-    st_map_[obstacle->Id()] = st_boundary;
+  while (relative_time < time_range_.second) {
+    sl_samples->push_back(MakeSLSample(*obstacle, ref_line, relative_time));
+    relative_time += delta_t_;
   }
+  return reused;
+}
+
+bool STGraph::ReuseSLSamples(const std::shared_ptr<Obstacle> &obstacle,
+                             const ReferenceLine &ref_line,
+                             std::vector<STGraphCache::SLSample> *sl_samples) const {
+  constexpr double kEpsilon = 1e-6;
+  if (cached_line_ == nullptr) {
+    return false;
+  }
+  auto iter = cached_line_->obstacles.find(obstacle->Id());
+  if (iter == cached_line_->obstacles.end()) {
+    return false;
+  }
+  const auto &cached = iter->second;
+  const double time_offset = st_graph_cache_->time_offset();
+  // past the end of the cached prediction, the cached obstacle stands still, the new one may not
+  double end_time = time_range_.second;
+  if (cached.obstacle->HasTrajectory()) {
+    end_time = std::min(end_time, cached.obstacle->pose_track().EndTime() - time_offset);
+  }
+  if (end_time <= time_range_.first) {
+    return false;
+  }
+  if (!st_graph_cache_->IsPredictionUnchanged(*cached.obstacle, *obstacle, end_time)) {
+    return false;
+  }
+  for (const auto &cached_sample : cached.samples) {
+    const double relative_time = cached_sample.relative_time - time_offset;
+    if (relative_time < time_range_.first - kEpsilon) {
+      continue;
+    }
+    if (relative_time > end_time + kEpsilon) {
+      break;
+    }
+    if (sl_samples->empty() && relative_time > time_range_.first + kEpsilon) {
+      sl_samples->push_back(MakeSLSample(*obstacle, ref_line, time_range_.first));
+    }
+    STGraphCache::SLSample sl_sample = cached_sample;
+    sl_sample.relative_time = std::max(relative_time, time_range_.first);
+    sl_sample.start_s += cached_s_offset_;
+    sl_sample.end_s += cached_s_offset_;
+    sl_samples->push_back(sl_sample);
+  }
+  return !sl_samples->empty();
+}
+
+STGraphCache::SLSample STGraph::MakeSLSample(const Obstacle &obstacle,
+                                             const ReferenceLine &ref_line,
+                                             double relative_time) {
+  STGraphCache::SLSample sl_sample;
+  sl_sample.relative_time = relative_time;
+  Box2d box = obstacle.GetBoundingBoxAtPose(obstacle.GetPoseAtTime(relative_time));
+  // only the s and l range are used, the boundary points are not needed
+  SLBoundary sl_boundary;
+  sl_sample.valid = ref_line.GetSLBoundary(box, &sl_boundary, false);
+  if (sl_sample.valid) {
+    sl_sample.start_s = sl_boundary.start_s;
+    sl_sample.end_s = sl_boundary.end_s;
+    sl_sample.start_l = sl_boundary.start_l;
+    sl_sample.end_l = sl_boundary.end_l;
+  }
+  return sl_sample;
+}
+
+void STGraph::SetUpDynamicObstacle(const std::shared_ptr<Obstacle> &obstacle,
+                                   const ReferenceLine &ref_line,
+                                   ObstacleSetUp *set_up) const {
+  MakeSTBoundary(obstacle, ref_line, set_up);
 }
 
 STPoint STGraph::SetSTPoint(double s, double t) {
@@ -137,10 +256,11 @@ bool STGraph::GetSTObstacle(int id, STBoundary *st_boundary) {
   if (st_boundary == nullptr) {
     return false;
   }
-  if (st_map_.find(id) == st_map_.end()) {
+  auto iter = st_map_.find(id);
+  if (iter == st_map_.end()) {
     return false;
   } else {
-    *st_boundary = st_map_[id];
+    *st_boundary = obstacles_st_boundary_[iter->second];
     return true;
   }
 
@@ -170,7 +290,7 @@ std::vector<STPoint> STGraph::GetObstacleSurroundingPoints(int obstacle_id, doub
   if (st_map_.find(obstacle_id) == st_map_.end()) {
     return pt_pairs;
   }
-  const auto &pt_obstacle = st_map_.at(obstacle_id);
+  const auto &pt_obstacle = obstacles_st_boundary_[st_map_.at(obstacle_id)];
   double relative_time = time_range_.first;
   while (relative_time < time_range_.second + delta_t_) {
     double s_lower, s_upper;
@@ -238,6 +358,9 @@ std::vector<std::vector<std::pair<double, double>>>
 STGraph::GetPathBlockingIntervals(double start_time,
                                   double end_time,
                                   double resolution) const {
+  if (blocking_intervals_.IsOnGrid(start_time, end_time, resolution)) {
+    return blocking_intervals_.GetPathBlockingIntervals();
+  }
   std::vector<std::vector<std::pair<double, double>>> intervals;
   for (double t = start_time; t <= end_time; t += resolution) {
     intervals.push_back(GetPathBlockingIntervals(t));
@@ -0,0 +1,112 @@
+#include "obstacle_manager/st_graph_cache.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "math/math_utils.hpp"
+
+namespace {
+constexpr double kSignatureStep = 5.0;
+constexpr double kPredictionCheckStep = 0.5;
+// older samples are not reused, e.g. after the planner was paused
+constexpr double kMaxTimeOffset = 1.0;
+}
+
+namespace planning {
+using namespace common;
+
+STGraphCache::STGraphCache(double position_tolerance, double heading_tolerance)
+    : position_tolerance_(position_tolerance), heading_tolerance_(heading_tolerance) {}
+
+void STGraphCache::BeginCycle(double timestamp) {
+  time_offset_ = has_timestamp_ ? timestamp - timestamp_ : 0.0;
+  timestamp_ = timestamp;
+  has_timestamp_ = true;
+  std::lock_guard<std::mutex> lock(lines_mutex_);
+  previous_lines_ = std::move(current_lines_);
+  current_lines_.clear();
+  if (time_offset_ < 0.0 || time_offset_ > kMaxTimeOffset) {
+    previous_lines_.clear();
+  }
+}
+
+std::shared_ptr<const STGraphCache::LineCache> STGraphCache::FindLine(const ReferenceLine &ref_line,
+                                                                      double s_start,
+                                                                      double s_end,
+                                                                      double *s_offset) const {
+  s_start = std::max(s_start, 0.0);
+  s_end = std::min(s_end, ref_line.Length());
+  for (const auto &line_cache : previous_lines_) {
+    bool matched = true;
+    size_t num_matched = 0;
+    double first_s = std::numeric_limits<double>::max();
+    double last_s = std::numeric_limits<double>::lowest();
+    for (const auto &sample : line_cache->signature) {
+      SLPoint sl_point;
+      if (!ref_line.XYToSL(sample.second, &sl_point)) {
+        continue;
+      }
+      if (sl_point.s < s_start - kSignatureStep || sl_point.s > s_end + kSignatureStep) {
+        continue;
+      }
+      const double offset = sl_point.s - sample.first;
+      if (std::fabs(sl_point.l) > position_tolerance_
+          || (num_matched > 0 && std::fabs(offset - *s_offset) > position_tolerance_)) {
+        matched = false;
+        break;
+      }
+      if (num_matched == 0) {
+        *s_offset = offset;
+      }
+      ++num_matched;
+      first_s = std::min(first_s, sl_point.s);
+      last_s = std::max(last_s, sl_point.s);
+    }
+    // the cached line has to cover the whole s range of the new one
+    if (matched && num_matched >= 2 && first_s <= s_start + kSignatureStep && last_s >= s_end - kSignatureStep) {
+      return line_cache;
+    }
+  }
+  return nullptr;
+}
+
+void STGraphCache::AddLine(std::shared_ptr<LineCache> line_cache) {
+  std::lock_guard<std::mutex> lock(lines_mutex_);
+  current_lines_.push_back(std::move(line_cache));
+}
+
+void STGraphCache::MakeSignature(const ReferenceLine &ref_line, LineCache *line_cache) {
+  line_cache->signature.clear();
+  const double length = ref_line.Length();
+  for (double s = 0.0; s < length; s += kSignatureStep) {
+    line_cache->signature.emplace_back(s, ref_line.GetReferencePoint(s).xy());
+  }
+  line_cache->signature.emplace_back(length, ref_line.GetReferencePoint(length).xy());
+}
+
+bool STGraphCache::IsPredictionUnchanged(const Obstacle &cached_obstacle,
+                                         const Obstacle &obstacle,
+                                         double end_time) const {
+  if (cached_obstacle.IsStatic() != obstacle.IsStatic()
+      || std::fabs(cached_obstacle.BoundingBox().length() - obstacle.BoundingBox().length()) > position_tolerance_
+      || std::fabs(cached_obstacle.BoundingBox().width() - obstacle.BoundingBox().width()) > position_tolerance_) {
+    return false;
+  }
+  double relative_time = 0.0;
+  while (true) {
+    relative_time = std::min(relative_time, end_time);
+    const auto cached_pose = cached_obstacle.GetPoseAtTime(relative_time + time_offset_);
+    const auto pose = obstacle.GetPoseAtTime(relative_time);
+    if (std::hypot(cached_pose.x - pose.x, cached_pose.y - pose.y) > position_tolerance_) {
+      return false;
+    }
+    if (std::fabs(MathUtils::NormalizeAngle(cached_pose.theta - pose.theta)) > heading_tolerance_) {
+      return false;
+    }
+    if (relative_time >= end_time) {
+      return true;
+    }
+    relative_time += kPredictionCheckStep;
+  }
+}
+
+}
@@ -46,15 +46,24 @@ class ReferenceLine {
    */
   int GetPriority() const { return priority_; }
 
+  /**
+   * @brief: set the smoothed points, one per way point, e.g. the points smoothed by the last reference lines
+   * @param smoothed_points
+   * @return : false if the number of the points does not match
+   */
+  bool SetSmoothedPoints(const std::vector<ReferencePoint> &smoothed_points);
+
   /**
    * @brief: smooth the reference line
+   * @param backend: the solver of the smoothing problem
    * @return : true if smoothing the reference line is successful, false otherwise
    */
   bool Smooth(const double deviation_weight,
               const double heading_weight,
               const double distance_weight,
               const double slack_weight,
-              const double max_curvature);
+              const double max_curvature,
+              ReferenceLineSmoother::Backend backend = ReferenceLineSmoother::Backend::kIpopt);
 
   /**
    * transform the xy to sl point
@@ -73,6 +82,27 @@ class ReferenceLine {
    */
   bool XYToSL(double x, double y, common::SLPoint *sl_point) const;
 
+  /**
+   * @brief: transform the xy to sl point, the projection starts around s_hint, e.g. the s of a nearby point
+   * @param xy
+   * @param s_hint
+   * @param sl_point
+   * @return
+   */
+  bool XYToSL(const Eigen::Vector2d &xy, double s_hint, common::SLPoint *sl_point) const;
+
+  /**
+   * @brief: transform a batch of xy points to sl points, nothing is allocated
+   * @param points: the xy points
+   * @param num_points: the number of points
+   * @param sl_points: the output, must hold num_points sl points
+   * @param ordered: the points are ordered along a path, e.g. the corners of a box or the points of a trajectory,
+   * every projection but the first one starts around the s of the previous point
+   * @return: false if any point failed, sl_points is partly written then
+   */
+  bool XYToSL(const Eigen::Vector2d *points, size_t num_points,
+              common::SLPoint *sl_points, bool ordered = true) const;
+
   /**
    *
    * @param sl_point
@@ -89,12 +119,19 @@ class ReferenceLine {
   common::FrenetFramePoint GetFrenetFramePoint(const planning_msgs::PathPoint &path_point) const;
 
   /**
-   * get reference point according s
+   * get reference point according s, interpolated on the reference point table
    * @param s
    * @return
    */
   ReferencePoint GetReferencePoint(double s) const;
 
+  /**
+   * @brief: get reference point according s, evaluated on the spline directly, the reference of the table
+   * @param s
+   * @return
+   */
+  ReferencePoint GetExactReferencePoint(double s) const;
+
   /**
    * get the projection reference point in reference line
    * @param x
@@ -147,6 +184,15 @@ class ReferenceLine {
    */
   bool GetSLBoundary(const common::Box2d &box, common::SLBoundary *sl_boundary) const;
 
+  /**
+   * @brief : build object sl boundary without heap allocation if with_boundary_points is false
+   * @param box : the object's bounding box
+   * @param sl_boundary : the output sl_boundary
+   * @param with_boundary_points : false to fill the start/end s and l only, the boundary_points are cleared
+   * @return : false if build sl_boundary failed, true otherwise
+   */
+  bool GetSLBoundary(const common::Box2d &box, common::SLBoundary *sl_boundary, bool with_boundary_points) const;
+
   /**
    * @brief : check the reference line is smoothed or not
    * @return : true if the reference line is smoothed, false otherwise
@@ -171,6 +217,11 @@ class ReferenceLine {
                                     double s1,
                                     double s);
   const std::vector<planning_msgs::WayPoint> &way_points() const { return way_points_; }
+
+  /**
+   * @brief: the points of the way points, not smoothed
+   */
+  const std::vector<ReferencePoint> &reference_points() const { return reference_points_; }
   bool CanChangeLeft(double s) const;
   bool CanChangeRight(double s) const;
 
@@ -213,6 +264,23 @@ class ReferenceLine {
   planning_msgs::WayPoint NearestWayPoint(double s) const;
 
   bool BuildReferenceLineWithSpline();
+
+  /**
+   * @brief: the sl point of xy from its nearest point on the spline
+   * @param xy
+   * @param nearest_x
+   * @param nearest_y
+   * @param nearest_s
+   * @param sl_point
+   */
+  void NearestPointToSL(const Eigen::Vector2d &xy, double nearest_x, double nearest_y, double nearest_s,
+                        common::SLPoint *sl_point) const;
+
+  /**
+   * @brief: sample the spline every kReferencePointTableResolution meters, must be rebuilt
+   * whenever the spline changes
+   */
+  void BuildReferencePointTable();
   /**
    *
    * @param start
@@ -235,6 +303,9 @@ class ReferenceLine {
   std::shared_ptr<common::Spline2d> left_boundary_spline_;
   std::shared_ptr<common::Spline2d> right_boundary_spline_;
   std::shared_ptr<ReferenceLineSmoother> reference_smoother_;
+  // reference points at s = 0, ds, 2 * ds ... and at length_, shared by the copies
+  static constexpr double kReferencePointTableResolution = 0.1;
+  std::shared_ptr<const std::vector<ReferencePoint>> reference_point_table_;
   int priority_ = 0;
 };
 
@@ -1,45 +1,190 @@
 #ifndef CATKIN_WS_SRC_LOCAL_PLANNER_INCLUDE_REFERENCE_LINE_REFERENCE_LINE_SMOOTH_IPOPT_INTERFACE_HPP_
 #define CATKIN_WS_SRC_LOCAL_PLANNER_INCLUDE_REFERENCE_LINE_REFERENCE_LINE_SMOOTH_IPOPT_INTERFACE_HPP_
-#include <cppad/ipopt/solve.hpp>
-#include <string>
-#include "reference_line.hpp"
+#include <cppad/cppad.hpp>
+#include <coin/IpTNLP.hpp>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
 
 namespace planning {
-class ReferenceLineSmoothIpoptInterface {
- public:
 
+/**
+ * @brief: the reference line smoothing problem for IPOPT. the derivatives come from a CppAD tape which depends only
+ * on the number of points, so a tape and its sparsity patterns are recorded once and reused by every problem of that
+ * size: a solve only evaluates the tape.
+ */
+class ReferenceLineSmoothIpoptInterface : public Ipopt::TNLP {
+ public:
   typedef CPPAD_TESTVECTOR(CppAD::AD<double>) ADvector;
-  explicit ReferenceLineSmoothIpoptInterface(const std::vector<std::pair<double, double>> &ref_points);
-  ~ReferenceLineSmoothIpoptInterface() = default;
-  void operator()(ADvector &fg, const ADvector &x);
+
+  /**
+   * @brief: the recorded problem of a number of points. the range of the tape is the unweighted costs, then the
+   * curvature constraints. the deviation cost on the tape is the squared norm of the points, its part linear in the
+   * reference points is added by the interface.
+   */
+  struct Tape {
+    size_t num_of_points = 0;
+    size_t num_of_variables = 0;
+    size_t num_of_constraints = 0;
+    CppAD::ADFun<double> fun;
+    // the jacobian of the constraints, by range index
+    std::vector<size_t> jacobian_rows;
+    std::vector<size_t> jacobian_cols;
+    std::vector<std::set<size_t>> jacobian_pattern;
+    CppAD::sparse_jacobian_work jacobian_work;
+    // the lower triangle of the hessian of the lagrangian
+    std::vector<size_t> hessian_rows;
+    std::vector<size_t> hessian_cols;
+    std::vector<std::set<size_t>> hessian_pattern;
+    CppAD::sparse_hessian_work hessian_work;
+  };
+
+  // the costs at the beginning of the tape range
+  enum CostIndex {
+    kDeviationCost = 0,
+    kHeadingCost,
+    kLengthCost,
+    kSlackCost,
+    kNumOfCosts
+  };
+
+  ReferenceLineSmoothIpoptInterface() = default;
+  ~ReferenceLineSmoothIpoptInterface() override = default;
+
+  /**
+   * @brief: record the tape of a number of points and its sparsity patterns
+   * @param num_of_points: at least three points
+   * @return
+   */
+  static std::shared_ptr<Tape> RecordTape(size_t num_of_points);
+
+  /**
+   * @brief: set up the problem of the points on the tape of their number
+   * @param tape
+   * @param ref_points
+   */
+  void SetUp(const std::shared_ptr<Tape> &tape, const std::vector<std::pair<double, double>> &ref_points);
+
   void set_ref_deviation_weight(double weight) { this->ref_deviation_weight_ = weight; }
-  void set_curvature_weight(double weight) { this->curvature_weight_ = weight; }
   void set_length_weight(double weight) { this->length_weight_ = weight; }
   void set_heading_weight(double weight) { this->heading_weight_ = weight; }
   void set_slack_weight(double weight) { this->slack_weight_ = weight; }
+  void set_variable_bounds(const std::vector<double> &lower_bounds, const std::vector<double> &upper_bounds) {
+    variable_lower_bounds_ = lower_bounds;
+    variable_upper_bounds_ = upper_bounds;
+  }
+  void set_constraint_bounds(const std::vector<double> &lower_bounds, const std::vector<double> &upper_bounds) {
+    constraint_lower_bounds_ = lower_bounds;
+    constraint_upper_bounds_ = upper_bounds;
+  }
+  void set_initial_values(const std::vector<double> &initial_values) { initial_values_ = initial_values; }
+
+  /**
+   * @brief: whether the last solve succeeded
+   */
+  bool solved() const { return solved_; }
+  const std::vector<double> &solution() const { return solution_; }
+
+  bool get_nlp_info(Ipopt::Index &n,
+                    Ipopt::Index &m,
+                    Ipopt::Index &nnz_jac_g,
+                    Ipopt::Index &nnz_h_lag,
+                    IndexStyleEnum &index_style) override;
+
+  bool get_bounds_info(Ipopt::Index n,
+                       Ipopt::Number *x_l,
+                       Ipopt::Number *x_u,
+                       Ipopt::Index m,
+                       Ipopt::Number *g_l,
+                       Ipopt::Number *g_u) override;
+
+  bool get_starting_point(Ipopt::Index n,
+                          bool init_x,
+                          Ipopt::Number *x,
+                          bool init_z,
+                          Ipopt::Number *z_L,
+                          Ipopt::Number *z_U,
+                          Ipopt::Index m,
+                          bool init_lambda,
+                          Ipopt::Number *lambda) override;
+
+  bool eval_f(Ipopt::Index n, const Ipopt::Number *x, bool new_x, Ipopt::Number &obj_value) override;
+
+  bool eval_grad_f(Ipopt::Index n, const Ipopt::Number *x, bool new_x, Ipopt::Number *grad_f) override;
+
+  bool eval_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x, Ipopt::Index m, Ipopt::Number *g) override;
+
+  bool eval_jac_g(Ipopt::Index n,
+                  const Ipopt::Number *x,
+                  bool new_x,
+                  Ipopt::Index m,
+                  Ipopt::Index nele_jac,
+                  Ipopt::Index *iRow,
+                  Ipopt::Index *jCol,
+                  Ipopt::Number *values) override;
+
+  bool eval_h(Ipopt::Index n,
+              const Ipopt::Number *x,
+              bool new_x,
+              Ipopt::Number obj_factor,
+              Ipopt::Index m,
+              const Ipopt::Number *lambda,
+              bool new_lambda,
+              Ipopt::Index nele_hess,
+              Ipopt::Index *iRow,
+              Ipopt::Index *jCol,
+              Ipopt::Number *values) override;
+
+  void finalize_solution(Ipopt::SolverReturn status,
+                         Ipopt::Index n,
+                         const Ipopt::Number *x,
+                         const Ipopt::Number *z_L,
+                         const Ipopt::Number *z_U,
+                         Ipopt::Index m,
+                         const Ipopt::Number *g,
+                         const Ipopt::Number *lambda,
+                         Ipopt::Number obj_value,
+                         const Ipopt::IpoptData *ip_data,
+                         Ipopt::IpoptCalculatedQuantities *ip_cq) override;
 
  private:
-  std::vector<std::pair<double, double>> ref_points_;
+  /**
+   * @brief: the costs and the constraints on the tape
+   */
+  static void EvaluateTape(size_t num_of_points, const ADvector &x, ADvector *fg);
+
+  /**
+   * @brief: the zero order forward sweep of the tape at x, if x is new
+   */
+  void UpdateRangeValues(const Ipopt::Number *x, bool new_x);
+
+  void SetVariables(const Ipopt::Number *x);
+
+ private:
+  std::shared_ptr<Tape> tape_;
+  // x0, y0, x1, y1, ... and their squared norm
+  std::vector<double> ref_xy_;
+  double ref_squared_norm_ = 0.0;
   double ref_deviation_weight_{};
-  double curvature_weight_{};
   double length_weight_{};
   double heading_weight_{};
-  double max_curvature_{};
   double slack_weight_{};
-  size_t num_of_points_{};
-  size_t num_of_slack_variable_{};
-  size_t num_of_variables_{};
-  size_t num_curvature_constraint_{};
-  size_t slack_variable_start_index_{};
-  size_t slack_variable_end_index_{};
-
-  size_t num_of_slack_constr_{};
-  size_t num_of_constraint_{};
-  size_t curvature_constraint_start_index_{};
-  size_t curvature_constraint_end_index_{};
-  size_t slack_constraint_start_index_{};
-  size_t slack_constraint_end_index_{};
-
+  std::vector<double> variable_lower_bounds_;
+  std::vector<double> variable_upper_bounds_;
+  std::vector<double> constraint_lower_bounds_;
+  std::vector<double> constraint_upper_bounds_;
+  std::vector<double> initial_values_;
+  bool solved_ = false;
+  std::vector<double> solution_;
+  // the buffers of the tape evaluations
+  std::vector<double> variables_;
+  std::vector<double> range_values_;
+  bool range_values_valid_ = false;
+  std::vector<double> range_weights_;
+  std::vector<double> gradient_;
+  std::vector<double> jacobian_values_;
+  std::vector<double> hessian_values_;
 };
 
 }
@@ -1,16 +1,27 @@
 #ifndef CATKIN_WS_SRC_LOCAL_PLANNER_INCLUDE_REFERENCE_LINE_REFERENCE_LINE_SMOOTHER_HPP_
 #define CATKIN_WS_SRC_LOCAL_PLANNER_INCLUDE_REFERENCE_LINE_REFERENCE_LINE_SMOOTHER_HPP_
 #include "math/math_utils.hpp"
-#include <cppad/ipopt/solve.hpp>
+#include <map>
+#include <memory>
+#include <coin/IpIpoptApplication.hpp>
 #include <glog/logging.h>
 #include "reference_point.hpp"
 #include <planning_msgs/WayPoint.h>
+#include "reference_line_smooth_ipopt_interface.hpp"
+#include "reference_line_sqp_smoother.hpp"
 
 namespace planning {
 class ReferenceLineSmoother {
  public:
   typedef CPPAD_TESTVECTOR(CppAD::AD<double>) ADVector;
-  typedef CPPAD_TESTVECTOR(double) DVector;
+  typedef std::vector<double> DVector;
+  enum class Backend {
+    // CppAD and IPOPT on the full problem
+    kIpopt,
+    // ReferenceLineSqpSmoother, a sequential QP on the banded structure of the problem. IPOPT takes over the
+    // problems it does not solve within its iteration budget
+    kBandedSqp
+  };
   ReferenceLineSmoother() = default;
   ~ReferenceLineSmoother() = default;
   ReferenceLineSmoother(double deviation_weight,
@@ -23,6 +34,17 @@ class ReferenceLineSmoother {
   bool SmoothReferenceLine(const std::vector<ReferencePoint> &raw_points,
                            std::vector<ReferencePoint> *smoothed_ref_points);
 
+  /**
+   * @brief: smooth the points with the first ones held fixed, e.g. the smoothed points before them
+   * @param raw_points
+   * @param num_of_fixed_points: the number of the first points which are not moved
+   * @param smoothed_ref_points
+   * @return
+   */
+  bool SmoothReferenceLine(const std::vector<ReferencePoint> &raw_points,
+                           size_t num_of_fixed_points,
+                           std::vector<ReferencePoint> *smoothed_ref_points);
+
 //    bool GetSmoothReferenceLine(const ReferenceLine &raw_ref_line,
 //                                ReferenceLine *smoothed_ref_line);
   void SetSmoothParams(double deviation_weight,
@@ -30,17 +52,41 @@ class ReferenceLineSmoother {
                        double heading_weight,
                        double slack_weight,
                        double max_curvature);
+
+  /**
+   * @brief: the backend of a name: ipopt or banded_sqp
+   * @param name
+   * @param backend
+   * @return: false if there is no such backend
+   */
+  static bool GetBackend(const std::string &name, Backend *backend);
+  void SetBackend(Backend backend) { backend_ = backend; }
+  Backend backend() const { return backend_; }
+
  private:
   bool SetUpConstraint();
   void SetUpOptions();
   void SetUpInitValue();
-  bool TraceSmoothReferenceLine(
-      const CppAD::ipopt::solve_result<DVector> &result,
-      std::vector<ReferencePoint> *smoothed_ref_line) const;
+  /**
+   * @brief: the recorded problem of the current number of points, recorded on its first use
+   */
+  std::shared_ptr<ReferenceLineSmoothIpoptInterface::Tape> GetIpoptTape();
+  bool SmoothByIpopt(const std::vector<std::pair<double, double>> &xy,
+                     std::vector<ReferencePoint> *smoothed_ref_points);
+  bool TraceSmoothReferenceLine(const std::vector<double> &result,
+                                std::vector<ReferencePoint> *smoothed_ref_line) const;
+  bool SmoothByBandedSqp(const std::vector<std::pair<double, double>> &xy,
+                         std::vector<ReferencePoint> *smoothed_ref_points);
 
  private:
+  Backend backend_ = Backend::kIpopt;
+  ReferenceLineSqpSmoother sqp_smoother_;
+  // the number of points of the reference lines hardly changes, so their problems are recorded once
+  static constexpr size_t kMaxNumOfIpoptTapes = 8;
+  std::map<size_t, std::shared_ptr<ReferenceLineSmoothIpoptInterface::Tape>> ipopt_tapes_;
+  Ipopt::SmartPtr<ReferenceLineSmoothIpoptInterface> ipopt_interface_;
+  Ipopt::SmartPtr<Ipopt::IpoptApplication> ipopt_app_;
   std::vector<ReferencePoint> ref_points_;
-  std::string options_;
   DVector x_l_;
   DVector x_u_;
   DVector g_l_;
@@ -51,7 +97,10 @@ class ReferenceLineSmoother {
   double distance_weight_ = 1.0;
   double max_curvature_ = 5.0;
   double slack_weight_ = 5.0;
+  // the bound of the second differences, the curvature bound scaled by the squared average point distance
+  double max_second_difference_ = 0.0;
   size_t num_of_points_{};
+  size_t num_of_fixed_points_{};
   size_t slack_variable_start_index_{};
   size_t num_of_slack_variable_{};
   size_t slack_variable_end_index_{};
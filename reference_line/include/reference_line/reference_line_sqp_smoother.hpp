@@ -0,0 +1,135 @@
+#ifndef CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_REFERENCE_LINE_INCLUDE_REFERENCE_LINE_REFERENCE_LINE_SQP_SMOOTHER_HPP_
+#define CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_REFERENCE_LINE_INCLUDE_REFERENCE_LINE_REFERENCE_LINE_SQP_SMOOTHER_HPP_
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace planning {
+
+/**
+ * @brief: the reference line smoothing problem of ReferenceLineSmoothIpoptInterface, solved without automatic
+ * differentiation. the cost is quadratic in the point offsets and every constraint couples at most three
+ * consecutive points, so with the offsets ordered x0, y0, x1, y1, ... every matrix is banded. the second
+ * difference constraints are linearized around the iterates (sequential QP), each QP is solved by ADMM on
+ * a banded Cholesky factorization, then polished on its active set.
+ */
+class ReferenceLineSqpSmoother {
+ public:
+  ReferenceLineSqpSmoother() = default;
+  ~ReferenceLineSqpSmoother() = default;
+
+  void set_ref_deviation_weight(double weight) { this->ref_deviation_weight_ = weight; }
+  void set_length_weight(double weight) { this->length_weight_ = weight; }
+  void set_heading_weight(double weight) { this->heading_weight_ = weight; }
+
+  /**
+   * @brief: smooth the points
+   * @param ref_points: at least three points
+   * @param lower_bounds: the lower bounds of x0, y0, x1, y1, ...
+   * @param upper_bounds: the upper bounds of x0, y0, x1, y1, ..., a variable of equal bounds is fixed
+   * @param max_second_difference: the max norm of p[i] - 2 * p[i + 1] + p[i + 2]
+   * @param smoothed_points
+   * @return: false if the problem is infeasible or not solved within the iteration budget
+   */
+  bool Solve(const std::vector<std::pair<double, double>> &ref_points,
+             const std::vector<double> &lower_bounds,
+             const std::vector<double> &upper_bounds,
+             double max_second_difference,
+             std::vector<std::pair<double, double>> *smoothed_points);
+
+ private:
+  // the half bandwidth of the cost matrix plus the linearized constraints
+  static constexpr size_t kBandwidth = 5;
+
+  /**
+   * @brief: a symmetric positive definite band matrix, its lower band by row
+   */
+  struct BandMatrix {
+    size_t size = 0;
+    std::vector<double> values;
+    void Resize(size_t matrix_size);
+    double &At(size_t row, size_t col) { return values[row * (kBandwidth + 1) + row - col]; }
+    double At(size_t row, size_t col) const { return values[row * (kBandwidth + 1) + row - col]; }
+    void Multiply(const std::vector<double> &x, std::vector<double> *y) const;
+    /**
+     * @brief: the in place Cholesky factorization, the lower factor replaces the band
+     * @return: false if the matrix is not positive definite
+     */
+    bool Factorize();
+    /**
+     * @brief: solve with the factorized matrix, in place
+     */
+    void Solve(std::vector<double> *x) const;
+  };
+
+  /**
+   * @brief: a linearized second difference constraint, row . (d[i] - 2 d[i + 1] + d[i + 2]) <= upper
+   */
+  struct CurvatureRow {
+    size_t index = 0;
+    double row_x = 0.0;
+    double row_y = 0.0;
+    double upper = 0.0;
+  };
+
+  void SetUpCost();
+
+  /**
+   * @brief: the linearized constraints of the second differences close to the bound at the offsets
+   */
+  void LinearizeCurvatureConstraints(const std::vector<double> &offsets);
+
+  /**
+   * @brief: the QP of the current constraints, offsets is the initial guess and the solution
+   * @return: false if it is not solved
+   */
+  bool SolveQp(std::vector<double> *offsets);
+
+  /**
+   * @brief: the exact solution with the box constraints of active fixed to their bounds, 0 not active, -1 at the
+   * lower bound and 1 at the upper bound
+   * @return: false if it violates a constraint or its multipliers
+   */
+  bool Polish(const std::vector<int> &active, std::vector<double> *offsets);
+
+  bool IsFeasible(const std::vector<double> &offsets, double tolerance) const;
+
+  bool IsFixed(size_t index) const { return lower_bounds_[index] == upper_bounds_[index]; }
+
+  double MaxCurvatureViolation(const std::vector<double> &offsets) const;
+
+  /**
+   * @brief: y = A * x, A the box rows then the curvature rows
+   */
+  void MultiplyConstraints(const std::vector<double> &x, std::vector<double> *y) const;
+
+  /**
+   * @brief: x = A^T * y
+   */
+  void MultiplyConstraintsTransposed(const std::vector<double> &y, std::vector<double> *x) const;
+
+  /**
+   * @brief: the band of P + sigma * I + rho * A^T * A
+   */
+  void SetUpKktMatrix(double sigma, double rho, BandMatrix *matrix) const;
+
+ private:
+  double ref_deviation_weight_ = 0.0;
+  double length_weight_ = 0.0;
+  double heading_weight_ = 0.0;
+  size_t num_of_points_ = 0;
+  size_t num_of_variables_ = 0;
+  double max_second_difference_ = 0.0;
+  std::vector<std::pair<double, double>> ref_points_;
+  // the offsets from the reference points, their bounds and the cost 0.5 * d^T * P * d + q^T * d
+  std::vector<double> lower_bounds_;
+  std::vector<double> upper_bounds_;
+  BandMatrix cost_matrix_;
+  std::vector<double> cost_vector_;
+  std::vector<CurvatureRow> curvature_rows_;
+  // the ADMM iterations of all the QPs of the current solve
+  size_t num_of_admm_iterations_ = 0;
+};
+
+}
+#endif //CATKIN_WS_SRC_MOTION_PLANNING_WITH_CARLA_REFERENCE_LINE_INCLUDE_REFERENCE_LINE_REFERENCE_LINE_SQP_SMOOTHER_HPP_
@@ -1,12 +1,16 @@
 #include <ros/ros.h>
 #include <tf/transform_datatypes.h>
 #include <Eigen/Core>
+#include <array>
 #include "reference_line/reference_line.hpp"
 #include "math/math_utils.hpp"
 #include "math/coordinate_transformer.hpp"
 
 namespace planning {
 using namespace common;
+
+constexpr double ReferenceLine::kReferencePointTableResolution;
+
 ReferenceLine::ReferenceLine(const std::vector<planning_msgs::WayPoint> &waypoints)
     : way_points_(waypoints) {
   ROS_ASSERT(waypoints.size() >= 3);
@@ -49,6 +53,7 @@ ReferenceLine::ReferenceLine(const std::vector<planning_msgs::WayPoint> &waypoin
   bool result = BuildReferenceLineWithSpline();
   ROS_ASSERT(result);
   length_ = ref_line_spline_->ArcLength();
+  BuildReferencePointTable();
   ROS_INFO("ReferenceLine's length : %lf", length_);
 }
 
@@ -79,6 +84,25 @@ FrenetFramePoint ReferenceLine::GetFrenetFramePoint(
 }
 
 ReferencePoint ReferenceLine::GetReferencePoint(double s) const {
+  if (reference_point_table_ == nullptr || reference_point_table_->size() < 2) {
+    return GetExactReferencePoint(s);
+  }
+  const auto &table = *reference_point_table_;
+  // the spline is clamped at both ends
+  if (s <= 0.0) {
+    return table.front();
+  }
+  if (s >= length_) {
+    return table.back();
+  }
+  const auto index = std::min(static_cast<size_t>(s / kReferencePointTableResolution), table.size() - 2);
+  const double s0 = static_cast<double>(index) * kReferencePointTableResolution;
+  const double s1 = index + 2 == table.size() ? length_
+                                              : static_cast<double>(index + 1) * kReferencePointTableResolution;
+  return Interpolate(table[index], table[index + 1], s0, s1, s);
+}
+
+ReferencePoint ReferenceLine::GetExactReferencePoint(double s) const {
   double ref_x, ref_y;
   double ref_dx, ref_dy;
   double ref_ddx, ref_ddy;
@@ -169,56 +193,56 @@ bool ReferenceLine::IsOnLane(const SLBoundary &sl_boundary) const {
 }
 
 bool ReferenceLine::GetSLBoundary(const Box2d &box, SLBoundary *sl_boundary) const {
+  return GetSLBoundary(box, sl_boundary, true);
+}
+
+bool ReferenceLine::GetSLBoundary(const Box2d &box, SLBoundary *sl_boundary, bool with_boundary_points) const {
+  // the corners and the edge midpoints, counter-clockwise: corner0, mid01, corner1, mid12 ...
+  // projected as one ordered batch, each point starts from the s of the previous one
+  constexpr size_t kNumCorners = 4;
+  std::array<Eigen::Vector2d, 2 * kNumCorners> points;
+  for (size_t i = 0; i < kNumCorners; ++i) {
+    const auto &p0 = box.GetCorner(i);
+    const auto &p1 = box.GetCorner((i + 1) % kNumCorners);
+    points[2 * i] = p0;
+    points[2 * i + 1] = (p0 + p1) * 0.5;
+  }
+  std::array<SLPoint, 2 * kNumCorners> sl_points;
+  if (!XYToSL(points.data(), points.size(), sl_points.data(), true)) {
+    return false;
+  }
 
   double start_s(std::numeric_limits<double>::max());
   double end_s(std::numeric_limits<double>::lowest());
   double start_l(std::numeric_limits<double>::max());
   double end_l(std::numeric_limits<double>::lowest());
-  std::vector<Eigen::Vector2d> corners = box.GetAllCorners();
-  // The order must be counter-clockwise
-  std::vector<SLPoint> sl_corners;
-  for (const auto &point : corners) {
-    SLPoint sl_point;
-    if (!XYToSL(point, &sl_point)) {
-      return false;
-    }
-    sl_corners.push_back(std::move(sl_point));
-  }
-
-  for (size_t i = 0; i < corners.size(); ++i) {
-    auto index0 = i;
-    auto index1 = (i + 1) % corners.size();
-    const auto &p0 = corners[index0];
-    const auto &p1 = corners[index1];
-
-    const auto p_mid = (p0 + p1) * 0.5;
-    SLPoint sl_point_mid;
-    if (!XYToSL(p_mid, &sl_point_mid)) {
-      return false;
+  sl_boundary->boundary_points.clear();
+  auto add_boundary_point = [&](const SLPoint &sl_point) {
+    start_s = std::fmin(start_s, sl_point.s);
+    end_s = std::fmax(end_s, sl_point.s);
+    start_l = std::fmin(start_l, sl_point.l);
+    end_l = std::fmax(end_l, sl_point.l);
+    if (with_boundary_points) {
+      sl_boundary->boundary_points.push_back(sl_point);
     }
+  };
+  for (size_t i = 0; i < kNumCorners; ++i) {
+    const auto &sl_corner0 = sl_points[2 * i];
+    const auto &sl_point_mid = sl_points[2 * i + 1];
+    const auto &sl_corner1 = sl_points[(2 * i + 2) % sl_points.size()];
 
-    Eigen::Vector2d v0(sl_corners[index1].s - sl_corners[index0].s,
-                       sl_corners[index1].l - sl_corners[index0].l);
-
-    Eigen::Vector2d v1(sl_point_mid.s - sl_corners[index0].s,
-                       sl_point_mid.l - sl_corners[index0].l);
+    Eigen::Vector2d v0(sl_corner1.s - sl_corner0.s, sl_corner1.l - sl_corner0.l);
+    Eigen::Vector2d v1(sl_point_mid.s - sl_corner0.s, sl_point_mid.l - sl_corner0.l);
 
-    sl_boundary->boundary_points.push_back(sl_corners[index0]);
+    add_boundary_point(sl_corner0);
 
     // sl_point is outside of polygon; add to the vertex list
     double cross_prod = v0.x() * v1.y() - v0.y() * v1.x();
     if (cross_prod < 0.0) {
-      sl_boundary->boundary_points.push_back(sl_point_mid);
+      add_boundary_point(sl_point_mid);
     }
   }
 
-  for (const auto &sl_point : sl_boundary->boundary_points) {
-    start_s = std::fmin(start_s, sl_point.s);
-    end_s = std::fmax(end_s, sl_point.s);
-    start_l = std::fmin(start_l, sl_point.l);
-    end_l = std::fmax(end_l, sl_point.l);
-  }
-
   sl_boundary->start_s = start_s;
   sl_boundary->end_s = end_s;
   sl_boundary->start_l = start_l;
@@ -250,6 +274,35 @@ bool ReferenceLine::XYToSL(const Eigen::Vector2d &xy, SLPoint *sl_point) const {
     ROS_FATAL("[ReferenceLine::XYToSL], Failed to Get NearestPointOnSpline {x: %lf, y:%lf}", xy(0), xy(1));
     return false;
   }
+  NearestPointToSL(xy, nearest_x, nearest_y, nearest_s, sl_point);
+  return true;
+}
+
+bool ReferenceLine::XYToSL(const Eigen::Vector2d &xy, double s_hint, SLPoint *sl_point) const {
+  double nearest_x, nearest_y, nearest_s;
+  if (!ref_line_spline_->GetNearestPointOnSpline(
+      xy(0), xy(1), s_hint, &nearest_x, &nearest_y, &nearest_s)) {
+    ROS_FATAL("[ReferenceLine::XYToSL], Failed to Get NearestPointOnSpline {x: %lf, y:%lf}", xy(0), xy(1));
+    return false;
+  }
+  NearestPointToSL(xy, nearest_x, nearest_y, nearest_s, sl_point);
+  return true;
+}
+
+bool ReferenceLine::XYToSL(const Eigen::Vector2d *points, size_t num_points,
+                           SLPoint *sl_points, bool ordered) const {
+  for (size_t i = 0; i < num_points; ++i) {
+    bool result = (!ordered || i == 0) ? XYToSL(points[i], &sl_points[i])
+                                       : XYToSL(points[i], sl_points[i - 1].s, &sl_points[i]);
+    if (!result) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ReferenceLine::NearestPointToSL(const Eigen::Vector2d &xy, double nearest_x, double nearest_y,
+                                     double nearest_s, SLPoint *sl_point) const {
   double x_der, y_der;
   Eigen::Vector2d heading;
 //  ref_line_spline_->EvaluateFirstDerivative(nearest_s, &x_der, &y_der);
@@ -287,8 +340,6 @@ bool ReferenceLine::XYToSL(const Eigen::Vector2d &xy, SLPoint *sl_point) const {
                                           xy(1) - nearest_y);
     }
   }
-  return true;
-
 }
 
 bool ReferenceLine::XYToSL(double x, double y, SLPoint *sl_point) const {
@@ -395,10 +446,12 @@ bool ReferenceLine::Smooth(const double deviation_weight,
                            const double heading_weight,
                            const double distance_weight,
                            const double slack_weight,
-                           const double max_curvature) {
+                           const double max_curvature,
+                           ReferenceLineSmoother::Backend backend) {
   const auto way_points = way_points_;
   std::vector<ReferencePoint> ref_point;
   reference_smoother_->SetSmoothParams(deviation_weight, distance_weight, heading_weight, slack_weight, max_curvature);
+  reference_smoother_->SetBackend(backend);
   bool result = reference_smoother_->SmoothReferenceLine(reference_points_, &ref_point);
   if (reference_points_.size() != ref_point.size()) {
     return false;
@@ -407,19 +460,41 @@ bool ReferenceLine::Smooth(const double deviation_weight,
     smoothed_ = false;
     return false;
   }
+  return SetSmoothedPoints(ref_point);
+}
+
+bool ReferenceLine::SetSmoothedPoints(const std::vector<ReferencePoint> &smoothed_points) {
+  if (reference_points_.size() != smoothed_points.size()) {
+    return false;
+  }
   smoothed_ = true;
   std::vector<double> xs, ys;
-  xs.reserve(ref_point.size());
-  ys.reserve(ref_point.size());
-  for (auto &reference_point : ref_point) {
+  xs.reserve(smoothed_points.size());
+  ys.reserve(smoothed_points.size());
+  for (auto &reference_point : smoothed_points) {
     xs.push_back(reference_point.x());
     ys.push_back(reference_point.y());
   }
   ref_line_spline_.reset(new Spline2d(xs, ys));
   length_ = ref_line_spline_->ArcLength();
+  BuildReferencePointTable();
   return true;
 }
 
+void ReferenceLine::BuildReferencePointTable() {
+  auto table = std::make_shared<std::vector<ReferencePoint>>();
+  table->reserve(static_cast<size_t>(length_ / kReferencePointTableResolution) + 2);
+  for (size_t i = 0;; ++i) {
+    const double s = static_cast<double>(i) * kReferencePointTableResolution;
+    if (s >= length_) {
+      break;
+    }
+    table->push_back(GetExactReferencePoint(s));
+  }
+  table->push_back(GetExactReferencePoint(length_));
+  reference_point_table_ = table;
+}
+
 double ReferenceLine::GetDrivingWidth(const SLBoundary &sl_boundary) const {
   double lane_left_width = 0.0;
   double lane_right_width = 0.0;
@@ -485,6 +560,7 @@ ReferenceLine::ReferenceLine(const ReferenceLine &other) {
   left_boundary_spline_ = other.left_boundary_spline_;
   right_boundary_spline_ = other.right_boundary_spline_;
   reference_smoother_ = other.reference_smoother_;
+  reference_point_table_ = other.reference_point_table_;
   priority_ = other.priority_;
 }
 
@@ -512,7 +588,7 @@ bool ReferenceLine::CanChangeRight(double s) const {
 
 bool ReferenceLine::IsBlockedByBox(const Box2d &box, double ego_width, double buffer) const {
   common::SLBoundary sl_boundary;
-  if (!this->GetSLBoundary(box, &sl_boundary)) {
+  if (!this->GetSLBoundary(box, &sl_boundary, false)) {
     return true;
   }
   if (!IsOnLane(sl_boundary)) {
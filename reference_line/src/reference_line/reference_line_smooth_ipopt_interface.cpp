@@ -4,82 +4,299 @@
 
 namespace planning {
 
-void ReferenceLineSmoothIpoptInterface::operator()(
-    ReferenceLineSmoothIpoptInterface::ADvector &fg,
-    const ReferenceLineSmoothIpoptInterface::ADvector &x) {
-//  size_t point_num = ref_points_.size();
-  assert(x.size() == num_of_variables_);
-//  assert(fg.size() == 1);
-  assert(fg.size() == num_of_constraint_ + 1);
-  fg[0] = 0.0;
-  // deviation from origin reference line
-  for (size_t i = 0; i < num_of_points_; ++i) {
+std::shared_ptr<ReferenceLineSmoothIpoptInterface::Tape> ReferenceLineSmoothIpoptInterface::RecordTape(
+    size_t num_of_points) {
+  assert(num_of_points >= 3);
+  auto tape = std::make_shared<Tape>();
+  tape->num_of_points = num_of_points;
+  tape->num_of_variables = num_of_points * 2 + num_of_points - 2;
+  tape->num_of_constraints = num_of_points - 2;
+  const size_t num_of_variables = tape->num_of_variables;
+  const size_t range_size = kNumOfCosts + tape->num_of_constraints;
+
+  // the values of the independent variables do not change the operations
+  ADvector x(num_of_variables);
+  for (size_t i = 0; i < num_of_variables; ++i) {
+    x[i] = 0.0;
+  }
+  CppAD::Independent(x);
+  ADvector fg(range_size);
+  EvaluateTape(num_of_points, x, &fg);
+  tape->fun.Dependent(x, fg);
+  tape->fun.optimize();
+
+  std::vector<std::set<size_t>> identity(num_of_variables);
+  for (size_t i = 0; i < num_of_variables; ++i) {
+    identity[i].insert(i);
+  }
+  const auto range_pattern = tape->fun.ForSparseJac(num_of_variables, identity);
+  tape->jacobian_pattern = range_pattern;
+  for (size_t i = kNumOfCosts; i < range_size; ++i) {
+    for (const auto col : range_pattern[i]) {
+      tape->jacobian_rows.push_back(i);
+      tape->jacobian_cols.push_back(col);
+    }
+  }
+  std::vector<std::set<size_t>> range_set(1);
+  for (size_t i = 0; i < range_size; ++i) {
+    range_set[0].insert(i);
+  }
+  tape->hessian_pattern = tape->fun.RevSparseHes(num_of_variables, range_set);
+  for (size_t i = 0; i < num_of_variables; ++i) {
+    for (const auto col : tape->hessian_pattern[i]) {
+      if (col <= i) {
+        tape->hessian_rows.push_back(i);
+        tape->hessian_cols.push_back(col);
+      }
+    }
+  }
+  // the forward sparsity patterns are not used anymore
+  tape->fun.size_forward_set(0);
+  return tape;
+}
+
+void ReferenceLineSmoothIpoptInterface::EvaluateTape(size_t num_of_points, const ADvector &x, ADvector *fg) {
+  const size_t slack_variable_start_index = num_of_points * 2;
+  const size_t slack_variable_end_index = slack_variable_start_index + num_of_points - 2;
+  auto &costs = *fg;
+  for (size_t i = 0; i < kNumOfCosts; ++i) {
+    costs[i] = 0.0;
+  }
+  // deviation from origin reference line, without the reference points
+  for (size_t i = 0; i < num_of_points; ++i) {
     size_t index = i * 2;
-    fg[0] += ref_deviation_weight_ * ((x[index] - ref_points_[i].first) * (x[index] - ref_points_[i].first)
-        + (x[index + 1] - ref_points_[i].second) * (x[index + 1] - ref_points_[i].second));
+    costs[kDeviationCost] += x[index] * x[index] + x[index + 1] * x[index + 1];
   }
   // the theta error cost;
-  for (size_t i = 0; i < num_of_points_ - 2; ++i) {
+  for (size_t i = 0; i < num_of_points - 2; ++i) {
     size_t findex = i * 2;
     size_t mindex = findex + 2;
     size_t lindex = mindex + 2;
-    fg[0] += heading_weight_ * (CppAD::pow((x[findex] + x[lindex] - 2.0 * x[mindex]), 2) +
-        CppAD::pow((x[findex + 1] + x[lindex + 1] - 2.0 * x[mindex + 1]), 2));
+    costs[kHeadingCost] += CppAD::pow((x[findex] + x[lindex] - 2.0 * x[mindex]), 2) +
+        CppAD::pow((x[findex + 1] + x[lindex + 1] - 2.0 * x[mindex + 1]), 2);
   }
   // the total length cost
-  for (size_t i = 0; i < num_of_points_ - 1; ++i) {
+  for (size_t i = 0; i < num_of_points - 1; ++i) {
     size_t findex = i * 2;
     size_t nindex = findex + 2;
-    fg[0] += length_weight_ * (CppAD::pow(x[findex] - x[nindex], 2) +
-        CppAD::pow(x[findex + 1] - x[nindex + 1], 2));
+    costs[kLengthCost] += CppAD::pow(x[findex] - x[nindex], 2) + CppAD::pow(x[findex + 1] - x[nindex + 1], 2);
   }
-
-  for (size_t i = slack_variable_start_index_; i < slack_variable_end_index_; ++i) {
-    fg[0] += slack_weight_ * x[i];
+  for (size_t i = slack_variable_start_index; i < slack_variable_end_index; ++i) {
+    costs[kSlackCost] += x[i];
   }
-
-//  for (size_t i = 0; i < num_of_points_; ++i) {
-//    size_t index = i * 2;
-//    fg[index + 1] = x[index];
-//    fg[index + 2] = x[index + 1];
-//  }
   // the constraint function
-  for (size_t i = 0; i + 2 < num_of_points_; ++i) {
+  for (size_t i = 0; i + 2 < num_of_points; ++i) {
     size_t findex = i * 2;
     size_t mindex = findex + 2;
     size_t lindex = mindex + 2;
+    (*fg)[kNumOfCosts + i] = ((x[findex] + x[lindex]) - 2.0 * x[mindex]) * ((x[findex] + x[lindex]) - 2.0 * x[mindex])
+        + ((x[findex + 1] + x[lindex + 1]) - 2.0 * x[mindex + 1]) * ((x[findex + 1] + x[lindex + 1]) - 2.0 * x[mindex + 1]);
+  }
+}
+
+void ReferenceLineSmoothIpoptInterface::SetUp(const std::shared_ptr<Tape> &tape,
+                                              const std::vector<std::pair<double, double>> &ref_points) {
+  assert(tape != nullptr && tape->num_of_points == ref_points.size());
+  tape_ = tape;
+  ref_xy_.resize(ref_points.size() * 2);
+  ref_squared_norm_ = 0.0;
+  for (size_t i = 0; i < ref_points.size(); ++i) {
+    ref_xy_[i * 2] = ref_points[i].first;
+    ref_xy_[i * 2 + 1] = ref_points[i].second;
+    ref_squared_norm_ += ref_points[i].first * ref_points[i].first + ref_points[i].second * ref_points[i].second;
+  }
+  solved_ = false;
+  solution_.clear();
+  range_values_valid_ = false;
+  range_weights_.assign(kNumOfCosts + tape_->num_of_constraints, 0.0);
+}
+
+bool ReferenceLineSmoothIpoptInterface::get_nlp_info(Ipopt::Index &n,
+                                                     Ipopt::Index &m,
+                                                     Ipopt::Index &nnz_jac_g,
+                                                     Ipopt::Index &nnz_h_lag,
+                                                     IndexStyleEnum &index_style) {
+  n = static_cast<Ipopt::Index>(tape_->num_of_variables);
+  m = static_cast<Ipopt::Index>(tape_->num_of_constraints);
+  nnz_jac_g = static_cast<Ipopt::Index>(tape_->jacobian_rows.size());
+  nnz_h_lag = static_cast<Ipopt::Index>(tape_->hessian_rows.size());
+  index_style = C_STYLE;
+  return true;
+}
+
+bool ReferenceLineSmoothIpoptInterface::get_bounds_info(Ipopt::Index n,
+                                                        Ipopt::Number *x_l,
+                                                        Ipopt::Number *x_u,
+                                                        Ipopt::Index m,
+                                                        Ipopt::Number *g_l,
+                                                        Ipopt::Number *g_u) {
+  if (variable_lower_bounds_.size() != n || variable_upper_bounds_.size() != n
+      || constraint_lower_bounds_.size() != m || constraint_upper_bounds_.size() != m) {
+    ROS_FATAL("[ReferenceLineSmoothIpoptInterface::get_bounds_info], the bounds do not match the problem");
+    return false;
+  }
+  std::copy(variable_lower_bounds_.begin(), variable_lower_bounds_.end(), x_l);
+  std::copy(variable_upper_bounds_.begin(), variable_upper_bounds_.end(), x_u);
+  std::copy(constraint_lower_bounds_.begin(), constraint_lower_bounds_.end(), g_l);
+  std::copy(constraint_upper_bounds_.begin(), constraint_upper_bounds_.end(), g_u);
+  return true;
+}
 
-    fg[curvature_constraint_start_index_ + 1 + i] = (((x[findex] + x[lindex]) - 2.0 * x[mindex]) *
-        ((x[findex] + x[lindex]) - 2.0 * x[mindex]) +
-        ((x[findex + 1] + x[lindex + 1]) - 2.0 * x[mindex + 1]) *
-            ((x[findex + 1] + x[lindex + 1]) - 2.0 * x[mindex + 1]))  /*+  x[slack_variable_start_index_ + i] */;
+bool ReferenceLineSmoothIpoptInterface::get_starting_point(Ipopt::Index n,
+                                                           bool init_x,
+                                                           Ipopt::Number *x,
+                                                           bool init_z,
+                                                           Ipopt::Number *z_L,
+                                                           Ipopt::Number *z_U,
+                                                           Ipopt::Index m,
+                                                           bool init_lambda,
+                                                           Ipopt::Number *lambda) {
+  if (init_z || init_lambda || initial_values_.size() != n) {
+    return false;
   }
+  if (init_x) {
+    std::copy(initial_values_.begin(), initial_values_.end(), x);
+  }
+  return true;
+}
+
+bool ReferenceLineSmoothIpoptInterface::eval_f(Ipopt::Index n,
+                                               const Ipopt::Number *x,
+                                               bool new_x,
+                                               Ipopt::Number &obj_value) {
+  UpdateRangeValues(x, new_x);
+  // |p - r|^2 = |p|^2 - 2 * r . p + |r|^2
+  double ref_product = 0.0;
+  for (size_t i = 0; i < ref_xy_.size(); ++i) {
+    ref_product += ref_xy_[i] * x[i];
+  }
+  obj_value = ref_deviation_weight_ * (range_values_[kDeviationCost] - 2.0 * ref_product + ref_squared_norm_)
+      + heading_weight_ * range_values_[kHeadingCost] + length_weight_ * range_values_[kLengthCost]
+      + slack_weight_ * range_values_[kSlackCost];
+  return true;
+}
+
+bool ReferenceLineSmoothIpoptInterface::eval_grad_f(Ipopt::Index n,
+                                                    const Ipopt::Number *x,
+                                                    bool new_x,
+                                                    Ipopt::Number *grad_f) {
+  // the reverse sweep needs the forward sweep at x as the last one
+  SetVariables(x);
+  range_values_ = tape_->fun.Forward(0, variables_);
+  range_values_valid_ = true;
+  std::fill(range_weights_.begin(), range_weights_.end(), 0.0);
+  range_weights_[kDeviationCost] = ref_deviation_weight_;
+  range_weights_[kHeadingCost] = heading_weight_;
+  range_weights_[kLengthCost] = length_weight_;
+  range_weights_[kSlackCost] = slack_weight_;
+  gradient_ = tape_->fun.Reverse(1, range_weights_);
+  for (size_t i = 0; i < n; ++i) {
+    grad_f[i] = gradient_[i];
+  }
+  for (size_t i = 0; i < ref_xy_.size(); ++i) {
+    grad_f[i] -= 2.0 * ref_deviation_weight_ * ref_xy_[i];
+  }
+  return true;
+}
+
+bool ReferenceLineSmoothIpoptInterface::eval_g(Ipopt::Index n,
+                                               const Ipopt::Number *x,
+                                               bool new_x,
+                                               Ipopt::Index m,
+                                               Ipopt::Number *g) {
+  UpdateRangeValues(x, new_x);
+  for (size_t i = 0; i < m; ++i) {
+    g[i] = range_values_[kNumOfCosts + i];
+  }
+  return true;
+}
 
-//  size_t slack_var_index = 0;
-//  for (size_t i = slack_constraint_start_index_; i < slack_constraint_end_index_; ++i) {
-//    fg[i + 1] = x[slack_variable_start_index_ + slack_var_index];
-//    ++slack_var_index;
-//  }
+bool ReferenceLineSmoothIpoptInterface::eval_jac_g(Ipopt::Index n,
+                                                   const Ipopt::Number *x,
+                                                   bool new_x,
+                                                   Ipopt::Index m,
+                                                   Ipopt::Index nele_jac,
+                                                   Ipopt::Index *iRow,
+                                                   Ipopt::Index *jCol,
+                                                   Ipopt::Number *values) {
+  if (values == nullptr) {
+    for (size_t k = 0; k < nele_jac; ++k) {
+      iRow[k] = static_cast<Ipopt::Index>(tape_->jacobian_rows[k] - kNumOfCosts);
+      jCol[k] = static_cast<Ipopt::Index>(tape_->jacobian_cols[k]);
+    }
+    return true;
+  }
+  SetVariables(x);
+  // the sweeps of the jacobian leave the tape at x, but not the range values
+  range_values_valid_ = range_values_valid_ && !new_x;
+  jacobian_values_.resize(nele_jac);
+  tape_->fun.SparseJacobianReverse(variables_, tape_->jacobian_pattern, tape_->jacobian_rows, tape_->jacobian_cols,
+                                   jacobian_values_, tape_->jacobian_work);
+  std::copy(jacobian_values_.begin(), jacobian_values_.end(), values);
+  return true;
 }
 
-ReferenceLineSmoothIpoptInterface::ReferenceLineSmoothIpoptInterface(const std::vector<std::pair<double,
-                                                                                                 double>> &ref_points) {
-  assert(ref_points.size() >= 3);
-  ref_points_ = ref_points;
-  num_of_points_ = ref_points_.size();
-  num_of_slack_variable_ = num_of_points_ - 2;
-  num_of_variables_ = num_of_points_ * 2 + num_of_slack_variable_;
-  num_curvature_constraint_ = num_of_points_ - 2;
-  slack_variable_start_index_ = num_of_points_ * 2;
-  slack_variable_end_index_ = slack_variable_start_index_ + num_of_slack_variable_;
-
-  num_of_constraint_ = num_curvature_constraint_;
-//  num_of_slack_constr_ = num_of_points_ - 2;
-//  num_of_constraint_ = num_of_points_ * 2 + num_of_slack_constr_ + num_curvature_constraint_;
-  curvature_constraint_start_index_ = 0;
-  curvature_constraint_end_index_ = curvature_constraint_start_index_ + num_curvature_constraint_;
-//  slack_constraint_start_index_ = curvature_constraint_end_index_;
-//  slack_constraint_end_index_ = slack_constraint_start_index_ + num_of_slack_constr_;
+bool ReferenceLineSmoothIpoptInterface::eval_h(Ipopt::Index n,
+                                               const Ipopt::Number *x,
+                                               bool new_x,
+                                               Ipopt::Number obj_factor,
+                                               Ipopt::Index m,
+                                               const Ipopt::Number *lambda,
+                                               bool new_lambda,
+                                               Ipopt::Index nele_hess,
+                                               Ipopt::Index *iRow,
+                                               Ipopt::Index *jCol,
+                                               Ipopt::Number *values) {
+  if (values == nullptr) {
+    for (size_t k = 0; k < nele_hess; ++k) {
+      iRow[k] = static_cast<Ipopt::Index>(tape_->hessian_rows[k]);
+      jCol[k] = static_cast<Ipopt::Index>(tape_->hessian_cols[k]);
+    }
+    return true;
+  }
+  SetVariables(x);
+  range_values_valid_ = range_values_valid_ && !new_x;
+  // the linear part of the deviation cost has no second derivatives
+  range_weights_[kDeviationCost] = obj_factor * ref_deviation_weight_;
+  range_weights_[kHeadingCost] = obj_factor * heading_weight_;
+  range_weights_[kLengthCost] = obj_factor * length_weight_;
+  range_weights_[kSlackCost] = obj_factor * slack_weight_;
+  for (size_t i = 0; i < m; ++i) {
+    range_weights_[kNumOfCosts + i] = lambda[i];
+  }
+  hessian_values_.resize(nele_hess);
+  tape_->fun.SparseHessian(variables_, range_weights_, tape_->hessian_pattern, tape_->hessian_rows,
+                           tape_->hessian_cols, hessian_values_, tape_->hessian_work);
+  std::copy(hessian_values_.begin(), hessian_values_.end(), values);
+  return true;
+}
 
+void ReferenceLineSmoothIpoptInterface::finalize_solution(Ipopt::SolverReturn status,
+                                                          Ipopt::Index n,
+                                                          const Ipopt::Number *x,
+                                                          const Ipopt::Number *z_L,
+                                                          const Ipopt::Number *z_U,
+                                                          Ipopt::Index m,
+                                                          const Ipopt::Number *g,
+                                                          const Ipopt::Number *lambda,
+                                                          Ipopt::Number obj_value,
+                                                          const Ipopt::IpoptData *ip_data,
+                                                          Ipopt::IpoptCalculatedQuantities *ip_cq) {
+  solved_ = status == Ipopt::SUCCESS;
+  solution_.assign(x, x + n);
 }
+
+void ReferenceLineSmoothIpoptInterface::UpdateRangeValues(const Ipopt::Number *x, bool new_x) {
+  if (range_values_valid_ && !new_x) {
+    return;
+  }
+  SetVariables(x);
+  range_values_ = tape_->fun.Forward(0, variables_);
+  range_values_valid_ = true;
+}
+
+void ReferenceLineSmoothIpoptInterface::SetVariables(const Ipopt::Number *x) {
+  variables_.assign(x, x + tape_->num_of_variables);
+}
+
 }
@@ -1,10 +1,17 @@
 #include "reference_line/reference_line_smoother.hpp"
-#include "reference_line/reference_line_smooth_ipopt_interface.hpp"
 
 
 namespace planning {
 
+constexpr size_t ReferenceLineSmoother::kMaxNumOfIpoptTapes;
+
+bool ReferenceLineSmoother::SmoothReferenceLine(const std::vector<ReferencePoint> &raw_points,
+                                                std::vector<ReferencePoint> *const smoothed_ref_points) {
+  return SmoothReferenceLine(raw_points, 0, smoothed_ref_points);
+}
+
 bool ReferenceLineSmoother::SmoothReferenceLine(const std::vector<ReferencePoint> &raw_points,
+                                                size_t num_of_fixed_points,
                                                 std::vector<ReferencePoint> *const smoothed_ref_points) {
   if (smoothed_ref_points == nullptr) {
     ROS_FATAL("[ReferenceLineSmoother::GetSmoothReferenceLine],"
@@ -22,7 +29,14 @@ bool ReferenceLineSmoother::SmoothReferenceLine(const std::vector<ReferencePoint
     return false;
   }
 
+  if (num_of_fixed_points > point_num) {
+    ROS_FATAL("[ReferenceLineSmoother::GetSmoothReferenceLine], "
+              "the fixed points num is more than the ref points num");
+    return false;
+  }
+
   num_of_points_ = point_num;
+  num_of_fixed_points_ = num_of_fixed_points;
   num_of_slack_variable_ = num_of_points_ - 2;
   num_of_variables_ = num_of_points_ * 2 + num_of_slack_variable_;
   num_curvature_constraint_ = num_of_points_ - 2;
@@ -40,30 +54,17 @@ bool ReferenceLineSmoother::SmoothReferenceLine(const std::vector<ReferencePoint
   for (const auto &ref_point : ref_points_) {
     xy.emplace_back(ref_point.x(), ref_point.y());
   }
-  ReferenceLineSmoothIpoptInterface smoother_interface(xy);
-  smoother_interface.set_ref_deviation_weight(deviation_weight_);
-  smoother_interface.set_heading_weight(heading_weight_);
-  smoother_interface.set_length_weight(distance_weight_);
-  smoother_interface.set_slack_weight(slack_weight_);
-  SetUpOptions();
-  SetUpInitValue();
   if (!this->SetUpConstraint()) {
     std::cout << "set up constraint error" << std::endl;
     return false;
   }
-  CppAD::ipopt::solve_result<DVector> solution;
-  CppAD::ipopt::solve<DVector, ReferenceLineSmoothIpoptInterface>(options_, xi_, x_l_, x_u_, g_l_, g_u_,
-                                                                  smoother_interface, solution);
-  if (solution.status != CppAD::ipopt::solve_result<DVector>::success) {
-    printf("[GetSmoothReferenceLine] failed reason: %i",
-           solution.status);
-    return false;
+  if (backend_ == Backend::kBandedSqp) {
+    if (SmoothByBandedSqp(xy, smoothed_ref_points)) {
+      return true;
+    }
+    ROS_WARN("[ReferenceLineSmoother::GetSmoothReferenceLine], falls back to ipopt");
   }
-
-  smoothed_ref_points->clear();
-  smoothed_ref_points->reserve(raw_points.size());
-  bool result = this->TraceSmoothReferenceLine(solution, smoothed_ref_points);
-  return result;
+  return SmoothByIpopt(xy, smoothed_ref_points);
 }
 
 bool ReferenceLineSmoother::SetUpConstraint() {
@@ -77,7 +78,9 @@ bool ReferenceLineSmoother::SetUpConstraint() {
 //  std::cout << "number_of_curvature_constraints: " << number_of_curvature_constraints << std::endl;
   std::vector<double> boundary_bound(num_of_points_, 0.0);
   for (size_t i = 0; i < num_of_points_; ++i) {
-    if (i == 0 || i == num_of_points_ - 1) {
+    if (i < num_of_fixed_points_) {
+      boundary_bound[i] = 0.0;
+    } else if (i == 0 || i == num_of_points_ - 1) {
       boundary_bound[i] = 0.4;
     } else {
       boundary_bound[i] = boundary_radius;
@@ -108,6 +111,7 @@ bool ReferenceLineSmoother::SetUpConstraint() {
 
   double average_ds = ref_line_total_length / static_cast<double>(num_of_points_ - 1);
   double curvature_upper = average_ds * average_ds * max_curvature_;
+  max_second_difference_ = curvature_upper;
 
   for (size_t i = curvature_constraint_start_index_; i < curvature_constraint_end_index_; ++i) {
     g_l_[i] = -1e20;
@@ -117,11 +121,11 @@ bool ReferenceLineSmoother::SetUpConstraint() {
 }
 
 void ReferenceLineSmoother::SetUpOptions() {
-  options_.clear();
-  options_ += "Integer print_level  0\n";
-  options_ += "Sparse  true        reverse\n";
-  options_ += "Numeric tol          1e-5\n";
-  options_ += "Integer max_iter    15\n";
+  ipopt_app_ = Ipopt::IpoptApplicationFactory();
+  ipopt_app_->Options()->SetIntegerValue("print_level", 0);
+  ipopt_app_->Options()->SetStringValue("sb", "yes");
+  ipopt_app_->Options()->SetNumericValue("tol", 1e-5);
+  ipopt_app_->Options()->SetIntegerValue("max_iter", 15);
 }
 
 void ReferenceLineSmoother::SetUpInitValue() {
@@ -138,16 +142,56 @@ void ReferenceLineSmoother::SetUpInitValue() {
   }
 }
 
-bool ReferenceLineSmoother::TraceSmoothReferenceLine(
-    const CppAD::ipopt::solve_result<DVector> &result,
-    std::vector<ReferencePoint> *const ref_points) const {
+std::shared_ptr<ReferenceLineSmoothIpoptInterface::Tape> ReferenceLineSmoother::GetIpoptTape() {
+  auto iter = ipopt_tapes_.find(num_of_points_);
+  if (iter != ipopt_tapes_.end()) {
+    return iter->second;
+  }
+  if (ipopt_tapes_.size() >= kMaxNumOfIpoptTapes) {
+    ipopt_tapes_.clear();
+  }
+  auto tape = ReferenceLineSmoothIpoptInterface::RecordTape(num_of_points_);
+  ipopt_tapes_.emplace(num_of_points_, tape);
+  return tape;
+}
 
-  if (result.status != CppAD::ipopt::solve_result<DVector>::success) {
-    std::cout << " result != success" << std::endl;
+bool ReferenceLineSmoother::SmoothByIpopt(const std::vector<std::pair<double, double>> &xy,
+                                          std::vector<ReferencePoint> *const smoothed_ref_points) {
+  if (Ipopt::IsNull(ipopt_app_)) {
+    SetUpOptions();
+    if (ipopt_app_->Initialize() != Ipopt::Solve_Succeeded) {
+      ipopt_app_ = nullptr;
+      ROS_FATAL("[ReferenceLineSmoother::SmoothByIpopt], failed to initialize ipopt");
+      return false;
+    }
+    ipopt_interface_ = new ReferenceLineSmoothIpoptInterface();
+  }
+  ipopt_interface_->SetUp(GetIpoptTape(), xy);
+  ipopt_interface_->set_ref_deviation_weight(deviation_weight_);
+  ipopt_interface_->set_heading_weight(heading_weight_);
+  ipopt_interface_->set_length_weight(distance_weight_);
+  ipopt_interface_->set_slack_weight(slack_weight_);
+  ipopt_interface_->set_variable_bounds(x_l_, x_u_);
+  ipopt_interface_->set_constraint_bounds(g_l_, g_u_);
+  SetUpInitValue();
+  ipopt_interface_->set_initial_values(xi_);
+  const auto status = ipopt_app_->OptimizeTNLP(Ipopt::GetRawPtr(ipopt_interface_));
+  if (!ipopt_interface_->solved()) {
+    printf("[GetSmoothReferenceLine] failed reason: %i",
+           static_cast<int>(status));
     return false;
   }
 
-  if (result.x.size() != num_of_variables_) {
+  smoothed_ref_points->clear();
+  smoothed_ref_points->reserve(xy.size());
+  return this->TraceSmoothReferenceLine(ipopt_interface_->solution(), smoothed_ref_points);
+}
+
+bool ReferenceLineSmoother::TraceSmoothReferenceLine(
+    const std::vector<double> &result,
+    std::vector<ReferencePoint> *const ref_points) const {
+
+  if (result.size() != num_of_variables_) {
     return false;
   }
 
@@ -156,12 +200,50 @@ bool ReferenceLineSmoother::TraceSmoothReferenceLine(
 
   for (size_t i = 0; i < num_of_points_; ++i) {
     size_t index = i * 2;
-    reference_point.set_xy(result.x[index], result.x[index + 1]);
+    reference_point.set_xy(result[index], result[index + 1]);
     ref_points->push_back(reference_point);
   }
 
   return true;
 }
+bool ReferenceLineSmoother::SmoothByBandedSqp(const std::vector<std::pair<double, double>> &xy,
+                                              std::vector<ReferencePoint> *const smoothed_ref_points) {
+  // the slack variables of the IPOPT problem are not in any constraint, they are 0 at its optimum
+  std::vector<double> lower_bounds(num_of_points_ * 2);
+  std::vector<double> upper_bounds(num_of_points_ * 2);
+  for (size_t i = 0; i < num_of_points_ * 2; ++i) {
+    lower_bounds[i] = x_l_[i];
+    upper_bounds[i] = x_u_[i];
+  }
+  sqp_smoother_.set_ref_deviation_weight(deviation_weight_);
+  sqp_smoother_.set_heading_weight(heading_weight_);
+  sqp_smoother_.set_length_weight(distance_weight_);
+  std::vector<std::pair<double, double>> smoothed_xy;
+  if (!sqp_smoother_.Solve(xy, lower_bounds, upper_bounds, max_second_difference_, &smoothed_xy)) {
+    ROS_WARN("[ReferenceLineSmoother::SmoothByBandedSqp], failed to solve");
+    return false;
+  }
+  smoothed_ref_points->clear();
+  smoothed_ref_points->reserve(smoothed_xy.size());
+  ReferencePoint reference_point;
+  for (const auto &point : smoothed_xy) {
+    reference_point.set_xy(point.first, point.second);
+    smoothed_ref_points->push_back(reference_point);
+  }
+  return true;
+}
+
+bool ReferenceLineSmoother::GetBackend(const std::string &name, Backend *backend) {
+  if (name == "ipopt") {
+    *backend = Backend::kIpopt;
+  } else if (name == "banded_sqp") {
+    *backend = Backend::kBandedSqp;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 ReferenceLineSmoother::ReferenceLineSmoother(const double deviation_weight,
                                              const double heading_weight,
                                              const double distance_weight,
@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 #include <tf/transform_datatypes.h>
 
+#include <array>
 #include <memory>
 #define private public
 #include "reference_line/reference_line.hpp"
@@ -14,6 +15,58 @@ class ReferenceLineSmootherTest : public testing::Test {
     smoother_ = std::make_unique<ReferenceLineSmoother>();
   }
   void TearDown() override {}
+
+  /**
+   * @brief: way points 1 m apart along a 30 m radius arc then a straight line, each one off it to the left by
+   * offset_amplitude * sin(1.7 * i + phase)
+   * @param num_of_points
+   * @param num_of_arc_points: the number of points before the heading stops turning
+   * @param offset_amplitude
+   * @param phase
+   * @return
+   */
+  static std::vector<planning_msgs::WayPoint> MakeArcThenStraightWayPoints(size_t num_of_points,
+                                                                         size_t num_of_arc_points,
+                                                                         double offset_amplitude,
+                                                                         double phase = 0.0) {
+    const double radius = 30.0;
+    const double ds = 1.0;
+    std::vector<planning_msgs::WayPoint> way_points;
+    way_points.reserve(num_of_points);
+    planning_msgs::WayPoint way_point;
+    double x = 0.0;
+    double y = 0.0;
+    double heading = 0.0;
+    for (size_t i = 0; i < num_of_points; ++i) {
+      const double offset = offset_amplitude * std::sin(1.7 * static_cast<double>(i) + phase);
+      way_point.s = i * ds;
+      way_point.pose.position.x = x - offset * std::sin(heading);
+      way_point.pose.position.y = y + offset * std::cos(heading);
+      way_point.pose.orientation = tf::createQuaternionMsgFromYaw(heading);
+      way_point.lane_width = 4.0;
+      way_point.id = i;
+      way_points.push_back(way_point);
+      x += ds * std::cos(heading);
+      y += ds * std::sin(heading);
+      if (i < num_of_arc_points) {
+        heading += ds / radius;
+      }
+    }
+    return way_points;
+  }
+
+  /**
+   * @brief: the positions of the way points, the raw input of the smoother
+   */
+  static std::vector<ReferencePoint> ToRawPoints(const std::vector<planning_msgs::WayPoint> &way_points) {
+    std::vector<ReferencePoint> raw_points;
+    raw_points.reserve(way_points.size());
+    for (const auto &way_point : way_points) {
+      raw_points.emplace_back(way_point.pose.position.x, way_point.pose.position.y);
+    }
+    return raw_points;
+  }
+
   std::unique_ptr<ReferenceLineSmoother> smoother_;
 
 };
@@ -65,6 +118,164 @@ TEST_F(ReferenceLineSmootherTest, line_ref_test) {
 
 }
 
+TEST_F(ReferenceLineSmootherTest, reference_point_table_test) {
+  // a 30 m radius arc followed by a straight line
+  auto ref_line = ReferenceLine(MakeArcThenStraightWayPoints(80, 40, 0.0));
+  ASSERT_NE(ref_line.reference_point_table_, nullptr);
+  for (double s = -1.0; s < ref_line.Length() + 1.0; s += 0.037) {
+    auto ref_point = ref_line.GetReferencePoint(s);
+    auto exact_ref_point = ref_line.GetExactReferencePoint(s);
+    EXPECT_NEAR(ref_point.x(), exact_ref_point.x(), 1e-3);
+    EXPECT_NEAR(ref_point.y(), exact_ref_point.y(), 1e-3);
+    EXPECT_NEAR(std::sin(ref_point.theta() - exact_ref_point.theta()), 0.0, 1e-3);
+    EXPECT_NEAR(ref_point.kappa(), exact_ref_point.kappa(), 1e-2);
+  }
+  // the copies share the table
+  ReferenceLine copied_ref_line(ref_line);
+  EXPECT_EQ(copied_ref_line.reference_point_table_, ref_line.reference_point_table_);
+}
+
+TEST_F(ReferenceLineSmootherTest, batch_sl_boundary_test) {
+  // a 30 m radius arc followed by a straight line
+  auto ref_line = ReferenceLine(MakeArcThenStraightWayPoints(80, 40, 0.0));
+  for (double s = 2.0; s < ref_line.Length() - 2.0; s += 3.3) {
+    auto ref_point = ref_line.GetReferencePoint(s);
+    for (double l : {-3.0, 0.0, 2.5}) {
+      Eigen::Vector2d center(ref_point.x() - l * std::sin(ref_point.theta()),
+                             ref_point.y() + l * std::cos(ref_point.theta()));
+      common::Box2d box(center, ref_point.theta() + 0.3, 4.5, 2.0);
+      // the batch projection agrees with the point by point one
+      std::vector<Eigen::Vector2d> corners = box.GetAllCorners();
+      std::vector<common::SLPoint> ordered_sl_points(corners.size());
+      std::vector<common::SLPoint> sl_points(corners.size());
+      EXPECT_TRUE(ref_line.XYToSL(corners.data(), corners.size(), ordered_sl_points.data()));
+      EXPECT_TRUE(ref_line.XYToSL(corners.data(), corners.size(), sl_points.data(), false));
+      for (size_t i = 0; i < corners.size(); ++i) {
+        common::SLPoint sl_point;
+        EXPECT_TRUE(ref_line.XYToSL(corners[i], &sl_point));
+        EXPECT_DOUBLE_EQ(sl_points[i].s, sl_point.s);
+        EXPECT_DOUBLE_EQ(sl_points[i].l, sl_point.l);
+        EXPECT_NEAR(ordered_sl_points[i].s, sl_point.s, 1e-6);
+        EXPECT_NEAR(ordered_sl_points[i].l, sl_point.l, 1e-6);
+      }
+      // the extents only boundary is the same as the full one
+      common::SLBoundary sl_boundary;
+      common::SLBoundary extents;
+      EXPECT_TRUE(ref_line.GetSLBoundary(box, &sl_boundary));
+      EXPECT_TRUE(ref_line.GetSLBoundary(box, &extents, false));
+      EXPECT_TRUE(extents.boundary_points.empty());
+      EXPECT_GE(sl_boundary.boundary_points.size(), 4);
+      EXPECT_DOUBLE_EQ(extents.start_s, sl_boundary.start_s);
+      EXPECT_DOUBLE_EQ(extents.end_s, sl_boundary.end_s);
+      EXPECT_DOUBLE_EQ(extents.start_l, sl_boundary.start_l);
+      EXPECT_DOUBLE_EQ(extents.end_l, sl_boundary.end_l);
+      EXPECT_NEAR(0.5 * (extents.start_s + extents.end_s), s, 0.5);
+      EXPECT_NEAR(0.5 * (extents.start_l + extents.end_l), l, 0.5);
+    }
+  }
+}
+
+TEST_F(ReferenceLineSmootherTest, backends_agree_test) {
+  // a 30 m radius arc followed by a straight line, the points off it by up to 0.3 m
+  const auto raw_points = ToRawPoints(MakeArcThenStraightWayPoints(120, 60, 0.3));
+  // the weights of the planner params and of waypoints_smooth
+  const std::vector<std::array<double, 4>> weights{{13.5, 1.0, 100.0, 5.0}, {2.0, 1.0, 10.0, 1.0}};
+  for (const auto &weight : weights) {
+    smoother_->SetSmoothParams(weight[0], weight[1], weight[2], weight[3], 5.0);
+    std::vector<ReferencePoint> ipopt_points;
+    smoother_->SetBackend(ReferenceLineSmoother::Backend::kIpopt);
+    ASSERT_TRUE(smoother_->SmoothReferenceLine(raw_points, &ipopt_points));
+    std::vector<ReferencePoint> sqp_points;
+    smoother_->SetBackend(ReferenceLineSmoother::Backend::kBandedSqp);
+    ASSERT_TRUE(smoother_->SmoothReferenceLine(raw_points, &sqp_points));
+    ASSERT_EQ(ipopt_points.size(), raw_points.size());
+    ASSERT_EQ(sqp_points.size(), raw_points.size());
+    for (size_t i = 0; i < raw_points.size(); ++i) {
+      EXPECT_NEAR(sqp_points[i].x(), ipopt_points[i].x(), 1e-2);
+      EXPECT_NEAR(sqp_points[i].y(), ipopt_points[i].y(), 1e-2);
+    }
+  }
+
+  // a curvature bound close to the arc curvature (1 / 30) is active, the points stay within their boxes
+  const double max_curvature = 0.035;
+  smoother_->SetSmoothParams(13.5, 1.0, 100.0, 5.0, max_curvature);
+  std::vector<ReferencePoint> sqp_points;
+  ASSERT_TRUE(smoother_->SmoothReferenceLine(raw_points, &sqp_points));
+  double length = 0.0;
+  for (size_t i = 1; i < raw_points.size(); ++i) {
+    length += std::hypot(raw_points[i].x() - raw_points[i - 1].x(), raw_points[i].y() - raw_points[i - 1].y());
+  }
+  const double average_ds = length / static_cast<double>(raw_points.size() - 1);
+  for (size_t i = 0; i + 2 < sqp_points.size(); ++i) {
+    EXPECT_LE(std::hypot(sqp_points[i].x() - 2.0 * sqp_points[i + 1].x() + sqp_points[i + 2].x(),
+                         sqp_points[i].y() - 2.0 * sqp_points[i + 1].y() + sqp_points[i + 2].y()),
+              average_ds * average_ds * max_curvature + 1e-3);
+  }
+  for (size_t i = 0; i < sqp_points.size(); ++i) {
+    const double bound = i == 0 || i + 1 == sqp_points.size() ? 0.4 : 1.5;
+    EXPECT_LE(std::fabs(sqp_points[i].x() - raw_points[i].x()), bound + 1e-6);
+    EXPECT_LE(std::fabs(sqp_points[i].y() - raw_points[i].y()), bound + 1e-6);
+  }
+}
+
+TEST_F(ReferenceLineSmootherTest, ipopt_tape_reuse_test) {
+  // lines of the same number of points share the recorded problem, a line of another number records its own
+  auto create_line = [](size_t num_of_points, double phase) {
+    return ToRawPoints(MakeArcThenStraightWayPoints(num_of_points, num_of_points / 2, 0.3, phase));
+  };
+  smoother_->SetSmoothParams(13.5, 1.0, 100.0, 5.0, 5.0);
+  std::vector<ReferencePoint> smoothed_points;
+  ASSERT_TRUE(smoother_->SmoothReferenceLine(create_line(80, 0.0), &smoothed_points));
+  ASSERT_TRUE(smoother_->SmoothReferenceLine(create_line(81, 0.0), &smoothed_points));
+  ASSERT_EQ(smoothed_points.size(), 81);
+  const auto raw_points = create_line(80, 0.4);
+  ASSERT_TRUE(smoother_->SmoothReferenceLine(raw_points, &smoothed_points));
+
+  ReferenceLineSmoother fresh_smoother;
+  fresh_smoother.SetSmoothParams(13.5, 1.0, 100.0, 5.0, 5.0);
+  std::vector<ReferencePoint> fresh_points;
+  ASSERT_TRUE(fresh_smoother.SmoothReferenceLine(raw_points, &fresh_points));
+  ASSERT_EQ(smoothed_points.size(), fresh_points.size());
+  for (size_t i = 0; i < fresh_points.size(); ++i) {
+    EXPECT_NEAR(smoothed_points[i].x(), fresh_points[i].x(), 1e-6);
+    EXPECT_NEAR(smoothed_points[i].y(), fresh_points[i].y(), 1e-6);
+  }
+}
+
+TEST_F(ReferenceLineSmootherTest, fixed_points_test) {
+  // a window moved by 4 points, its kept points smoothed before: only the last ones and the new ones are smoothed
+  const auto route = ToRawPoints(MakeArcThenStraightWayPoints(124, 60, 0.3));
+  const size_t num_of_fixed_points = 2;
+  const size_t num_of_resmoothed_points = 10;
+  smoother_->SetSmoothParams(13.5, 1.0, 100.0, 5.0, 5.0);
+  for (const auto backend : {ReferenceLineSmoother::Backend::kIpopt, ReferenceLineSmoother::Backend::kBandedSqp}) {
+    smoother_->SetBackend(backend);
+    std::vector<ReferencePoint> last_points;
+    ASSERT_TRUE(smoother_->SmoothReferenceLine(std::vector<ReferencePoint>(route.begin(), route.begin() + 120),
+                                               &last_points));
+    const std::vector<ReferencePoint> raw_points(route.begin() + 4, route.end());
+    const size_t first_free_index = last_points.size() - 4 - num_of_resmoothed_points;
+    std::vector<ReferencePoint> points(last_points.begin() + 4 + first_free_index - num_of_fixed_points,
+                                       last_points.begin() + 4 + first_free_index);
+    points.insert(points.end(), raw_points.begin() + first_free_index, raw_points.end());
+    std::vector<ReferencePoint> smoothed_tail;
+    ASSERT_TRUE(smoother_->SmoothReferenceLine(points, num_of_fixed_points, &smoothed_tail));
+    ASSERT_EQ(smoothed_tail.size(), points.size());
+    for (size_t i = 0; i < num_of_fixed_points; ++i) {
+      EXPECT_NEAR(smoothed_tail[i].x(), points[i].x(), 1e-6);
+      EXPECT_NEAR(smoothed_tail[i].y(), points[i].y(), 1e-6);
+    }
+    // away from the open beginning of the full smoothing, the same as it
+    std::vector<ReferencePoint> full_points;
+    ASSERT_TRUE(smoother_->SmoothReferenceLine(raw_points, &full_points));
+    for (size_t i = num_of_fixed_points; i < smoothed_tail.size(); ++i) {
+      const auto &full_point = full_points[first_free_index - num_of_fixed_points + i];
+      EXPECT_NEAR(smoothed_tail[i].x(), full_point.x(), 1e-2);
+      EXPECT_NEAR(smoothed_tail[i].y(), full_point.y(), 1e-2);
+    }
+  }
+}
+
 TEST_F(ReferenceLineSmootherTest, waypoints_smooth) {
   Eigen::MatrixXd poses(190, 3);
   poses << 127.413, -196.713, -3.1391,
@@ -0,0 +1,470 @@
+#include "reference_line/reference_line_sqp_smoother.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ros/ros.h>
+
+namespace {
+constexpr size_t kMaxSqpIterations = 10;
+// the second differences above this ratio of the bound are linearized before the first QP
+constexpr double kNearActiveRatio = 0.5;
+// the max violation of the second difference bound of a solution, in meters
+constexpr double kCurvatureTolerance = 1e-4;
+// over all the QPs of a solve, an iteration takes about 10 us for 120 points
+constexpr size_t kMaxAdmmIterations = 1000;
+constexpr size_t kAdmmCheckInterval = 5;
+constexpr size_t kAdmmAdaptInterval = 25;
+constexpr double kAdmmSigma = 1e-6;
+constexpr double kAdmmAlpha = 1.6;
+constexpr double kAdmmAbsTolerance = 1e-6;
+constexpr double kAdmmRelTolerance = 1e-6;
+constexpr double kActiveDualTolerance = 1e-7;
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+double InfNorm(const std::vector<double> &values) {
+  double norm = 0.0;
+  for (const double value : values) {
+    norm = std::max(norm, std::fabs(value));
+  }
+  return norm;
+}
+}
+
+namespace planning {
+
+constexpr size_t ReferenceLineSqpSmoother::kBandwidth;
+
+void ReferenceLineSqpSmoother::BandMatrix::Resize(size_t matrix_size) {
+  size = matrix_size;
+  values.assign(matrix_size * (kBandwidth + 1), 0.0);
+}
+
+void ReferenceLineSqpSmoother::BandMatrix::Multiply(const std::vector<double> &x, std::vector<double> *y) const {
+  y->assign(size, 0.0);
+  for (size_t row = 0; row < size; ++row) {
+    const size_t col_start = row > kBandwidth ? row - kBandwidth : 0;
+    (*y)[row] += At(row, row) * x[row];
+    for (size_t col = col_start; col < row; ++col) {
+      const double value = At(row, col);
+      (*y)[row] += value * x[col];
+      (*y)[col] += value * x[row];
+    }
+  }
+}
+
+bool ReferenceLineSqpSmoother::BandMatrix::Factorize() {
+  for (size_t row = 0; row < size; ++row) {
+    const size_t col_start = row > kBandwidth ? row - kBandwidth : 0;
+    for (size_t col = col_start; col <= row; ++col) {
+      double sum = At(row, col);
+      for (size_t k = col_start; k < col; ++k) {
+        if (col - k <= kBandwidth) {
+          sum -= At(row, k) * At(col, k);
+        }
+      }
+      if (col == row) {
+        if (!(sum > 0.0)) {
+          return false;
+        }
+        At(row, row) = std::sqrt(sum);
+      } else {
+        At(row, col) = sum / At(col, col);
+      }
+    }
+  }
+  return true;
+}
+
+void ReferenceLineSqpSmoother::BandMatrix::Solve(std::vector<double> *x) const {
+  auto &b = *x;
+  for (size_t row = 0; row < size; ++row) {
+    const size_t col_start = row > kBandwidth ? row - kBandwidth : 0;
+    for (size_t col = col_start; col < row; ++col) {
+      b[row] -= At(row, col) * b[col];
+    }
+    b[row] /= At(row, row);
+  }
+  for (size_t row = size; row-- > 0;) {
+    const size_t col_end = std::min(size, row + kBandwidth + 1);
+    for (size_t col = row + 1; col < col_end; ++col) {
+      b[row] -= At(col, row) * b[col];
+    }
+    b[row] /= At(row, row);
+  }
+}
+
+bool ReferenceLineSqpSmoother::Solve(const std::vector<std::pair<double, double>> &ref_points,
+                                     const std::vector<double> &lower_bounds,
+                                     const std::vector<double> &upper_bounds,
+                                     double max_second_difference,
+                                     std::vector<std::pair<double, double>> *smoothed_points) {
+  if (smoothed_points == nullptr || ref_points.size() < 3 || lower_bounds.size() != ref_points.size() * 2
+      || upper_bounds.size() != ref_points.size() * 2) {
+    ROS_FATAL("[ReferenceLineSqpSmoother::Solve], invalid input");
+    return false;
+  }
+  ref_points_ = ref_points;
+  num_of_points_ = ref_points.size();
+  num_of_variables_ = num_of_points_ * 2;
+  max_second_difference_ = max_second_difference;
+  lower_bounds_.resize(num_of_variables_);
+  upper_bounds_.resize(num_of_variables_);
+  for (size_t i = 0; i < num_of_points_; ++i) {
+    lower_bounds_[2 * i] = lower_bounds[2 * i] - ref_points_[i].first;
+    lower_bounds_[2 * i + 1] = lower_bounds[2 * i + 1] - ref_points_[i].second;
+    upper_bounds_[2 * i] = upper_bounds[2 * i] - ref_points_[i].first;
+    upper_bounds_[2 * i + 1] = upper_bounds[2 * i + 1] - ref_points_[i].second;
+  }
+  for (size_t i = 0; i < num_of_variables_; ++i) {
+    if (lower_bounds_[i] > upper_bounds_[i]) {
+      ROS_WARN("[ReferenceLineSqpSmoother::Solve], the bounds of variable %lu are empty", i);
+      return false;
+    }
+  }
+  SetUpCost();
+
+  curvature_rows_.clear();
+  num_of_admm_iterations_ = 0;
+  std::vector<double> offsets(num_of_variables_, 0.0);
+  bool solved = false;
+  for (size_t iter = 0; iter < kMaxSqpIterations; ++iter) {
+    LinearizeCurvatureConstraints(offsets);
+    if (!SolveQp(&offsets)) {
+      ROS_WARN("[ReferenceLineSqpSmoother::Solve], the QP of iteration %lu is not solved", iter);
+      return false;
+    }
+    if (MaxCurvatureViolation(offsets) <= kCurvatureTolerance) {
+      solved = true;
+      break;
+    }
+  }
+  if (!solved) {
+    ROS_WARN("[ReferenceLineSqpSmoother::Solve], the curvature constraints are violated by %lf",
+             MaxCurvatureViolation(offsets));
+    return false;
+  }
+
+  smoothed_points->clear();
+  smoothed_points->reserve(num_of_points_);
+  for (size_t i = 0; i < num_of_points_; ++i) {
+    smoothed_points->emplace_back(ref_points_[i].first + offsets[2 * i], ref_points_[i].second + offsets[2 * i + 1]);
+  }
+  return true;
+}
+
+void ReferenceLineSqpSmoother::SetUpCost() {
+  cost_matrix_.Resize(num_of_variables_);
+  for (size_t coord = 0; coord < 2; ++coord) {
+    for (size_t i = 0; i < num_of_points_; ++i) {
+      cost_matrix_.At(2 * i + coord, 2 * i + coord) += 2.0 * ref_deviation_weight_;
+    }
+    for (size_t i = 0; i + 1 < num_of_points_; ++i) {
+      const size_t first = 2 * i + coord;
+      const size_t second = first + 2;
+      cost_matrix_.At(first, first) += 2.0 * length_weight_;
+      cost_matrix_.At(second, second) += 2.0 * length_weight_;
+      cost_matrix_.At(second, first) -= 2.0 * length_weight_;
+    }
+    constexpr double kSecondDifference[3] = {1.0, -2.0, 1.0};
+    for (size_t i = 0; i + 2 < num_of_points_; ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        for (size_t k = 0; k <= j; ++k) {
+          cost_matrix_.At(2 * (i + j) + coord, 2 * (i + k) + coord) +=
+              2.0 * heading_weight_ * kSecondDifference[j] * kSecondDifference[k];
+        }
+      }
+    }
+  }
+  // with d the offsets from the reference points r, q = (P - 2 * w_deviation * I) * r
+  std::vector<double> ref_values(num_of_variables_);
+  for (size_t i = 0; i < num_of_points_; ++i) {
+    ref_values[2 * i] = ref_points_[i].first;
+    ref_values[2 * i + 1] = ref_points_[i].second;
+  }
+  cost_matrix_.Multiply(ref_values, &cost_vector_);
+  for (size_t i = 0; i < num_of_variables_; ++i) {
+    cost_vector_[i] -= 2.0 * ref_deviation_weight_ * ref_values[i];
+  }
+}
+
+void ReferenceLineSqpSmoother::LinearizeCurvatureConstraints(const std::vector<double> &offsets) {
+  // |D * (r + d)| <= c is convex, linearized at the last iterate it is the tangent plane of the disc in the
+  // direction of the second difference, a valid cut for every later iterate as well
+  const double min_norm = curvature_rows_.empty() ? kNearActiveRatio * max_second_difference_
+                                                  : max_second_difference_ + kCurvatureTolerance;
+  for (size_t i = 0; i + 2 < num_of_points_; ++i) {
+    const double ref_dx = ref_points_[i].first - 2.0 * ref_points_[i + 1].first + ref_points_[i + 2].first;
+    const double ref_dy = ref_points_[i].second - 2.0 * ref_points_[i + 1].second + ref_points_[i + 2].second;
+    const double dx = ref_dx + offsets[2 * i] - 2.0 * offsets[2 * i + 2] + offsets[2 * i + 4];
+    const double dy = ref_dy + offsets[2 * i + 1] - 2.0 * offsets[2 * i + 3] + offsets[2 * i + 5];
+    const double norm = std::hypot(dx, dy);
+    if (norm < min_norm || norm < 1e-9) {
+      continue;
+    }
+    // u^T * D * (r + d) <= c, u the unit second difference
+    CurvatureRow row;
+    row.index = i;
+    row.row_x = dx / norm;
+    row.row_y = dy / norm;
+    row.upper = max_second_difference_ - (row.row_x * ref_dx + row.row_y * ref_dy);
+    curvature_rows_.push_back(row);
+  }
+}
+
+bool ReferenceLineSqpSmoother::SolveQp(std::vector<double> *offsets) {
+  // mostly the box constraints are not active, the unconstrained minimum is the solution. a fixed variable, its
+  // bounds equal, is always active
+  std::vector<int> active(num_of_variables_, 0);
+  for (size_t i = 0; i < num_of_variables_; ++i) {
+    if (IsFixed(i)) {
+      active[i] = 1;
+    }
+  }
+  std::vector<double> x = *offsets;
+  if (Polish(active, &x)) {
+    *offsets = x;
+    return true;
+  }
+
+  const size_t num_rows = num_of_variables_ + curvature_rows_.size();
+  std::vector<double> lower(num_rows, -kInf);
+  std::vector<double> upper(num_rows, kInf);
+  std::copy(lower_bounds_.begin(), lower_bounds_.end(), lower.begin());
+  std::copy(upper_bounds_.begin(), upper_bounds_.end(), upper.begin());
+  for (size_t k = 0; k < curvature_rows_.size(); ++k) {
+    upper[num_of_variables_ + k] = curvature_rows_[k].upper;
+  }
+  std::vector<double> z, y(num_rows, 0.0);
+  MultiplyConstraints(x, &z);
+  for (size_t i = 0; i < num_rows; ++i) {
+    z[i] = std::min(std::max(z[i], lower[i]), upper[i]);
+  }
+
+  double mean_diagonal = 0.0;
+  for (size_t i = 0; i < num_of_variables_; ++i) {
+    mean_diagonal += cost_matrix_.At(i, i);
+  }
+  mean_diagonal /= static_cast<double>(num_of_variables_);
+  double rho = 0.1 * mean_diagonal;
+  BandMatrix kkt_matrix;
+  SetUpKktMatrix(kAdmmSigma, rho, &kkt_matrix);
+  if (!kkt_matrix.Factorize()) {
+    return false;
+  }
+
+  std::vector<double> rhs, x_tilde, z_tilde, ax, px, aty;
+  bool converged = false;
+  for (size_t iter = 1; num_of_admm_iterations_ < kMaxAdmmIterations; ++iter) {
+    ++num_of_admm_iterations_;
+    std::vector<double> scaled_z(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+      scaled_z[i] = rho * z[i] - y[i];
+    }
+    MultiplyConstraintsTransposed(scaled_z, &rhs);
+    for (size_t i = 0; i < num_of_variables_; ++i) {
+      rhs[i] += kAdmmSigma * x[i] - cost_vector_[i];
+    }
+    x_tilde = rhs;
+    kkt_matrix.Solve(&x_tilde);
+    MultiplyConstraints(x_tilde, &z_tilde);
+    for (size_t i = 0; i < num_of_variables_; ++i) {
+      x[i] = kAdmmAlpha * x_tilde[i] + (1.0 - kAdmmAlpha) * x[i];
+    }
+    for (size_t i = 0; i < num_rows; ++i) {
+      const double z_relaxed = kAdmmAlpha * z_tilde[i] + (1.0 - kAdmmAlpha) * z[i];
+      const double z_next = std::min(std::max(z_relaxed + y[i] / rho, lower[i]), upper[i]);
+      y[i] += rho * (z_relaxed - z_next);
+      z[i] = z_next;
+    }
+    if (iter % kAdmmCheckInterval != 0) {
+      continue;
+    }
+    MultiplyConstraints(x, &ax);
+    cost_matrix_.Multiply(x, &px);
+    MultiplyConstraintsTransposed(y, &aty);
+    double primal_residual = 0.0;
+    for (size_t i = 0; i < num_rows; ++i) {
+      primal_residual = std::max(primal_residual, std::fabs(ax[i] - z[i]));
+    }
+    double dual_residual = 0.0;
+    for (size_t i = 0; i < num_of_variables_; ++i) {
+      dual_residual = std::max(dual_residual, std::fabs(px[i] + cost_vector_[i] + aty[i]));
+    }
+    const double primal_scale = std::max(InfNorm(ax), InfNorm(z));
+    const double dual_scale = std::max(std::max(InfNorm(px), InfNorm(aty)), InfNorm(cost_vector_));
+    if (primal_residual <= kAdmmAbsTolerance + kAdmmRelTolerance * primal_scale
+        && dual_residual <= kAdmmAbsTolerance + kAdmmRelTolerance * dual_scale) {
+      converged = true;
+      break;
+    }
+    if (iter % kAdmmAdaptInterval == 0) {
+      // balance the residuals as OSQP, refactorize only for a large change
+      const double ratio = (primal_residual / std::max(primal_scale, 1e-12))
+          / std::max(dual_residual / std::max(dual_scale, 1e-12), 1e-12);
+      const double new_rho = std::min(std::max(rho * std::sqrt(ratio), 1e-6 * mean_diagonal), 1e6 * mean_diagonal);
+      if (new_rho > 5.0 * rho || new_rho < 0.2 * rho) {
+        rho = new_rho;
+        SetUpKktMatrix(kAdmmSigma, rho, &kkt_matrix);
+        if (!kkt_matrix.Factorize()) {
+          return false;
+        }
+      }
+    }
+  }
+
+  // the exact solution on the active set, when only box constraints are active
+  bool has_active_curvature_row = false;
+  for (size_t k = 0; k < curvature_rows_.size(); ++k) {
+    has_active_curvature_row = has_active_curvature_row || y[num_of_variables_ + k] > kActiveDualTolerance;
+  }
+  if (!has_active_curvature_row) {
+    for (size_t i = 0; i < num_of_variables_; ++i) {
+      if (IsFixed(i)) {
+        continue;
+      }
+      if (y[i] > kActiveDualTolerance) {
+        active[i] = 1;
+      } else if (y[i] < -kActiveDualTolerance) {
+        active[i] = -1;
+      }
+    }
+    std::vector<double> polished = x;
+    if (Polish(active, &polished)) {
+      *offsets = polished;
+      return true;
+    }
+  }
+  if (!converged) {
+    return false;
+  }
+  // within the tolerance of the box, the fixed variables exactly at their values
+  for (size_t i = 0; i < num_of_variables_; ++i) {
+    x[i] = std::min(std::max(x[i], lower_bounds_[i]), upper_bounds_[i]);
+  }
+  *offsets = x;
+  return true;
+}
+
+bool ReferenceLineSqpSmoother::Polish(const std::vector<int> &active, std::vector<double> *offsets) {
+  BandMatrix matrix = cost_matrix_;
+  std::vector<double> x(num_of_variables_);
+  for (size_t i = 0; i < num_of_variables_; ++i) {
+    x[i] = -cost_vector_[i];
+  }
+  for (size_t j = 0; j < num_of_variables_; ++j) {
+    if (active[j] == 0) {
+      continue;
+    }
+    const double value = active[j] > 0 ? upper_bounds_[j] : lower_bounds_[j];
+    const size_t start = j > kBandwidth ? j - kBandwidth : 0;
+    const size_t end = std::min(num_of_variables_, j + kBandwidth + 1);
+    for (size_t i = start; i < end; ++i) {
+      if (i == j) {
+        continue;
+      }
+      double &entry = i > j ? matrix.At(i, j) : matrix.At(j, i);
+      if (active[i] == 0) {
+        x[i] -= entry * value;
+      }
+      entry = 0.0;
+    }
+    matrix.At(j, j) = 1.0;
+    x[j] = value;
+  }
+  if (!matrix.Factorize()) {
+    return false;
+  }
+  matrix.Solve(&x);
+  if (!IsFeasible(x, 1e-9)) {
+    return false;
+  }
+  // the multiplier of a box constraint at its upper bound is -(P * d + q) >= 0, at its lower bound <= 0
+  std::vector<double> gradient;
+  cost_matrix_.Multiply(x, &gradient);
+  const double tolerance = 1e-6 * std::max(1.0, InfNorm(cost_vector_));
+  for (size_t i = 0; i < num_of_variables_; ++i) {
+    if (IsFixed(i)) {
+      continue;
+    }
+    const double multiplier = -(gradient[i] + cost_vector_[i]);
+    if ((active[i] > 0 && multiplier < -tolerance) || (active[i] < 0 && multiplier > tolerance)) {
+      return false;
+    }
+  }
+  *offsets = x;
+  return true;
+}
+
+bool ReferenceLineSqpSmoother::IsFeasible(const std::vector<double> &offsets, double tolerance) const {
+  for (size_t i = 0; i < num_of_variables_; ++i) {
+    if (offsets[i] < lower_bounds_[i] - tolerance || offsets[i] > upper_bounds_[i] + tolerance) {
+      return false;
+    }
+  }
+  for (const auto &row : curvature_rows_) {
+    const size_t index = 2 * row.index;
+    const double value = row.row_x * (offsets[index] - 2.0 * offsets[index + 2] + offsets[index + 4])
+        + row.row_y * (offsets[index + 1] - 2.0 * offsets[index + 3] + offsets[index + 5]);
+    if (value > row.upper + tolerance) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double ReferenceLineSqpSmoother::MaxCurvatureViolation(const std::vector<double> &offsets) const {
+  double max_violation = 0.0;
+  for (size_t i = 0; i + 2 < num_of_points_; ++i) {
+    const double dx = ref_points_[i].first - 2.0 * ref_points_[i + 1].first + ref_points_[i + 2].first
+        + offsets[2 * i] - 2.0 * offsets[2 * i + 2] + offsets[2 * i + 4];
+    const double dy = ref_points_[i].second - 2.0 * ref_points_[i + 1].second + ref_points_[i + 2].second
+        + offsets[2 * i + 1] - 2.0 * offsets[2 * i + 3] + offsets[2 * i + 5];
+    max_violation = std::max(max_violation, std::hypot(dx, dy) - max_second_difference_);
+  }
+  return max_violation;
+}
+
+void ReferenceLineSqpSmoother::MultiplyConstraints(const std::vector<double> &x, std::vector<double> *y) const {
+  y->resize(num_of_variables_ + curvature_rows_.size());
+  std::copy(x.begin(), x.end(), y->begin());
+  for (size_t k = 0; k < curvature_rows_.size(); ++k) {
+    const auto &row = curvature_rows_[k];
+    const size_t index = 2 * row.index;
+    (*y)[num_of_variables_ + k] = row.row_x * (x[index] - 2.0 * x[index + 2] + x[index + 4])
+        + row.row_y * (x[index + 1] - 2.0 * x[index + 3] + x[index + 5]);
+  }
+}
+
+void ReferenceLineSqpSmoother::MultiplyConstraintsTransposed(const std::vector<double> &y,
+                                                             std::vector<double> *x) const {
+  x->assign(y.begin(), y.begin() + num_of_variables_);
+  for (size_t k = 0; k < curvature_rows_.size(); ++k) {
+    const auto &row = curvature_rows_[k];
+    const size_t index = 2 * row.index;
+    const double value = y[num_of_variables_ + k];
+    (*x)[index] += row.row_x * value;
+    (*x)[index + 1] += row.row_y * value;
+    (*x)[index + 2] -= 2.0 * row.row_x * value;
+    (*x)[index + 3] -= 2.0 * row.row_y * value;
+    (*x)[index + 4] += row.row_x * value;
+    (*x)[index + 5] += row.row_y * value;
+  }
+}
+
+void ReferenceLineSqpSmoother::SetUpKktMatrix(double sigma, double rho, BandMatrix *matrix) const {
+  *matrix = cost_matrix_;
+  for (size_t i = 0; i < num_of_variables_; ++i) {
+    matrix->At(i, i) += sigma + rho;
+  }
+  for (const auto &row : curvature_rows_) {
+    const size_t index = 2 * row.index;
+    const double values[6] = {row.row_x, row.row_y, -2.0 * row.row_x, -2.0 * row.row_y, row.row_x, row.row_y};
+    for (size_t j = 0; j < 6; ++j) {
+      for (size_t k = 0; k <= j; ++k) {
+        matrix->At(index + j, index + k) += rho * values[j] * values[k];
+      }
+    }
+  }
+}
+
+}